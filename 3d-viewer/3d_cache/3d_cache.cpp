@@ -28,6 +28,7 @@
 #include <fstream>
 #include <utility>
 #include <iterator>
+#include <vector>
 
 #include <wx/datetime.h>
 #include <wx/filename.h>
@@ -47,12 +48,26 @@
 #include "3d_filename_resolver.h"
 #include "3d_plugin_manager.h"
 #include "plugins/3dapi/ifsg_api.h"
+#include "openmp_mutex.h"
 
 
 #define MASK_3D_CACHE "3D_CACHE"
 
+#define HASHFILE_VERSION 1
+#define S3D_HASH_INDEX wxT( "3Dhashes.cfg" )
+
+// protects the cache list and map; it is only held while looking up or
+// adding an entry so that distinct models are loaded concurrently
 static wxCriticalSection lock3D_cache;
 
+// the plugins and the scene graph library keep process-wide state (node
+// name counters, LC_NUMERIC switches) so parsing and cache file I/O are
+// serialized; file hashing and resolution run concurrently
+static wxCriticalSection lock3D_plugins;
+
+// protects the file hash index
+static wxCriticalSection lock3D_hashes;
+
 static bool isSHA1Same( const unsigned char* shaA, const unsigned char* shaB )
 {
     for( int i = 0; i < 20; ++i )
@@ -72,6 +87,15 @@ static bool checkTag( const char* aTag, void* aPluginMgrPtr )
     return pp->CheckTag( aTag );
 }
 
+// checkTag() for the readers which do not hold lock3D_plugins: the plugin
+// loaders update their plugin information while loading models
+static bool checkTagLocked( const char* aTag, void* aPluginMgrPtr )
+{
+    wxCriticalSectionLocker lock( lock3D_plugins );
+
+    return checkTag( aTag, aPluginMgrPtr );
+}
+
 static const wxString sha1ToWXString( const unsigned char* aSHA1Sum )
 {
     unsigned char uc;
@@ -105,6 +129,32 @@ static const wxString sha1ToWXString( const unsigned char* aSHA1Sum )
     return wxString::FromUTF8Unchecked( sha1 );
 }
 
+static bool sha1FromString( const std::string& aString, unsigned char* aSHA1Sum )
+{
+    if( aString.size() != 40 )
+        return false;
+
+    for( int i = 0; i < 40; ++i )
+    {
+        char c = aString[i];
+        unsigned char nibble;
+
+        if( c >= '0' && c <= '9' )
+            nibble = c - '0';
+        else if( c >= 'a' && c <= 'f' )
+            nibble = c - 'a' + 10;
+        else
+            return false;
+
+        if( i & 1 )
+            aSHA1Sum[i >> 1] |= nibble;
+        else
+            aSHA1Sum[i >> 1] = nibble << 4;
+    }
+
+    return true;
+}
+
 
 class S3D_CACHE_ENTRY
 {
@@ -127,6 +177,11 @@ public:
     std::string   pluginInfo;   // PluginName:Version string
     SCENEGRAPH*   sceneData;
     S3DMODEL*     renderData;
+    bool          checked;      // true once the modification time and hash were read
+    bool          hashed;       // true if sha1sum holds the hash of the model file
+    bool          loaded;       // true once the scene data was loaded
+    MutexType     entryLock;    // held while the entry is loaded or refreshed, so
+                                // concurrent requests share a single load
 };
 
 
@@ -134,6 +189,9 @@ S3D_CACHE_ENTRY::S3D_CACHE_ENTRY()
 {
     sceneData = NULL;
     renderData = NULL;
+    checked = false;
+    hashed = false;
+    loaded = false;
     memset( sha1sum, 0, 20 );
 }
 
@@ -165,6 +223,7 @@ void S3D_CACHE_ENTRY::SetSHA1( const unsigned char* aSHA1Sum )
     }
 
     memcpy( sha1sum, aSHA1Sum, 20 );
+    m_CacheBaseName.clear();
     return;
 }
 
@@ -181,6 +240,8 @@ const wxString S3D_CACHE_ENTRY::GetCacheBaseName( void )
 S3D_CACHE::S3D_CACHE()
 {
     m_DirtyCache = false;
+    m_HashIndexLoaded = false;
+    m_HashIndexDirty = false;
     m_FNResolver = new S3D_FILENAME_RESOLVER;
     m_Plugins = new S3D_PLUGIN_MANAGER;
 
@@ -201,14 +262,11 @@ S3D_CACHE::~S3D_CACHE()
 }
 
 
-SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr )
+S3D_CACHE_ENTRY* S3D_CACHE::getEntry( const wxString& aModelFile, wxString& aFullPath )
 {
-    if( aCachePtr )
-        *aCachePtr = NULL;
+    aFullPath = m_FNResolver->ResolvePath( aModelFile );
 
-    wxString full3Dpath = m_FNResolver->ResolvePath( aModelFile );
-
-    if( full3Dpath.empty() )
+    if( aFullPath.empty() )
     {
         // the model cannot be found; we cannot proceed
         wxLogTrace( MASK_3D_CACHE, " * [3D model] could not find model '%s'\n",
@@ -216,148 +274,132 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
         return NULL;
     }
 
-    // check cache if file is already loaded
     wxCriticalSectionLocker lock( lock3D_cache );
     std::map< wxString, S3D_CACHE_ENTRY*, S3D::rsort_wxString >::iterator mi;
-    mi = m_CacheMap.find( full3Dpath );
+    mi = m_CacheMap.find( aFullPath );
 
     if( mi != m_CacheMap.end() )
-    {
-        wxFileName fname( full3Dpath );
+        return mi->second;
 
-        if( fname.FileExists() )    // Only check if file exists. If not, it will
-        {                           // use the same model in cache.
-            bool reload = false;
-            wxDateTime fmdate = fname.GetModificationTime();
+    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
+    m_CacheList.push_back( ep );
+    m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >( aFullPath, ep ) );
 
-            if( fmdate != mi->second->modTime )
-            {
-                unsigned char hashSum[20];
-                getSHA1( full3Dpath, hashSum );
-                mi->second->modTime = fmdate;
-
-                if( !isSHA1Same( hashSum, mi->second->sha1sum ) )
-                {
-                    mi->second->SetSHA1( hashSum );
-                    reload = true;
-                }
-            }
+    return ep;
+}
 
-            if( reload )
-            {
-                if( NULL != mi->second->sceneData )
-                {
-                    S3D::DestroyNode( mi->second->sceneData );
-                    mi->second->sceneData = NULL;
-                }
 
-                if( NULL != mi->second->renderData )
-                    S3D::Destroy3DModel( &mi->second->renderData );
+void S3D_CACHE::checkEntry( const wxString& aFullPath, S3D_CACHE_ENTRY* aCacheItem )
+{
+    wxFileName fname( aFullPath );
+    unsigned char hashSum[20];
 
-                mi->second->sceneData = m_Plugins->Load3DModel( full3Dpath, mi->second->pluginInfo );
-            }
-        }
+    if( !aCacheItem->checked )
+    {
+        aCacheItem->checked = true;
+        aCacheItem->modTime = fname.GetModificationTime();
 
-        if( NULL != aCachePtr )
-            *aCachePtr = mi->second;
+        // without a hash digest (for example, on access issues) the
+        // entry is kept without data to prevent further attempts at
+        // loading the file
+        if( getFileHash( aFullPath, hashSum ) )
+        {
+            aCacheItem->SetSHA1( hashSum );
+            aCacheItem->hashed = true;
+        }
 
-        return mi->second->sceneData;
+        return;
     }
 
-    // a cache item does not exist; search the Filename->Cachename map
-    return checkCache( full3Dpath, aCachePtr );
-}
+    // Only check if file exists. If not, it will use the same model in cache.
+    if( !fname.FileExists() )
+        return;
 
+    wxDateTime fmdate = fname.GetModificationTime();
 
-SCENEGRAPH* S3D_CACHE::Load( const wxString& aModelFile )
-{
-    return load( aModelFile );
+    if( fmdate == aCacheItem->modTime )
+        return;
+
+    aCacheItem->modTime = fmdate;
+
+    if( !getFileHash( aFullPath, hashSum )
+        || ( aCacheItem->hashed && isSHA1Same( hashSum, aCacheItem->sha1sum ) ) )
+        return;
+
+    // the file contents changed: drop the data, it will be loaded again
+    aCacheItem->SetSHA1( hashSum );
+    aCacheItem->hashed = true;
+    aCacheItem->loaded = false;
+
+    wxCriticalSectionLocker pluginLock( lock3D_plugins );
+
+    if( NULL != aCacheItem->sceneData )
+    {
+        S3D::DestroyNode( aCacheItem->sceneData );
+        aCacheItem->sceneData = NULL;
+    }
+
+    if( NULL != aCacheItem->renderData )
+        S3D::Destroy3DModel( &aCacheItem->renderData );
 }
 
 
-SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr )
 {
     if( aCachePtr )
         *aCachePtr = NULL;
 
-    unsigned char sha1sum[20];
+    wxString full3Dpath;
+    S3D_CACHE_ENTRY* ep = getEntry( aModelFile, full3Dpath );
 
-    if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
-    {
-        // just in case we can't get a hash digest (for example, on access issues)
-        // or we do not have a configured cache file directory, we create an
-        // entry to prevent further attempts at loading the file
-        S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-        m_CacheList.push_back( ep );
-        wxFileName fname( aFileName );
-        ep->modTime = fname.GetModificationTime();
+    if( NULL == ep )
+        return NULL;
 
-        if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-            ( aFileName, ep ) ).second == false )
-        {
-            #ifdef DEBUG
-            do {
-                std::ostringstream ostr;
-                ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-                ostr << " * [BUG] duplicate entry in map file; key = '";
-                ostr << aFileName.ToUTF8() << "'";
-                wxLogTrace( MASK_3D_CACHE, "%s\n", ostr.str().c_str() );
-            } while( 0 );
-            #endif
-
-            m_CacheList.pop_back();
-            delete ep;
-        }
-        else
-        {
-            if( aCachePtr )
-                *aCachePtr = ep;
+    // a concurrent request for the same model waits here until it is loaded
+    ScopedLock lock( ep->entryLock );
 
-        }
+    checkEntry( full3Dpath, ep );
 
-        return NULL;
+    if( !ep->loaded )
+    {
+        checkCache( full3Dpath, ep );
+        ep->loaded = true;
     }
 
-    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-    m_CacheList.push_back( ep );
-    wxFileName fname( aFileName );
-    ep->modTime = fname.GetModificationTime();
+    if( NULL != aCachePtr )
+        *aCachePtr = ep;
 
-    if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-                               ( aFileName, ep ) ).second == false )
-    {
-        #ifdef DEBUG
-        do {
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] duplicate entry in map file; key = '";
-            ostr << aFileName.ToUTF8() << "'";
-            wxLogTrace( MASK_3D_CACHE, "%s\n", ostr.str().c_str() );
-        } while( 0 );
-        #endif
+    return ep->sceneData;
+}
 
-        m_CacheList.pop_back();
-        delete ep;
-        return NULL;
-    }
 
-    if( aCachePtr )
-        *aCachePtr = ep;
+SCENEGRAPH* S3D_CACHE::Load( const wxString& aModelFile )
+{
+    return load( aModelFile );
+}
+
 
-    ep->SetSHA1( sha1sum );
+SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
+{
+    // just in case we can't get a hash digest or we do not have a configured
+    // cache file directory, the entry is kept without scene data
+    if( !aCacheItem->hashed || m_CacheDir.empty() )
+        return NULL;
 
-    wxString bname = ep->GetCacheBaseName();
+    wxString bname = aCacheItem->GetCacheBaseName();
     wxString cachename = m_CacheDir + bname + wxT( ".3dc" );
 
-    if( wxFileName::FileExists( cachename ) && loadCacheData( ep ) )
-        return ep->sceneData;
+    wxCriticalSectionLocker lock( lock3D_plugins );
 
-    ep->sceneData = m_Plugins->Load3DModel( aFileName, ep->pluginInfo );
+    if( wxFileName::FileExists( cachename ) && loadCacheData( aCacheItem ) )
+        return aCacheItem->sceneData;
 
-    if( NULL != ep->sceneData )
-        saveCacheData( ep );
+    aCacheItem->sceneData = m_Plugins->Load3DModel( aFileName, aCacheItem->pluginInfo );
 
-    return ep->sceneData;
+    if( NULL != aCacheItem->sceneData )
+        saveCacheData( aCacheItem );
+
+    return aCacheItem->sceneData;
 }
 
 
@@ -425,6 +467,185 @@ bool S3D_CACHE::getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum )
 }
 
 
+bool S3D_CACHE::getFileHash( const wxString& aFileName, unsigned char* aSHA1Sum )
+{
+    if( aFileName.empty() || NULL == aSHA1Sum )
+        return getSHA1( aFileName, aSHA1Sum );
+
+    wxFileName fname( aFileName );
+    wxULongLong fsize = fname.GetSize();
+    wxDateTime fmdate = fname.GetModificationTime();
+
+    if( fsize == wxInvalidSize || !fmdate.IsValid() )
+        return getSHA1( aFileName, aSHA1Sum );
+
+    S3D_FILE_HASH item;
+    item.size = fsize.GetValue();
+    item.modTime = fmdate.GetValue().GetValue();
+
+    {
+        wxCriticalSectionLocker lock( lock3D_hashes );
+
+        if( !m_HashIndexLoaded )
+            loadHashIndex();
+
+        std::map< wxString, S3D_FILE_HASH >::const_iterator mi = m_HashIndex.find( aFileName );
+
+        if( mi != m_HashIndex.end() && mi->second.size == item.size
+            && mi->second.modTime == item.modTime )
+        {
+            memcpy( aSHA1Sum, mi->second.sha1sum, 20 );
+            return true;
+        }
+    }
+
+    // the file is new or was changed: hash its contents
+    if( !getSHA1( aFileName, item.sha1sum ) )
+        return false;
+
+    memcpy( aSHA1Sum, item.sha1sum, 20 );
+
+    wxCriticalSectionLocker lock( lock3D_hashes );
+    m_HashIndex[aFileName] = item;
+    m_HashIndexDirty = true;
+
+    return true;
+}
+
+
+bool S3D_CACHE::loadHashIndex( void )
+{
+    m_HashIndexLoaded = true;
+
+    if( m_ConfigDir.empty() )
+        return false;
+
+    wxFileName cfgpath( m_ConfigDir, S3D_HASH_INDEX );
+    wxString cfgname = cfgpath.GetFullPath();
+
+    if( !wxFileName::FileExists( cfgname ) )
+        return false;
+
+    std::ifstream cfgFile;
+    cfgFile.open( cfgname.ToUTF8() );
+
+    if( !cfgFile.is_open() )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] could not open hash index '%s'\n",
+            cfgname.GetData() );
+        return false;
+    }
+
+    std::string cfgLine;
+    int lineno = 0;
+
+    // each line holds: size modTime sha1 path
+    while( std::getline( cfgFile, cfgLine ) )
+    {
+        ++lineno;
+
+        if( 1 == lineno )
+        {
+            int vnum = 0;
+
+            if( cfgLine.compare( 0, 2, "#V" ) == 0 && cfgLine.size() > 2 )
+            {
+                std::istringstream istr( cfgLine.substr( 2 ) );
+                istr >> vnum;
+            }
+
+            // an index written by another version is rebuilt
+            if( vnum != HASHFILE_VERSION )
+                break;
+
+            continue;
+        }
+
+        std::istringstream istr( cfgLine );
+        S3D_FILE_HASH item;
+        std::string sha1;
+        std::string path;
+
+        if( !( istr >> item.size >> item.modTime >> sha1 ) )
+            continue;
+
+        istr.get();     // skip the separator
+
+        if( !std::getline( istr, path ) || path.empty()
+            || !sha1FromString( sha1, item.sha1sum ) )
+            continue;
+
+        m_HashIndex[wxString::FromUTF8Unchecked( path.c_str() )] = item;
+    }
+
+    cfgFile.close();
+
+    return true;
+}
+
+
+bool S3D_CACHE::saveHashIndex( void )
+{
+    if( !m_HashIndexDirty || m_ConfigDir.empty() )
+        return false;
+
+    wxFileName cfgpath( m_ConfigDir, S3D_HASH_INDEX );
+    wxString cfgname = cfgpath.GetFullPath();
+
+    // the index is written to a new file which then replaces the old one, so a
+    // failed write or another KiCad instance never leaves a partial index
+    wxString tmpname = wxFileName::CreateTempFileName( cfgname );
+    std::ofstream cfgFile;
+
+    if( !tmpname.empty() )
+        cfgFile.open( tmpname.ToUTF8(), std::ios_base::trunc );
+
+    if( !cfgFile.is_open() )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] could not write hash index '%s'\n",
+            cfgname.GetData() );
+
+        if( !tmpname.empty() )
+            wxRemoveFile( tmpname );
+
+        return false;
+    }
+
+    cfgFile << "#V" << HASHFILE_VERSION << "\n";
+
+    std::map< wxString, S3D_FILE_HASH >::const_iterator sI = m_HashIndex.begin();
+    std::map< wxString, S3D_FILE_HASH >::const_iterator eI = m_HashIndex.end();
+
+    while( sI != eI )
+    {
+        // files which no longer exist are dropped from the index
+        if( wxFileName::FileExists( sI->first ) )
+        {
+            cfgFile << sI->second.size << " " << sI->second.modTime << " ";
+            cfgFile << sha1ToWXString( sI->second.sha1sum ).ToUTF8() << " ";
+            cfgFile << sI->first.ToUTF8() << "\n";
+        }
+
+        ++sI;
+    }
+
+    bool bad = !cfgFile.good();
+    cfgFile.close();
+
+    if( bad || !wxRenameFile( tmpname, cfgname, true ) )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] could not write hash index '%s'\n",
+            cfgname.GetData() );
+        wxRemoveFile( tmpname );
+        return false;
+    }
+
+    m_HashIndexDirty = false;
+
+    return true;
+}
+
+
 bool S3D_CACHE::loadCacheData( S3D_CACHE_ENTRY* aCacheItem )
 {
     wxString bname = aCacheItem->GetCacheBaseName();
@@ -536,6 +757,34 @@ bool S3D_CACHE::saveCacheData( S3D_CACHE_ENTRY* aCacheItem )
 }
 
 
+bool S3D_CACHE::loadModelCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( !aCacheItem->hashed || m_CacheDir.empty() )
+        return false;
+
+    wxString fname = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dm" );
+
+    if( !wxFileName::FileExists( fname ) )
+        return false;
+
+    aCacheItem->renderData = S3D::ReadModelCache( fname.ToUTF8(), m_Plugins, checkTagLocked );
+
+    return NULL != aCacheItem->renderData;
+}
+
+
+bool S3D_CACHE::saveModelCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( NULL == aCacheItem->renderData || !aCacheItem->hashed || m_CacheDir.empty() )
+        return false;
+
+    wxString fname = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dm" );
+
+    return S3D::WriteModelCache( fname.ToUTF8(), aCacheItem->renderData,
+        aCacheItem->pluginInfo.c_str() );
+}
+
+
 bool S3D_CACHE::Set3DConfigDir( const wxString& aConfigDir )
 {
     if( !m_ConfigDir.empty() )
@@ -700,6 +949,7 @@ bool S3D_CACHE::SetProjectDir( const wxString& aProjDir )
 
     if( m_FNResolver->SetProjectDir( aProjDir, &hasChanged ) && hasChanged )
     {
+        wxCriticalSectionLocker lock( lock3D_cache );
         m_CacheMap.clear();
 
         std::list< S3D_CACHE_ENTRY* >::iterator sL = m_CacheList.begin();
@@ -747,6 +997,12 @@ std::list< wxString > const* S3D_CACHE::GetFileFilters( void ) const
 
 void S3D_CACHE::FlushCache( bool closePlugins )
 {
+    {
+        wxCriticalSectionLocker lock( lock3D_hashes );
+        saveHashIndex();
+    }
+
+    wxCriticalSectionLocker lock( lock3D_cache );
     std::list< S3D_CACHE_ENTRY* >::iterator sCL = m_CacheList.begin();
     std::list< S3D_CACHE_ENTRY* >::iterator eCL = m_CacheList.end();
 
@@ -777,56 +1033,56 @@ void S3D_CACHE::ClosePlugins( void )
 
 S3DMODEL* S3D_CACHE::GetModel( const wxString& aModelFileName )
 {
-    S3D_CACHE_ENTRY* cp = NULL;
-    SCENEGRAPH* sp = load( aModelFileName, &cp );
+    wxString full3Dpath;
+    S3D_CACHE_ENTRY* cp = getEntry( aModelFileName, full3Dpath );
 
-    if( !sp )
+    if( NULL == cp )
         return NULL;
 
-    if( !cp )
-    {
-        #ifdef DEBUG
-        do {
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] model loaded with no associated S3D_CACHE_ENTRY";
-            wxLogTrace( MASK_3D_CACHE, "%s\n", ostr.str().c_str() );
-        } while( 0 );
-        #endif
+    ScopedLock lock( cp->entryLock );
 
-        return NULL;
-    }
+    checkEntry( full3Dpath, cp );
 
     if( cp->renderData )
         return cp->renderData;
 
-    S3DMODEL* mp = S3D::GetModel( sp );
-    cp->renderData = mp;
+    // the render data of a model seen before is read from its model cache
+    // file, without building the scene graph
+    if( loadModelCacheData( cp ) )
+        return cp->renderData;
+
+    if( !cp->loaded )
+    {
+        checkCache( full3Dpath, cp );
+        cp->loaded = true;
+    }
+
+    if( NULL == cp->sceneData )
+        return NULL;
+
+    {
+        wxCriticalSectionLocker pluginLock( lock3D_plugins );
+        cp->renderData = S3D::GetModel( cp->sceneData );
+    }
 
-    return mp;
+    saveModelCacheData( cp );
+
+    return cp->renderData;
 }
 
 
 wxString S3D_CACHE::GetModelHash( const wxString& aModelFileName )
 {
-    wxString full3Dpath = m_FNResolver->ResolvePath( aModelFileName );
+    // the cache item is created if it does not exist; the hash does not
+    // require the model to be loaded
+    wxString full3Dpath;
+    S3D_CACHE_ENTRY* cp = getEntry( aModelFileName, full3Dpath );
 
-    if( full3Dpath.empty() || !wxFileName::FileExists( full3Dpath ) )
+    if( NULL == cp || !wxFileName::FileExists( full3Dpath ) )
         return wxEmptyString;
 
-    // check cache if file is already loaded
-    std::map< wxString, S3D_CACHE_ENTRY*, S3D::rsort_wxString >::iterator mi;
-    mi = m_CacheMap.find( full3Dpath );
-
-    if( mi != m_CacheMap.end() )
-        return mi->second->GetCacheBaseName();
+    ScopedLock lock( cp->entryLock );
+    checkEntry( full3Dpath, cp );
 
-    // a cache item does not exist; search the Filename->Cachename map
-    S3D_CACHE_ENTRY* cp = NULL;
-    checkCache( full3Dpath, &cp );
-
-    if( NULL != cp )
-        return cp->GetCacheBaseName();
-
-    return wxEmptyString;
+    return cp->GetCacheBaseName();
 }
@@ -47,6 +47,20 @@ class  S3D_PLUGIN_MANAGER;
 struct S3D_INFO;
 
 
+/**
+ * Struct S3D_FILE_HASH
+ * is an item of the model file hash index: the SHA1 hash of a model file
+ * is reused as long as the size and the modification time of the file are
+ * unchanged
+ */
+struct S3D_FILE_HASH
+{
+    long long     size;         // file size in bytes
+    long long     modTime;      // file modification time (ms since the Epoch)
+    unsigned char sha1sum[20];
+};
+
+
 class S3D_CACHE
 {
 private:
@@ -74,17 +88,46 @@ private:
     /// current KiCad project dir
     wxString m_ProjDir;
 
+    /// model file hashes, indexed by full file path
+    std::map< wxString, S3D_FILE_HASH > m_HashIndex;
+
+    /// set true once the hash index file was read
+    bool m_HashIndexLoaded;
+
+    /// set true if the hash index file needs to be written
+    bool m_HashIndexDirty;
+
+    /**
+     * Function getEntry
+     * resolves a model file name and retrieves its cache entry; the entry
+     * is created if it does not already exist
+     *
+     * @param aModelFile [in] is the partial or full path to the model
+     * @param aFullPath [out] is the resolved path to the model
+     * @return the cache entry, or NULL if the model cannot be found
+     */
+    S3D_CACHE_ENTRY* getEntry( const wxString& aModelFile, wxString& aFullPath );
+
+    /**
+     * Function checkEntry
+     * reads the hash of a new cache entry, or drops the data of an entry
+     * whose file was changed since it was loaded
+     *
+     * @param aFullPath [in] is the full path to the model
+     * @param aCacheItem [in,out] is the cache entry for the model
+     */
+    void checkEntry( const wxString& aFullPath, S3D_CACHE_ENTRY* aCacheItem );
+
     /**
      * Function checkCache
-     * searches the cache list for the given filename and retrieves
-     * the cache data; a cache entry is created if one does not
-     * already exist
+     * loads the scene data of a cache entry, retrieved from the cache file
+     * directory if possible, otherwise from the plugins
      *
-     * @param aFileName [in] is a partial or full file path
-     * @param [out] if not NULL will hold a pointer to the cache entry for the model
+     * @param aFileName [in] is a full file path
+     * @param aCacheItem [in,out] is the new cache entry for the model
      * @return on success a pointer to a SCENEGRAPH, otherwise NULL
      */
-    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
 
     /**
      * Function getSHA1
@@ -96,13 +139,39 @@ private:
      */
     bool getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum );
 
+    /**
+     * Function getFileHash
+     * retrieves the SHA1 hash of the given file from the hash index; the
+     * file is only read and hashed if its size or modification time do not
+     * match the indexed ones
+     *
+     * @param aFileName [in] is a fully qualified path to the model file
+     * @param aSHA1Sum [out] is a 20-byte character array to hold the SHA1 hash
+     * @return true if the sha1 hash was retrieved or calculated; otherwise false
+     */
+    bool getFileHash( const wxString& aFileName, unsigned char* aSHA1Sum );
+
+    // load the hash index from the 3D configuration directory
+    bool loadHashIndex( void );
+
+    // save the hash index to the 3D configuration directory
+    bool saveHashIndex( void );
+
     // load scene data from a cache file
     bool loadCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
     // save scene data to a cache file
     bool saveCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
-    // the real load function (can supply a cache entry pointer to member functions)
+    // load render data from a model cache file
+    bool loadModelCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // save render data to a model cache file
+    bool saveModelCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // the real load function (can supply a cache entry pointer to member functions);
+    // distinct models may be loaded concurrently, and concurrent requests for the
+    // same model wait for a single load
     SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL );
 
 public:
@@ -179,7 +248,8 @@ public:
 
     /**
      * Function FlushCache
-     * frees all data in the cache and by default closes all plugins
+     * frees all data in the cache and by default closes all plugins;
+     * it must not be called while models are being loaded
      */
     void FlushCache( bool closePlugins = true );
 
@@ -24,6 +24,17 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include <wx/filename.h>
 #include <wx/log.h>
 #include "plugins/3dapi/ifsg_api.h"
@@ -42,6 +53,147 @@ static char BadNode[] = " * [BUG] NULL pointer passed for aNode\n";
 // version format of the cache file
 #define SG_VERSION_TAG "VERSION:2"
 
+// identifier and version of the flat model cache file
+#define SG_MODEL_CACHE_MAGIC "KICAD3DM"
+#define SG_MODEL_CACHE_VERSION 1
+
+// alignment of the blocks in the model cache file
+#define SG_MODEL_CACHE_ALIGN 16
+
+
+/**
+ * Struct MODEL_CACHE_HEADER
+ * starts a model cache file; it is followed by the plugin info string,
+ * the SMATERIAL array, the MODEL_CACHE_MESH table and the mesh arrays,
+ * each block starting at a multiple of SG_MODEL_CACHE_ALIGN
+ */
+struct MODEL_CACHE_HEADER
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;         // 0x01020304 in the byte order of the writer
+    uint32_t materialSize;      // sizeof( SMATERIAL ) of the writer
+    uint32_t materialsCount;
+    uint32_t meshesCount;
+    uint32_t pluginInfoSize;
+    uint64_t fileSize;
+};
+
+
+/**
+ * Struct MODEL_CACHE_MESH
+ * describes a SMESH in a model cache file; arrays are given by their
+ * offset from the start of the file, 0 for an absent array
+ */
+struct MODEL_CACHE_MESH
+{
+    uint32_t vertexSize;
+    uint32_t faceIdxSize;
+    uint32_t materialIdx;
+    uint32_t reserved;
+    uint64_t positions;
+    uint64_t normals;
+    uint64_t texcoords;
+    uint64_t colors;
+    uint64_t faceIdx;
+};
+
+
+static uint64_t alignCacheOffset( uint64_t aOffset )
+{
+    return ( aOffset + SG_MODEL_CACHE_ALIGN - 1 ) & ~(uint64_t)( SG_MODEL_CACHE_ALIGN - 1 );
+}
+
+
+// writes a block of the model cache file at the given offset, padding the
+// file up to it; aWritten is the current end of the file
+static void writeCacheBlock( std::ofstream& aFile, uint64_t& aWritten, uint64_t aOffset,
+                             const void* aData, uint64_t aSize )
+{
+    static const char padding[SG_MODEL_CACHE_ALIGN] = { 0 };
+
+    aFile.write( padding, (std::streamsize)( aOffset - aWritten ) );
+
+    if( aSize )
+        aFile.write( (const char*) aData, (std::streamsize) aSize );
+
+    aWritten = aOffset + aSize;
+}
+
+
+/**
+ * Class MAPPED_CACHE_FILE
+ * gives read only access to the contents of a whole file; the file is
+ * mapped in memory where supported, otherwise it is read in a buffer
+ */
+class MAPPED_CACHE_FILE
+{
+public:
+    MAPPED_CACHE_FILE( const char* aFileName ) : m_data( NULL ), m_size( 0 )
+    {
+#ifndef _WIN32
+        int fd = open( aFileName, O_RDONLY );
+
+        if( fd < 0 )
+            return;
+
+        struct stat st;
+
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            void* addr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+            if( addr != MAP_FAILED )
+            {
+                m_data = (const char*) addr;
+                m_size = st.st_size;
+            }
+        }
+
+        close( fd );
+#else
+        std::ifstream file( aFileName, std::ios_base::in | std::ios_base::binary );
+
+        if( !file.is_open() )
+            return;
+
+        file.seekg( 0, std::ios_base::end );
+        std::streamoff size = file.tellg();
+        file.seekg( 0, std::ios_base::beg );
+
+        if( size <= 0 )
+            return;
+
+        m_buffer.resize( (size_t) size );
+
+        if( file.read( &m_buffer[0], size ) )
+        {
+            m_data = &m_buffer[0];
+            m_size = m_buffer.size();
+        }
+#endif
+    }
+
+    ~MAPPED_CACHE_FILE()
+    {
+#ifndef _WIN32
+        if( m_data )
+            munmap( (void*) m_data, m_size );
+#endif
+    }
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+
+#ifdef _WIN32
+    std::vector<char> m_buffer;
+#endif
+};
+
 
 static void formatMaterial( SMATERIAL& mat, SGAPPEARANCE const* app )
 {
@@ -497,6 +649,308 @@ SGNODE* S3D::ReadCache( const char* aFileName, void* aPluginMgr,
 }
 
 
+bool S3D::WriteModelCache( const char* aFileName, const S3DMODEL* aModel,
+    const char* aPluginInfo )
+{
+    if( NULL == aFileName || aFileName[0] == 0 || NULL == aModel )
+        return false;
+
+    wxString ofile = wxString::FromUTF8Unchecked( aFileName );
+
+    if( wxFileName::Exists( ofile ) && !wxFileName::FileExists( ofile ) )
+    {
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        wxString errmsg = _( "specified path is a directory" );
+        ostr << " * [INFO] " << errmsg.ToUTF8() << " '";
+        ostr << aFileName << "'";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        return false;
+    }
+
+    std::string pluginInfo = "INTERNAL:0.0.0.0";
+
+    if( NULL != aPluginInfo && aPluginInfo[0] != 0 )
+        pluginInfo = aPluginInfo;
+
+    // lay out the file: all the offsets are known before writing
+    MODEL_CACHE_HEADER header;
+    memset( &header, 0, sizeof( header ) );
+    memcpy( header.magic, SG_MODEL_CACHE_MAGIC, sizeof( header.magic ) );
+    header.version = SG_MODEL_CACHE_VERSION;
+    header.byteOrder = 0x01020304;
+    header.materialSize = sizeof( SMATERIAL );
+    header.materialsCount = aModel->m_MaterialsSize;
+    header.meshesCount = aModel->m_MeshesSize;
+    header.pluginInfoSize = pluginInfo.size();
+
+    uint64_t offset = alignCacheOffset( sizeof( header ) + pluginInfo.size() );
+    uint64_t materialsOffset = offset;
+    offset = alignCacheOffset( offset + (uint64_t) aModel->m_MaterialsSize * sizeof( SMATERIAL ) );
+    uint64_t meshesOffset = offset;
+    offset = alignCacheOffset( offset + (uint64_t) aModel->m_MeshesSize * sizeof( MODEL_CACHE_MESH ) );
+
+    std::vector< MODEL_CACHE_MESH > meshes( aModel->m_MeshesSize );
+
+    for( unsigned int i = 0; i < aModel->m_MeshesSize; ++i )
+    {
+        const SMESH& mesh = aModel->m_Meshes[i];
+        MODEL_CACHE_MESH& rec = meshes[i];
+
+        memset( &rec, 0, sizeof( rec ) );
+        rec.vertexSize = mesh.m_VertexSize;
+        rec.faceIdxSize = mesh.m_FaceIdxSize;
+        rec.materialIdx = mesh.m_MaterialIdx;
+
+        if( mesh.m_Positions )
+        {
+            rec.positions = offset;
+            offset = alignCacheOffset( offset + (uint64_t) mesh.m_VertexSize * sizeof( SFVEC3F ) );
+        }
+
+        if( mesh.m_Normals )
+        {
+            rec.normals = offset;
+            offset = alignCacheOffset( offset + (uint64_t) mesh.m_VertexSize * sizeof( SFVEC3F ) );
+        }
+
+        if( mesh.m_Texcoords )
+        {
+            rec.texcoords = offset;
+            offset = alignCacheOffset( offset + (uint64_t) mesh.m_VertexSize * sizeof( SFVEC2F ) );
+        }
+
+        if( mesh.m_Color )
+        {
+            rec.colors = offset;
+            offset = alignCacheOffset( offset + (uint64_t) mesh.m_VertexSize * sizeof( SFVEC3F ) );
+        }
+
+        if( mesh.m_FaceIdx )
+        {
+            rec.faceIdx = offset;
+            offset = alignCacheOffset( offset +
+                                       (uint64_t) mesh.m_FaceIdxSize * sizeof( unsigned int ) );
+        }
+    }
+
+    header.fileSize = offset;
+
+    // the file may be mapped by ReadModelCache() in another thread or process, and
+    // truncating a mapped file breaks the reader: a new file is written next to it,
+    // then renamed over it
+    wxString tmpfile = wxFileName::CreateTempFileName( ofile );
+    std::ofstream output;
+
+    if( !tmpfile.empty() )
+        output.open( tmpfile.ToUTF8(), std::ios_base::out | std::ios_base::trunc
+                                           | std::ios_base::binary );
+
+    if( !output.is_open() )
+    {
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        wxString errmsg = _( "failed to open file" );
+        ostr << " * [INFO] " << errmsg.ToUTF8() << " '" << aFileName << "'";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+
+        if( !tmpfile.empty() )
+            wxRemoveFile( tmpfile );
+
+        return false;
+    }
+
+    uint64_t written = 0;
+
+    writeCacheBlock( output, written, 0, &header, sizeof( header ) );
+    writeCacheBlock( output, written, written, pluginInfo.data(), pluginInfo.size() );
+    writeCacheBlock( output, written, materialsOffset, aModel->m_Materials,
+                     (uint64_t) aModel->m_MaterialsSize * sizeof( SMATERIAL ) );
+
+    if( !meshes.empty() )
+        writeCacheBlock( output, written, meshesOffset, &meshes[0],
+                         meshes.size() * sizeof( MODEL_CACHE_MESH ) );
+
+    for( unsigned int i = 0; i < aModel->m_MeshesSize && output.good(); ++i )
+    {
+        const SMESH& mesh = aModel->m_Meshes[i];
+        const MODEL_CACHE_MESH& rec = meshes[i];
+
+        if( rec.positions )
+            writeCacheBlock( output, written, rec.positions, mesh.m_Positions,
+                             (uint64_t) rec.vertexSize * sizeof( SFVEC3F ) );
+
+        if( rec.normals )
+            writeCacheBlock( output, written, rec.normals, mesh.m_Normals,
+                             (uint64_t) rec.vertexSize * sizeof( SFVEC3F ) );
+
+        if( rec.texcoords )
+            writeCacheBlock( output, written, rec.texcoords, mesh.m_Texcoords,
+                             (uint64_t) rec.vertexSize * sizeof( SFVEC2F ) );
+
+        if( rec.colors )
+            writeCacheBlock( output, written, rec.colors, mesh.m_Color,
+                             (uint64_t) rec.vertexSize * sizeof( SFVEC3F ) );
+
+        if( rec.faceIdx )
+            writeCacheBlock( output, written, rec.faceIdx, mesh.m_FaceIdx,
+                             (uint64_t) rec.faceIdxSize * sizeof( unsigned int ) );
+    }
+
+    // pad the last block
+    writeCacheBlock( output, written, header.fileSize, NULL, 0 );
+
+    bool rval = output.good();
+    output.close();
+
+    // rename() replaces the target atomically; a reader keeps the data it mapped
+    if( rval )
+        rval = wxRenameFile( tmpfile, ofile, true );
+
+    if( !rval )
+    {
+        #ifdef DEBUG
+        do {
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] problems encountered writing model cache file '";
+            ostr << aFileName << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        } while( 0 );
+        #endif
+
+        // delete the defective file
+        wxRemoveFile( tmpfile );
+    }
+
+    return rval;
+}
+
+
+// returns a copy of an array of the model cache file, or NULL if it is
+// absent or does not fit in the file
+template< typename T >
+static T* copyCacheArray( const MAPPED_CACHE_FILE& aFile, uint64_t aOffset, uint64_t aCount,
+                          bool& aValid )
+{
+    if( 0 == aOffset || 0 == aCount )
+        return NULL;
+
+    if( aOffset % SG_MODEL_CACHE_ALIGN || aOffset > aFile.Size()
+        || aCount > ( aFile.Size() - aOffset ) / sizeof( T ) )
+    {
+        aValid = false;
+        return NULL;
+    }
+
+    T* data = new T[aCount];
+    memcpy( data, aFile.Data() + aOffset, aCount * sizeof( T ) );
+
+    return data;
+}
+
+
+S3DMODEL* S3D::ReadModelCache( const char* aFileName, void* aPluginMgr,
+    bool (*aTagCheck)( const char*, void* ) )
+{
+    if( NULL == aFileName || aFileName[0] == 0 )
+        return NULL;
+
+    MAPPED_CACHE_FILE file( aFileName );
+
+    if( NULL == file.Data() || file.Size() < sizeof( MODEL_CACHE_HEADER ) )
+        return NULL;
+
+    MODEL_CACHE_HEADER header;
+    memcpy( &header, file.Data(), sizeof( header ) );
+
+    // a file written by another version, or on a machine with another
+    // byte order or structure layout, is not used
+    if( memcmp( header.magic, SG_MODEL_CACHE_MAGIC, sizeof( header.magic ) )
+        || header.version != SG_MODEL_CACHE_VERSION
+        || header.byteOrder != 0x01020304
+        || header.materialSize != sizeof( SMATERIAL )
+        || header.fileSize != file.Size()
+        || header.pluginInfoSize > file.Size() - sizeof( header ) )
+    {
+        wxLogTrace( MASK_3D_SG, " * [INFO] incompatible model cache file '%s'\n", aFileName );
+        return NULL;
+    }
+
+    // check the plugin tag
+    std::string pluginInfo( file.Data() + sizeof( header ), header.pluginInfoSize );
+
+    if( NULL != aTagCheck && NULL != aPluginMgr && !aTagCheck( pluginInfo.c_str(), aPluginMgr ) )
+        return NULL;
+
+    uint64_t offset = alignCacheOffset( sizeof( header ) + header.pluginInfoSize );
+    uint64_t materialsOffset = offset;
+    offset = alignCacheOffset( offset + (uint64_t) header.materialsCount * sizeof( SMATERIAL ) );
+    uint64_t meshesOffset = offset;
+
+    if( 0 == header.materialsCount || 0 == header.meshesCount
+        || meshesOffset > file.Size()
+        || header.meshesCount > ( file.Size() - meshesOffset ) / sizeof( MODEL_CACHE_MESH ) )
+    {
+        wxLogTrace( MASK_3D_SG, " * [INFO] corrupt model cache file '%s'\n", aFileName );
+        return NULL;
+    }
+
+    bool valid = true;
+    S3DMODEL* model = S3D::New3DModel();
+
+    model->m_Materials = copyCacheArray< SMATERIAL >( file, materialsOffset,
+                                                      header.materialsCount, valid );
+    model->m_MaterialsSize = header.materialsCount;
+
+    model->m_Meshes = new SMESH[header.meshesCount];
+    model->m_MeshesSize = header.meshesCount;
+
+    const MODEL_CACHE_MESH* recs = (const MODEL_CACHE_MESH*)( file.Data() + meshesOffset );
+
+    for( unsigned int i = 0; i < header.meshesCount; ++i )
+    {
+        MODEL_CACHE_MESH rec;
+        memcpy( &rec, &recs[i], sizeof( rec ) );
+
+        SMESH& mesh = model->m_Meshes[i];
+        S3D::INIT_SMESH( mesh );
+
+        if( !valid )
+            continue;
+
+        mesh.m_VertexSize = rec.vertexSize;
+        mesh.m_FaceIdxSize = rec.faceIdxSize;
+        mesh.m_MaterialIdx = rec.materialIdx;
+        mesh.m_Positions = copyCacheArray< SFVEC3F >( file, rec.positions, rec.vertexSize, valid );
+        mesh.m_Normals = copyCacheArray< SFVEC3F >( file, rec.normals, rec.vertexSize, valid );
+        mesh.m_Texcoords = copyCacheArray< SFVEC2F >( file, rec.texcoords, rec.vertexSize, valid );
+        mesh.m_Color = copyCacheArray< SFVEC3F >( file, rec.colors, rec.vertexSize, valid );
+        mesh.m_FaceIdx = copyCacheArray< unsigned int >( file, rec.faceIdx, rec.faceIdxSize,
+                                                         valid );
+
+        // the renderers index the arrays with these values
+        if( mesh.m_MaterialIdx >= header.materialsCount || NULL == mesh.m_Positions )
+            valid = false;
+
+        for( unsigned int j = 0; valid && mesh.m_FaceIdx && j < mesh.m_FaceIdxSize; ++j )
+        {
+            if( mesh.m_FaceIdx[j] >= mesh.m_VertexSize )
+                valid = false;
+        }
+    }
+
+    if( !valid )
+    {
+        wxLogTrace( MASK_3D_SG, " * [INFO] corrupt model cache file '%s'\n", aFileName );
+        S3D::Destroy3DModel( &model );
+        return NULL;
+    }
+
+    return model;
+}
+
+
 S3DMODEL* S3D::GetModel( SCENEGRAPH* aNode )
 {
     if( NULL == aNode )
@@ -75,6 +75,8 @@
 #include <xmmintrin.h>
 
 #include <stack>
+#include <string.h>
+#include <float.h>
 #include <wx/debug.h>
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
@@ -240,6 +242,8 @@ CBVH_PBRT::CBVH_PBRT( const CGENERICCONTAINER &aObjectContainer,
     if( aObjectContainer.GetList().empty() )
     {
         m_nodes = NULL;
+        m_qnodes = NULL;
+        m_qbvhTodos = 0;
 
         return;
     }
@@ -306,8 +310,43 @@ CBVH_PBRT::CBVH_PBRT( const CGENERICCONTAINER &aObjectContainer,
 
     wxASSERT( offset == (unsigned int)totalNodes );
 
+    // Collapse the binary tree in a 4-wide tree for the single ray traversals
+    std::vector<LinearQBVHNode> qnodes;
+    qnodes.reserve( totalNodes / 2 + 1 );
+
+    flattenQBVHTree( 0, qnodes );
+
+    m_qnodes = static_cast<LinearQBVHNode *>( _mm_malloc( sizeof( LinearQBVHNode ) *
+                                                          qnodes.size(),
+                                                          L1_CACHE_LINE_SIZE ) );
+    m_addresses_pointer_to_mm_free.push_back( m_qnodes );
+
+    memcpy( m_qnodes, &qnodes[0], sizeof( LinearQBVHNode ) * qnodes.size() );
+
+    // A traversal pops a node and pushes up to 4 children, so its todo stack holds
+    // at most 3 nodes per level. The children always follow their parent in qnodes.
+    std::vector<int> qdepth( qnodes.size(), 1 );
+    int maxDepth = 1;
+
+    for( size_t i = 0; i < qnodes.size(); ++i )
+    {
+        for( int j = 0; j < 4; ++j )
+        {
+            const int child = qnodes[i].children[j];
+
+            if( child >= 0 )
+            {
+                qdepth[child] = qdepth[i] + 1;
+                maxDepth = std::max( maxDepth, qdepth[child] );
+            }
+        }
+    }
+
+    m_qbvhTodos = 3 * maxDepth + 1;
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
-    uint32_t treeBytes = totalNodes * sizeof( LinearBVHNode ) + sizeof( *this ) +
+    uint32_t treeBytes = totalNodes * sizeof( LinearBVHNode ) +
+                         qnodes.size() * sizeof( LinearQBVHNode ) + sizeof( *this ) +
                          m_primitives.size() * sizeof( m_primitives[0] ) +
                          m_addresses_pointer_to_mm_free.size() * sizeof( void * );
 
@@ -322,8 +361,8 @@ CBVH_PBRT::CBVH_PBRT( const CGENERICCONTAINER &aObjectContainer,
     case SPLIT_HLBVH:       printf( "using SPLIT_HLBVH\n" ); break;
     }
 
-    printf( "  BVH created with %d nodes (%.2f MB)\n",
-            totalNodes, float(treeBytes) / (1024.f * 1024.f) );
+    printf( "  BVH created with %d nodes, %u QBVH nodes (%.2f MB)\n",
+            totalNodes, (unsigned int)qnodes.size(), float(treeBytes) / (1024.f * 1024.f) );
     printf( "////////////////////////////////////////////////////////////////////////////////\n\n" );
 #endif
 }
@@ -1129,67 +1168,270 @@ int CBVH_PBRT::flattenBVHTree( BVHBuildNode *node, uint32_t *offset )
 }
 
 
+int CBVH_PBRT::flattenQBVHTree( int aNodeNum, std::vector<LinearQBVHNode> &aQNodes ) const
+{
+    // Gather up to 4 children, opening the interior child nodes with
+    // the largest surface area first
+    int children[4];
+    int nChildren;
+
+    if( m_nodes[aNodeNum].nPrimitives > 0 )
+    {
+        // The whole tree is a single leaf
+        children[0] = aNodeNum;
+        nChildren = 1;
+    }
+    else
+    {
+        children[0] = aNodeNum + 1;
+        children[1] = m_nodes[aNodeNum].secondChildOffset;
+        nChildren = 2;
+    }
+
+    while( nChildren < 4 )
+    {
+        int bestChild = -1;
+        float bestArea = -1.0f;
+
+        for( int i = 0; i < nChildren; ++i )
+        {
+            const LinearBVHNode &child = m_nodes[children[i]];
+
+            if( ( child.nPrimitives == 0 ) && ( child.bounds.SurfaceArea() > bestArea ) )
+            {
+                bestArea = child.bounds.SurfaceArea();
+                bestChild = i;
+            }
+        }
+
+        if( bestChild < 0 )
+            break;
+
+        const int opened = children[bestChild];
+
+        children[bestChild] = opened + 1;
+        children[nChildren++] = m_nodes[opened].secondChildOffset;
+    }
+
+    const int myOffset = aQNodes.size();
+
+    aQNodes.push_back( LinearQBVHNode() );
+
+    LinearQBVHNode &qnode = aQNodes[myOffset];
+
+    memset( &qnode, 0, sizeof( LinearQBVHNode ) );
+
+    for( int i = 0; i < 4; ++i )
+    {
+        // Unused children get an empty box, that is never hit
+        SFVEC3F bmin( FLT_MAX );
+        SFVEC3F bmax( -FLT_MAX );
+
+        if( i < nChildren )
+        {
+            bmin = m_nodes[children[i]].bounds.Min();
+            bmax = m_nodes[children[i]].bounds.Max();
+        }
+
+        for( int axis = 0; axis < 3; ++axis )
+        {
+            qnode.bounds[0][axis][i] = bmin[axis];
+            qnode.bounds[1][axis][i] = bmax[axis];
+        }
+
+        qnode.children[i] = ~0;
+    }
+
+    for( int i = 0; i < nChildren; ++i )
+    {
+        int child;
+
+        if( m_nodes[children[i]].nPrimitives > 0 )
+            child = ~children[i];
+        else
+            child = flattenQBVHTree( children[i], aQNodes );
+
+        // aQNodes may have been reallocated
+        aQNodes[myOffset].children[i] = child;
+    }
+
+    return myOffset;
+}
+
+
+/**
+ * The ray data used by the QBVH box tests, broadcasted on the 4 lanes.
+ */
+struct QBVH_RAY
+{
+    QBVH_RAY( const RAY &aRay )
+    {
+        origin[0] = _mm_set1_ps( aRay.m_Origin.x );
+        origin[1] = _mm_set1_ps( aRay.m_Origin.y );
+        origin[2] = _mm_set1_ps( aRay.m_Origin.z );
+
+        invDir[0] = _mm_set1_ps( aRay.m_InvDir.x );
+        invDir[1] = _mm_set1_ps( aRay.m_InvDir.y );
+        invDir[2] = _mm_set1_ps( aRay.m_InvDir.z );
+
+        for( int axis = 0; axis < 3; ++axis )
+        {
+            nearPlane[axis] = aRay.m_dirIsNeg[axis] ? 1 : 0;
+            farPlane[axis] = 1 - nearPlane[axis];
+        }
+    }
+
+    __m128 origin[3];
+    __m128 invDir[3];
+    int nearPlane[3];
+    int farPlane[3];
+};
+
+
+// Enlarge the exit distances to make the slab test conservative,
+// see "Robust BVH Ray Traversal" by Thiago Ize
+#define QBVH_EXIT_SCALE ( 1.0f + 2.0f * ( 3.0f * FLT_EPSILON * 0.5f ) )
+
+
+/**
+ * Function intersectQBVHNode
+ * tests the ray against the 4 child boxes of a QBVH node
+ * @param aTMax: the boxes farther than this distance are not reported
+ * @param aOutTEntry: receives the entry distances of the 4 boxes
+ * @return the bit mask of the boxes hit by the ray
+ */
+static inline int intersectQBVHNode( const LinearQBVHNode *aNode,
+                                     const QBVH_RAY &aRay,
+                                     float aTMax,
+                                     float *aOutTEntry )
+{
+    const __m128 exitScale = _mm_set1_ps( QBVH_EXIT_SCALE );
+
+    __m128 tEntry = _mm_setzero_ps();
+    __m128 tExit = _mm_set1_ps( aTMax );
+
+    for( int axis = 0; axis < 3; ++axis )
+    {
+        const __m128 tNear = _mm_mul_ps( _mm_sub_ps(
+                                 _mm_load_ps( aNode->bounds[aRay.nearPlane[axis]][axis] ),
+                                 aRay.origin[axis] ),
+                                 aRay.invDir[axis] );
+
+        const __m128 tFar = _mm_mul_ps( _mm_sub_ps(
+                                 _mm_load_ps( aNode->bounds[aRay.farPlane[axis]][axis] ),
+                                 aRay.origin[axis] ),
+                                 aRay.invDir[axis] );
+
+        tEntry = _mm_max_ps( tNear, tEntry );
+        tExit = _mm_min_ps( _mm_mul_ps( tFar, exitScale ), tExit );
+    }
+
+    _mm_storeu_ps( aOutTEntry, tEntry );
+
+    return _mm_movemask_ps( _mm_cmple_ps( tEntry, tExit ) );
+}
+
+
+// Size of the todo stacks kept on the stack; deeper (degenerate) trees use
+// a heap allocated stack
+#define MAX_QBVH_TODOS 128
+
+
 #define MAX_TODOS 64
 
 bool CBVH_PBRT::Intersect( const RAY &aRay, HITINFO &aHitInfo ) const
 {
-    if( !m_nodes )
+    if( !m_qnodes )
         return false;
 
     bool hit = false;
 
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = 0;
-    int todo[MAX_TODOS];
+    const QBVH_RAY ray4( aRay );
 
-    while( true )
+    // Follow ray through QBVH nodes to find primitive intersections.
+    // The _todo_ stack keeps the entry distance of its nodes, so the nodes
+    // behind a closer hit are skipped.
+    int todoOffset = 0;
+    int todoBuffer[MAX_QBVH_TODOS];
+    float todoTEntryBuffer[MAX_QBVH_TODOS];
+    int *todo = todoBuffer;
+    float *todoTEntry = todoTEntryBuffer;
+    std::vector<int> todoHeap;
+    std::vector<float> todoTEntryHeap;
+
+    if( m_qbvhTodos > MAX_QBVH_TODOS )
     {
-        const LinearBVHNode *node = &m_nodes[nodeNum];
+        todoHeap.resize( m_qbvhTodos );
+        todoTEntryHeap.resize( m_qbvhTodos );
+        todo = &todoHeap[0];
+        todoTEntry = &todoTEntryHeap[0];
+    }
 
-        wxASSERT( todoOffset < MAX_TODOS );
+    todo[todoOffset] = 0;
+    todoTEntry[todoOffset] = 0.0f;
+    todoOffset++;
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
+    while( todoOffset > 0 )
+    {
+        todoOffset--;
 
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+        if( todoTEntry[todoOffset] >= aHitInfo.m_tHit )
+            continue;
 
-        if( hitted && (hitBox < aHitInfo.m_tHit) )
+        const int nodeNum = todo[todoOffset];
+
+        if( nodeNum < 0 )
         {
-            if( node->nPrimitives > 0 )
+            // Intersect ray with primitives in leaf BVH node
+            const LinearBVHNode *leaf = &m_nodes[~nodeNum];
+
+            for( int i = 0; i < leaf->nPrimitives; ++i )
             {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
+                if( m_primitives[leaf->primitivesOffset + i]->Intersect( aRay, aHitInfo ) )
                 {
-                    if( m_primitives[node->primitivesOffset + i]->Intersect( aRay,
-                                                                             aHitInfo ) )
-                    {
-                        aHitInfo.m_acc_node_info = nodeNum;
-                        hit = true;
-                    }
+                    aHitInfo.m_acc_node_info = ~nodeNum;
+                    hit = true;
                 }
             }
-            else
+
+            continue;
+        }
+
+        const LinearQBVHNode *node = &m_qnodes[nodeNum];
+
+        float tEntry[4];
+
+        const int hitMask = intersectQBVHNode( node, ray4, aHitInfo.m_tHit, tEntry );
+
+        if( hitMask == 0 )
+            continue;
+
+        // Push the hit children from the farthest to the nearest one,
+        // so the nearest is processed first
+        int sorted[4];
+        int nHits = 0;
+
+        for( int i = 0; i < 4; ++i )
+        {
+            if( hitMask & ( 1 << i ) )
             {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
+                int j = nHits++;
 
-                continue;
+                for( ; ( j > 0 ) && ( tEntry[sorted[j - 1]] < tEntry[i] ); --j )
+                    sorted[j] = sorted[j - 1];
+
+                sorted[j] = i;
             }
         }
 
-        if( todoOffset == 0 )
-            break;
+        wxASSERT( ( todoOffset + nHits ) <= std::max( m_qbvhTodos, MAX_QBVH_TODOS ) );
 
-        nodeNum = todo[--todoOffset];
+        for( int j = 0; j < nHits; ++j )
+        {
+            todo[todoOffset] = node->children[sorted[j]];
+            todoTEntry[todoOffset] = tEntry[sorted[j]];
+            todoOffset++;
+        }
     }
 
     return hit;
@@ -1265,60 +1507,57 @@ bool CBVH_PBRT::Intersect( const RAY &aRay,
 
 bool CBVH_PBRT::IntersectP( const RAY &aRay, float aMaxDistance ) const
 {
-    if( !m_nodes )
+    if( !m_qnodes )
         return false;
 
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = 0;
-    int todo[MAX_TODOS];
+    const QBVH_RAY ray4( aRay );
 
-    while( true )
-    {
-        const LinearBVHNode *node = &m_nodes[nodeNum];
+    // Follow ray through QBVH nodes to find any primitive intersection
+    int todoOffset = 0;
+    int todoBuffer[MAX_QBVH_TODOS];
+    int *todo = todoBuffer;
+    std::vector<int> todoHeap;
 
-        wxASSERT( todoOffset < MAX_TODOS );
+    if( m_qbvhTodos > MAX_QBVH_TODOS )
+    {
+        todoHeap.resize( m_qbvhTodos );
+        todo = &todoHeap[0];
+    }
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
+    todo[todoOffset++] = 0;
 
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+    while( todoOffset > 0 )
+    {
+        const int nodeNum = todo[--todoOffset];
 
-        if( hitted && (hitBox < aMaxDistance) )
+        if( nodeNum < 0 )
         {
-            if( node->nPrimitives > 0 )
-            {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
-                {
-                    const COBJECT *obj = m_primitives[node->primitivesOffset + i];
+            // Intersect ray with primitives in leaf BVH node
+            const LinearBVHNode *leaf = &m_nodes[~nodeNum];
 
-                    if( obj->GetMaterial()->GetCastShadows() )
-                        if( obj->IntersectP( aRay, aMaxDistance ) )
-                            return true;
-                }
-            }
-            else
+            for( int i = 0; i < leaf->nPrimitives; ++i )
             {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
+                const COBJECT *obj = m_primitives[leaf->primitivesOffset + i];
 
-                continue;
+                if( obj->GetMaterial()->GetCastShadows() )
+                    if( obj->IntersectP( aRay, aMaxDistance ) )
+                        return true;
             }
+
+            continue;
         }
 
-        if( todoOffset == 0 )
-            break;
+        const LinearQBVHNode *node = &m_qnodes[nodeNum];
 
-        nodeNum = todo[--todoOffset];
+        float tEntry[4];
+
+        const int hitMask = intersectQBVHNode( node, ray4, aMaxDistance, tEntry );
+
+        wxASSERT( ( todoOffset + 4 ) <= std::max( m_qbvhTodos, MAX_QBVH_TODOS ) );
+
+        for( int i = 0; i < 4; ++i )
+            if( hitMask & ( 1 << i ) )
+                todo[todoOffset++] = node->children[i];
     }
 
     return false;
@@ -72,6 +72,7 @@
 
 #include "caccelerator.h"
 #include <list>
+#include <vector>
 #include <stdint.h>
 
 // Forward Declarations
@@ -98,6 +99,24 @@ struct LinearBVHNode
 };
 
 
+/**
+ * 4-wide BVH node, collapsed from the binary LinearBVHNode tree.
+ * The boxes of the 4 children are stored as structure of arrays so they
+ * can be tested against a ray with a single set of SIMD instructions.
+ */
+struct LinearQBVHNode
+{
+    // 96 bytes
+    float bounds[2][3][4];  ///< [min, max][x, y, z][child]
+
+    // 16 bytes
+    int children[4];        ///< >= 0: interior QBVH node, < 0: ~index of a leaf LinearBVHNode
+
+    // 16 bytes
+    int pad[4];             ///< ensure 128 byte total size
+};
+
+
 enum SPLITMETHOD
 {
     SPLIT_MIDDLE,
@@ -153,12 +172,22 @@ private:
     int flattenBVHTree( BVHBuildNode *node,
                         uint32_t *offset );
 
+    int flattenQBVHTree( int aNodeNum,
+                         std::vector<LinearQBVHNode> &aQNodes ) const;
+
     // BVH Private Data
     const int           m_maxPrimsInNode;
     SPLITMETHOD         m_splitMethod;
     CONST_VECTOR_OBJECT m_primitives;
     LinearBVHNode       *m_nodes;
 
+    /// Same tree as m_nodes, used by the single ray traversals.
+    /// The packet traversal and the node hints of the HITINFO still use m_nodes.
+    LinearQBVHNode      *m_qnodes;
+
+    /// Size of the todo stack needed by the traversals of m_qnodes (from its depth).
+    int                 m_qbvhTodos;
+
     std::list<void *> m_addresses_pointer_to_mm_free;
 
     // Partition traversal
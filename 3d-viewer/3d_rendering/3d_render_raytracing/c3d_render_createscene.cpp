@@ -862,9 +862,7 @@ void C3D_RENDER_RAYTRACING::reload( REPORTER *aStatusTextReporter )
     // Create an accelerator
     // /////////////////////////////////////////////////////////////////////////
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
     unsigned stats_startAcceleratorTime = GetRunningMicroSecs();
-#endif
 
     if( m_accelerator )
     {
@@ -875,9 +873,9 @@ void C3D_RENDER_RAYTRACING::reload( REPORTER *aStatusTextReporter )
     //m_accelerator = new CGRID( m_object_container );
     m_accelerator = new CBVH_PBRT( m_object_container );
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
     unsigned stats_endAcceleratorTime = GetRunningMicroSecs();
-#endif
+
+    m_stats_accelerator_time = stats_endAcceleratorTime - stats_startAcceleratorTime;
 
     setupMaterials();
 
@@ -1153,6 +1151,11 @@ void C3D_RENDER_RAYTRACING::add_3D_vias_and_pads_to_container()
 
 void C3D_RENDER_RAYTRACING::load_3D_models()
 {
+    // No models can be loaded without a cache manager, e.g. when rendering
+    // a board loaded by a script
+    if( !m_settings.Get3DCacheManager() )
+        return;
+
     // Go for all modules
     for( const MODULE* module = m_settings.GetBoard()->m_Modules;
          module;
@@ -29,6 +29,7 @@
 
 #include <GL/glew.h>
 #include <climits>
+#include <string.h>
 
 #include "c3d_render_raytracing.h"
 #include "mortoncodes.h"
@@ -64,6 +65,8 @@ C3D_RENDER_RAYTRACING::C3D_RENDER_RAYTRACING( CINFO3D_VISU &aSettings ) :
     m_yoffset = 0;
 
     m_isPreview = false;
+    m_isOffscreen = false;
+    m_stats_accelerator_time = 0;
     m_rt_render_state = RT_RENDER_STATE_MAX; // Set to an initial invalid state
 }
 
@@ -349,6 +352,98 @@ void C3D_RENDER_RAYTRACING::render( GLubyte *ptrPBO , REPORTER *aStatusTextRepor
 }
 
 
+void C3D_RENDER_RAYTRACING::RenderOffscreen( const wxSize &aSize,
+                                             wxImage &aImage,
+                                             RT_RENDER_STATS *aStats,
+                                             REPORTER *aStatusTextReporter )
+{
+    m_isOffscreen = true;
+
+    RT_RENDER_STATS stats;
+    memset( &stats, 0, sizeof( stats ) );
+
+    m_settings.CameraGet().SetCurWindowSize( aSize );
+
+    if( m_reloadRequested )
+    {
+        const unsigned startTime = GetRunningMicroSecs();
+
+        reload( aStatusTextReporter );
+
+        stats.m_reloadTime = GetRunningMicroSecs() - startTime;
+        stats.m_acceleratorTime = m_stats_accelerator_time;
+    }
+
+    if( ( m_windowSize != aSize ) || m_blockPositions.empty() )
+    {
+        m_windowSize = aSize;
+        m_oldWindowsSize = aSize;
+
+        initialize_block_positions();
+    }
+
+    // The render writes in a buffer having the layout of the PBO:
+    // RGBA pixels, with the bottom row first
+    std::vector<GLubyte> buffer( m_realBufferSize.x * m_realBufferSize.y * 4 );
+
+    restart_render_state();
+
+    if( m_camera_light )
+        m_camera_light->SetDirection( -m_settings.CameraGet().GetDir() );
+
+    // The tracing pass returns regularly to report its progress,
+    // so call the render until it finishes
+    while( m_rt_render_state != RT_RENDER_STATE_FINISH )
+    {
+        const RT_RENDER_STATE state = m_rt_render_state;
+        const unsigned startTime = GetRunningMicroSecs();
+
+        render( &buffer[0], aStatusTextReporter );
+
+        const unsigned passTime = GetRunningMicroSecs() - startTime;
+
+        switch( state )
+        {
+        case RT_RENDER_STATE_TRACING:
+            stats.m_tracingTime += passTime;
+            break;
+
+        case RT_RENDER_STATE_POST_PROCESS_SHADE:
+            stats.m_postProcessShadeTime += passTime;
+            break;
+
+        case RT_RENDER_STATE_POST_PROCESS_BLUR_AND_FINISH:
+            stats.m_postProcessBlurTime += passTime;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    aImage.Create( m_realBufferSize.x, m_realBufferSize.y, false );
+
+    unsigned char *rgb = aImage.GetData();
+
+    for( unsigned int y = 0; y < m_realBufferSize.y; ++y )
+    {
+        const GLubyte *src = &buffer[( m_realBufferSize.y - 1 - y ) * m_realBufferSize.x * 4];
+
+        for( unsigned int x = 0; x < m_realBufferSize.x; ++x )
+        {
+            rgb[0] = src[0];
+            rgb[1] = src[1];
+            rgb[2] = src[2];
+            rgb += 3;
+            src += 4;
+        }
+    }
+
+    if( aStats )
+        *aStats = stats;
+}
+
+
 void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
                                                REPORTER *aStatusTextReporter )
 {
@@ -2224,6 +2319,9 @@ void C3D_RENDER_RAYTRACING::initializeNewWindowSize()
 
 void C3D_RENDER_RAYTRACING::opengl_init_pbo()
 {
+    if( m_isOffscreen )
+        return;
+
     if( GLEW_ARB_pixel_buffer_object )
     {
         m_opengl_support_vertex_buffer_object = true;
@@ -40,6 +40,7 @@
 #include <plugins/3dapi/c3dmodel.h>
 
 #include <map>
+#include <wx/image.h>
 
 /// Vector of materials
 typedef std::vector< CBLINN_PHONG_MATERIAL > MODEL_MATERIALS;
@@ -56,6 +57,18 @@ typedef enum
     RT_RENDER_STATE_MAX
 }RT_RENDER_STATE;
 
+
+/// Timings of an offscreen render, in microseconds
+struct RT_RENDER_STATS
+{
+    unsigned int m_reloadTime;              ///< Scene build, including the accelerator
+    unsigned int m_acceleratorTime;         ///< Accelerator (BVH) construction
+    unsigned int m_tracingTime;             ///< Ray tracing pass
+    unsigned int m_postProcessShadeTime;    ///< Post processing shader pass
+    unsigned int m_postProcessBlurTime;     ///< Post processing blur and finish pass
+};
+
+
 class C3D_RENDER_RAYTRACING : public C3D_RENDER_BASE
 {
 public:
@@ -69,6 +82,22 @@ public:
 
     int GetWaitForEditingTimeOut();
 
+    /**
+     * Function RenderOffscreen
+     * renders the board in an image, without any OpenGL context.
+     * The scene is (re)loaded if a reload was requested, then all the render
+     * passes run until the image is finished.
+     * @param aSize: the size of the render window. The image size is a bit
+     * smaller, aligned on the ray packets size.
+     * @param aImage: receives the rendered image
+     * @param aStats: if not NULL, receives the timings of the render
+     * @param aStatusTextReporter: if not NULL, receives the progress messages
+     */
+    void RenderOffscreen( const wxSize &aSize,
+                          wxImage &aImage,
+                          RT_RENDER_STATS *aStats = NULL,
+                          REPORTER *aStatusTextReporter = NULL );
+
 private:
     bool initializeOpenGL();
     void initializeNewWindowSize();
@@ -97,6 +126,9 @@ private:
 
     bool m_isPreview;
 
+    /// True when rendering with RenderOffscreen, so no OpenGL call is done
+    bool m_isOffscreen;
+
     SFVEC3F shadeHit( const SFVEC3F &aBgColor,
                       const RAY &aRay,
                       HITINFO &aHitInfo,
@@ -161,6 +193,7 @@ private:
     // Statistics
     unsigned int m_stats_converted_dummy_to_plane;
     unsigned int m_stats_converted_roundsegment2d_to_roundsegment;
+    unsigned int m_stats_accelerator_time;
 
     void create_3d_object_from( CCONTAINER &aDstContainer,
                                 const COBJECT2D *aObject2D,
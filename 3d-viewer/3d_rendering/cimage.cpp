@@ -35,6 +35,19 @@
 #define CLAMP(n, min, max) {if( n < min ) n=min; else if( n > max ) n = max;}
 #endif
 
+// SSE2 is always available on x86_64, and used when the compiler enables it on x86.
+// AVX2 kernels are compiled when the compiler supports function specific targets,
+// and are selected at run time only if the CPU supports them.
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define CIMAGE_USE_SSE2
+#include <emmintrin.h>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define CIMAGE_USE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 
 CIMAGE::CIMAGE( unsigned int aXsize, unsigned int aYsize )
 {
@@ -190,9 +203,108 @@ void CIMAGE::CircleFilled(int aCx, int aCy, int aRadius, unsigned char aValue)
 }
 
 
+#ifdef CIMAGE_USE_SSE2
+
+// Operators for CopyFull, working on 16 pixels.
+// They give the same results as the scalar code of CopyFull.
+struct SSE2_OP_ADD
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_adds_epu8( aA, aB ); }
+};
+
+struct SSE2_OP_SUB
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_subs_epu8( aA, aB ); }
+};
+
+struct SSE2_OP_DIF
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const
+    {
+        return _mm_or_si128( _mm_subs_epu8( aA, aB ), _mm_subs_epu8( aB, aA ) );
+    }
+};
+
+struct SSE2_OP_AND
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_and_si128( aA, aB ); }
+};
+
+struct SSE2_OP_OR
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_or_si128( aA, aB ); }
+};
+
+struct SSE2_OP_XOR
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_xor_si128( aA, aB ); }
+};
+
+struct SSE2_OP_BLEND50
+{
+    // (a + b) / 2 == (a & b) + ((a ^ b) >> 1), without overflow of 8 bits values
+    __m128i operator()( __m128i aA, __m128i aB ) const
+    {
+        const __m128i halfXor = _mm_and_si128( _mm_srli_epi16( _mm_xor_si128( aA, aB ), 1 ),
+                                               _mm_set1_epi8( 0x7F ) );
+
+        return _mm_add_epi8( _mm_and_si128( aA, aB ), halfXor );
+    }
+};
+
+struct SSE2_OP_MIN
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_min_epu8( aA, aB ); }
+};
+
+struct SSE2_OP_MAX
+{
+    __m128i operator()( __m128i aA, __m128i aB ) const { return _mm_max_epu8( aA, aB ); }
+};
+
+
+/**
+ * Function copyOpSSE2
+ * applies aOp to the pixels of aImgA and aImgB, 16 pixels at a time
+ * @return the count of pixels processed (a multiple of 16), the remaining
+ * pixels must be processed by the scalar code
+ */
+template <class OP>
+static unsigned int copyOpSSE2( unsigned char* aDst, const unsigned char* aImgA,
+                                const unsigned char* aImgB, unsigned int aCount, OP aOp )
+{
+    unsigned int it = 0;
+
+    for( ; it + 16 <= aCount; it += 16 )
+    {
+        const __m128i a = _mm_loadu_si128( (const __m128i*) &aImgA[it] );
+        const __m128i b = _mm_loadu_si128( (const __m128i*) &aImgB[it] );
+
+        _mm_storeu_si128( (__m128i*) &aDst[it], aOp( a, b ) );
+    }
+
+    return it;
+}
+
+#endif  // CIMAGE_USE_SSE2
+
+
 void CIMAGE::Invert()
 {
-    for( unsigned int it = 0; it < m_wxh; it++ )
+    unsigned int it = 0;
+
+#ifdef CIMAGE_USE_SSE2
+    const __m128i ones = _mm_set1_epi8( (char) 0xFF );
+
+    for( ; it + 16 <= m_wxh; it += 16 )
+    {
+        __m128i* ptr = (__m128i*) &m_pixels[it];
+
+        _mm_storeu_si128( ptr, _mm_xor_si128( _mm_loadu_si128( ptr ), ones ) );
+    }
+#endif
+
+    for( ; it < m_wxh; it++ )
         m_pixels[it] = 255 - m_pixels[it];
 }
 
@@ -200,6 +312,7 @@ void CIMAGE::Invert()
 void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOperation )
 {
     int aV, bV;
+    unsigned int it = 0;    // first pixel not yet processed by the vectorized code
 
     if( aOperation == COPY_RAW )
     {
@@ -219,7 +332,10 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_ADD:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_ADD() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -232,7 +348,10 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_SUB:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_SUB() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -245,7 +364,10 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_DIF:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_DIF() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -255,7 +377,7 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_MUL:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -265,28 +387,40 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_AND:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_AND() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             m_pixels[it] = aImgA->m_pixels[it] & aImgB->m_pixels[it];
         }
     break;
 
     case COPY_OR:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_OR() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             m_pixels[it] = aImgA->m_pixels[it] | aImgB->m_pixels[it];
         }
     break;
 
     case COPY_XOR:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_XOR() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             m_pixels[it] = aImgA->m_pixels[it] ^ aImgB->m_pixels[it];
         }
     break;
 
     case COPY_BLEND50:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_BLEND50() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -296,7 +430,10 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_MIN:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_MIN() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -306,7 +443,10 @@ void CIMAGE::CopyFull( const CIMAGE *aImgA, const CIMAGE *aImgB, E_IMAGE_OP aOpe
     break;
 
     case COPY_MAX:
-        for( unsigned int it = 0;it < m_wxh; it++ )
+#ifdef CIMAGE_USE_SSE2
+        it = copyOpSSE2( m_pixels, aImgA->m_pixels, aImgB->m_pixels, m_wxh, SSE2_OP_MAX() );
+#endif
+        for( ; it < m_wxh; it++ )
         {
             aV = aImgA->m_pixels[it];
             bV = aImgB->m_pixels[it];
@@ -458,10 +598,172 @@ static const S_FILTER FILTERS[] =   {
 };// Filters
 
 
-// !TODO: This functions can be optimized slipting it between the edges and
-//        do it without use the getpixel function.
-//        Optimization can be done to m_pixels[ix + iy * m_width]
-//        but keep in mind the parallel process of the algorithm
+/// The non zero taps of a 5x5 filter, used by the vectorized filter kernels
+struct FILTER_TAPS
+{
+    int            m_count;
+    int            m_dx[25];
+    int            m_dy[25];
+    short          m_factor[25];
+    unsigned int   m_div;
+    int            m_offset;
+};
+
+
+#ifdef CIMAGE_USE_SSE2
+
+/**
+ * Function filterFinishSSE2
+ * computes (aSum / div + offset) of 4 pixels the way the scalar code does it,
+ * without the final clamp that is done by the packing instructions.
+ * The scalar code divides an int by an unsigned int, so a negative sum gives
+ * a result greater than 255.
+ */
+static inline __m128i filterFinishSSE2( __m128i aSum, const FILTER_TAPS& aTaps )
+{
+    __m128i q = aSum;
+
+    if( aTaps.m_div != 1 )
+    {
+        // The sums are small enough to make the float division exact after truncation
+        q = _mm_cvttps_epi32( _mm_div_ps( _mm_cvtepi32_ps( aSum ),
+                                          _mm_set1_ps( (float) aTaps.m_div ) ) );
+
+        const __m128i negative = _mm_cmplt_epi32( aSum, _mm_setzero_si128() );
+
+        q = _mm_or_si128( _mm_andnot_si128( negative, q ),
+                          _mm_and_si128( negative, _mm_set1_epi32( 255 ) ) );
+    }
+
+    return _mm_add_epi32( q, _mm_set1_epi32( aTaps.m_offset ) );
+}
+
+
+/**
+ * Function filterRowSSE2
+ * filters the pixels of the row aY, from aXStart to aXEnd (excluded), 8 pixels at a time.
+ * The 5x5 neighbourhood of these pixels must be inside the image.
+ * @return the first pixel not processed, the remaining pixels must be processed
+ * by the scalar code
+ */
+static int filterRowSSE2( const unsigned char* aSrc, unsigned char* aDst,
+                          int aWidth, int aY, int aXStart, int aXEnd,
+                          const FILTER_TAPS& aTaps )
+{
+    const __m128i zero = _mm_setzero_si128();
+    int ix = aXStart;
+
+    for( ; ix + 8 <= aXEnd; ix += 8 )
+    {
+        __m128i sumLo = zero;
+        __m128i sumHi = zero;
+
+        for( int t = 0; t < aTaps.m_count; t++ )
+        {
+            const unsigned char* src = aSrc + ( aY + aTaps.m_dy[t] ) * aWidth +
+                                       ix + aTaps.m_dx[t];
+
+            const __m128i pixels = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*) src ),
+                                                      zero );
+
+            // |pixel * factor| always fits in 16 bits
+            const __m128i prod = _mm_mullo_epi16( pixels, _mm_set1_epi16( aTaps.m_factor[t] ) );
+
+            // Sign extend the products to 32 bits
+            sumLo = _mm_add_epi32( sumLo, _mm_srai_epi32( _mm_unpacklo_epi16( prod, prod ), 16 ) );
+            sumHi = _mm_add_epi32( sumHi, _mm_srai_epi32( _mm_unpackhi_epi16( prod, prod ), 16 ) );
+        }
+
+        const __m128i result = _mm_packs_epi32( filterFinishSSE2( sumLo, aTaps ),
+                                                filterFinishSSE2( sumHi, aTaps ) );
+
+        _mm_storel_epi64( (__m128i*) &aDst[ix + aY * aWidth], _mm_packus_epi16( result, result ) );
+    }
+
+    return ix;
+}
+
+#endif  // CIMAGE_USE_SSE2
+
+
+#ifdef CIMAGE_USE_AVX2
+
+__attribute__(( target( "avx2" ) ))
+static inline __m256i filterFinishAVX2( __m256i aSum, const FILTER_TAPS& aTaps )
+{
+    __m256i q = aSum;
+
+    if( aTaps.m_div != 1 )
+    {
+        q = _mm256_cvttps_epi32( _mm256_div_ps( _mm256_cvtepi32_ps( aSum ),
+                                                _mm256_set1_ps( (float) aTaps.m_div ) ) );
+
+        const __m256i negative = _mm256_cmpgt_epi32( _mm256_setzero_si256(), aSum );
+
+        q = _mm256_blendv_epi8( q, _mm256_set1_epi32( 255 ), negative );
+    }
+
+    return _mm256_add_epi32( q, _mm256_set1_epi32( aTaps.m_offset ) );
+}
+
+
+/**
+ * Function filterRowAVX2
+ * same as filterRowSSE2, 16 pixels at a time
+ */
+__attribute__(( target( "avx2" ) ))
+static int filterRowAVX2( const unsigned char* aSrc, unsigned char* aDst,
+                          int aWidth, int aY, int aXStart, int aXEnd,
+                          const FILTER_TAPS& aTaps )
+{
+    int ix = aXStart;
+
+    for( ; ix + 16 <= aXEnd; ix += 16 )
+    {
+        __m256i sumLo = _mm256_setzero_si256();
+        __m256i sumHi = _mm256_setzero_si256();
+
+        for( int t = 0; t < aTaps.m_count; t++ )
+        {
+            const unsigned char* src = aSrc + ( aY + aTaps.m_dy[t] ) * aWidth +
+                                       ix + aTaps.m_dx[t];
+
+            const __m256i pixels = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) src ) );
+            const __m256i prod = _mm256_mullo_epi16( pixels,
+                                                     _mm256_set1_epi16( aTaps.m_factor[t] ) );
+
+            sumLo = _mm256_add_epi32( sumLo,
+                                      _mm256_cvtepi16_epi32( _mm256_castsi256_si128( prod ) ) );
+            sumHi = _mm256_add_epi32( sumHi,
+                                      _mm256_cvtepi16_epi32( _mm256_extracti128_si256( prod, 1 ) ) );
+        }
+
+        const __m256i qLo = filterFinishAVX2( sumLo, aTaps );
+        const __m256i qHi = filterFinishAVX2( sumHi, aTaps );
+
+        const __m128i resultLo = _mm_packs_epi32( _mm256_castsi256_si128( qLo ),
+                                                  _mm256_extracti128_si256( qLo, 1 ) );
+        const __m128i resultHi = _mm_packs_epi32( _mm256_castsi256_si128( qHi ),
+                                                  _mm256_extracti128_si256( qHi, 1 ) );
+
+        _mm_storeu_si128( (__m128i*) &aDst[ix + aY * aWidth],
+                          _mm_packus_epi16( resultLo, resultHi ) );
+    }
+
+    return ix;
+}
+
+
+static bool cpuHasAVX2()
+{
+    static const bool hasAVX2 = __builtin_cpu_supports( "avx2" );
+
+    return hasAVX2;
+}
+
+#endif  // CIMAGE_USE_AVX2
+
+
 void CIMAGE::EfxFilter( CIMAGE *aInImg, E_FILTER aFilterType )
 {
     S_FILTER filter = FILTERS[aFilterType];
@@ -469,11 +771,66 @@ void CIMAGE::EfxFilter( CIMAGE *aInImg, E_FILTER aFilterType )
     aInImg->m_wraping = WRAP_CLAMP;
     m_wraping = WRAP_CLAMP;
 
+    // The pixels having their 5x5 neighbourhood inside the image are processed
+    // by the vectorized code, if any. The other ones use the clamped coordinates.
+    // The vectorized code cannot reproduce the overflow of the scalar code
+    // for a negative sum divided by 2, so this divisor is never vectorized.
+    typedef int (*FILTER_ROW_FUNC)( const unsigned char*, unsigned char*, int, int, int, int,
+                                    const FILTER_TAPS& );
+
+    FILTER_ROW_FUNC filterRow = NULL;
+
+#ifdef CIMAGE_USE_SSE2
+    filterRow = filterRowSSE2;
+#endif
+
+#ifdef CIMAGE_USE_AVX2
+    if( cpuHasAVX2() )
+        filterRow = filterRowAVX2;
+#endif
+
+    if( ( aInImg->m_width != m_width ) || ( aInImg->m_height != m_height ) ||
+        ( m_width < 5 ) || ( m_height < 5 ) || ( filter.div == 2 ) )
+        filterRow = NULL;
+
+    FILTER_TAPS taps;
+
+    taps.m_count  = 0;
+    taps.m_div    = filter.div;
+    taps.m_offset = filter.offset;
+
+    for( int sy = 0; sy < 5; sy++ )
+    {
+        for( int sx = 0; sx < 5; sx++ )
+        {
+            if( filter.kernel[sx][sy] == 0 )
+                continue;
+
+            taps.m_dx[taps.m_count] = sx - 2;
+            taps.m_dy[taps.m_count] = sy - 2;
+            taps.m_factor[taps.m_count] = filter.kernel[sx][sy];
+            taps.m_count++;
+        }
+    }
+
     #pragma omp parallel for
     for( int iy = 0; iy < (int)m_height; iy++)
     {
-        for( int ix = 0; ix < (int)m_width; ix++ )
+        int ix = 0;
+        int ixVectorEnd = 0;
+
+        if( filterRow && ( iy >= 2 ) && ( iy < (int)m_height - 2 ) )
         {
+            ixVectorEnd = filterRow( aInImg->m_pixels, m_pixels, m_width, iy,
+                                     2, m_width - 2, taps );
+        }
+
+        for( ; ix < (int)m_width; ix++ )
+        {
+            // Skip the pixels already processed by the vectorized code
+            if( ( ix == 2 ) && ( ixVectorEnd > 2 ) )
+                ix = ixVectorEnd;
+
             int v = 0;
 
             for( int sy = 0; sy < 5; sy++ )
@@ -34,7 +34,9 @@
  *       depending on the application.
  */
 
+#include <cmath>
 #include <macros.h>
+#include <kicad_string.h>
 #include <base_struct.h>
 #include <class_title_block.h>
 #include <common.h>
@@ -62,7 +64,14 @@ std::string Double2Str( double aValue )
     char    buf[50];
     int     len;
 
-    if( aValue != 0.0 && fabs( aValue ) <= 0.0001 )
+    if( fabs( aValue ) < 1e15 && aValue == (double) (long long) aValue
+        && !( aValue == 0.0 && std::signbit( aValue ) ) )
+    {
+        // Integral values, the most common ones, are printed by %g as plain
+        // integers, which is done here without the cost of sprintf
+        len = FixedPointToStr( buf, (long long) aValue, 0 );
+    }
+    else if( aValue != 0.0 && fabs( aValue ) <= 0.0001 )
     {
         // For these small values, %f works fine,
         // and %g gives an exponent
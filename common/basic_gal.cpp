@@ -40,6 +40,7 @@
 using namespace KIGFX;
 
 BASIC_GAL basic_gal;
+MUTEX     basic_galLock;
 
 const VECTOR2D BASIC_GAL::transform( const VECTOR2D& aPoint ) const
 {
@@ -97,6 +98,10 @@ void BASIC_GAL::DrawPolyline( const std::deque<VECTOR2D>& aPointList )
                         polyline_corners[ii].x, polyline_corners[ii].y );
         }
     }
+    else if( m_strokes )
+    {
+        m_strokes->push_back( polyline_corners );
+    }
 }
 
 void BASIC_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
@@ -128,4 +133,11 @@ void BASIC_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint
             m_callback( startVector.x, startVector.y,
                         endVector.x, endVector.y );
     }
+    else if( m_strokes )
+    {
+        std::vector<wxPoint> line( 2 );
+        line[0] = wxPoint( startVector.x, startVector.y );
+        line[1] = wxPoint( endVector.x, endVector.y );
+        m_strokes->push_back( line );
+    }
 }
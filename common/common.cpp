@@ -263,15 +263,19 @@ int ProcessExecute( const wxString& aCommandLine, int aFlags, wxProcess *callbac
 
 time_t GetNewTimeStamp()
 {
-    static time_t oldTimeStamp;
+    // items can be created (copied) by several threads, e.g. when plotting
+    static std::atomic<time_t> oldTimeStamp( 0 );
+    time_t prevTimeStamp = oldTimeStamp;
     time_t newTimeStamp;
 
-    newTimeStamp = time( NULL );
+    do
+    {
+        newTimeStamp = time( NULL );
 
-    if( newTimeStamp <= oldTimeStamp )
-        newTimeStamp = oldTimeStamp + 1;
+        if( newTimeStamp <= prevTimeStamp )
+            newTimeStamp = prevTimeStamp + 1;
 
-    oldTimeStamp = newTimeStamp;
+    } while( !oldTimeStamp.compare_exchange_weak( prevTimeStamp, newTimeStamp ) );
 
     return newTimeStamp;
 }
@@ -61,6 +61,7 @@ GERBER_PLOTTER::GERBER_PLOTTER()
     m_gerberUnitFmt = 6;
     m_useX2Attributes = false;
     m_useNetAttributes = true;
+    m_compactOutput = false;
 }
 
 
@@ -161,16 +162,16 @@ bool GERBER_PLOTTER::StartPlot()
 {
     wxASSERT( outputFile );
 
-    finalFile = outputFile;     // the actual gerber file will be created later
+    finalFile = outputFile;     // the header goes directly to the gerber file
 
-    // Create a temporary filename to store gerber file
+    // Create a temporary file to store the gerber data following the aperture
+    // list, which is only known at the end of the plot
     // note tmpfile() does not work under Vista and W7 in user mode
     m_workFilename = filename + wxT(".tmp");
-    workFile   = wxFopen( m_workFilename, wxT( "wt" ));
-    outputFile = workFile;
-    wxASSERT( outputFile );
+    workFile   = wxFopen( m_workFilename, wxT( "w+b" ));
+    wxASSERT( workFile );
 
-    if( outputFile == NULL )
+    if( workFile == NULL )
         return false;
 
     for( unsigned ii = 0; ii < m_headerExtraLines.GetCount(); ii++ )
@@ -210,6 +211,10 @@ bool GERBER_PLOTTER::StartPlot()
     fputs( "G01*\n", outputFile );
 
     fputs( "G04 APERTURE LIST*\n", outputFile );
+
+    // The aperture list is inserted here by EndPlot
+    outputFile = workFile;
+
     /* Select the default aperture */
     SetCurrentLineWidth( USE_DEFAULT_LINE_WIDTH, 0 );
 
@@ -219,31 +224,24 @@ bool GERBER_PLOTTER::StartPlot()
 
 bool GERBER_PLOTTER::EndPlot()
 {
-    char     line[1024];
-    wxString msg;
-
     wxASSERT( outputFile );
 
     /* Outfile is actually a temporary file i.e. workFile */
     fputs( "M02*\n", outputFile );
-    fflush( outputFile );
 
-    fclose( workFile );
-    workFile   = wxFopen( m_workFilename, wxT( "rt" ));
-    wxASSERT( workFile );
+    // Placement of apertures in RS274X, after the header already in finalFile
     outputFile = finalFile;
+    writeApertureList();
+    fputs( "G04 APERTURE END LIST*\n", outputFile );
 
-    // Placement of apertures in RS274X
-    while( fgets( line, 1024, workFile ) )
-    {
-        fputs( line, outputFile );
+    // Then append the plot data, by large blocks
+    std::vector<char> buffer( 256 * 1024 );
+    size_t count;
 
-        if( strcmp( strtok( line, "\n\r" ), "G04 APERTURE LIST*" ) == 0 )
-        {
-            writeApertureList();
-            fputs( "G04 APERTURE END LIST*\n", outputFile );
-        }
-    }
+    rewind( workFile );
+
+    while( ( count = fread( &buffer[0], 1, buffer.size(), workFile ) ) > 0 )
+        fwrite( &buffer[0], 1, count, outputFile );
 
     fclose( workFile );
     fclose( finalFile );
@@ -284,28 +282,47 @@ void GERBER_PLOTTER::SetCurrentLineWidth( int width, void* aData )
 std::vector<APERTURE>::iterator GERBER_PLOTTER::getAperture( const wxSize& aSize,
                         APERTURE::APERTURE_TYPE aType, int aApertureAttribute )
 {
-    int last_D_code = 9;
+    APERTURE tool;
+    tool.m_Size  = aSize;
+    tool.m_Type  = aType;
+    tool.m_ApertureAttribute = aApertureAttribute;
 
-    // Search an existing aperture
-    std::vector<APERTURE>::iterator tool = apertures.begin();
+    return getAperture( tool );
+}
 
-    while( tool != apertures.end() )
-    {
-        last_D_code = tool->m_DCode;
 
-        if( (tool->m_Type == aType) && (tool->m_Size == aSize) && (tool->m_ApertureAttribute == aApertureAttribute) )
-            return tool;
+// The key of an aperture in m_apertureIndex: all the fields but the D code
+static std::string apertureKey( const APERTURE& aAperture )
+{
+    int header[] = { aAperture.m_Type, aAperture.m_Size.x, aAperture.m_Size.y,
+                     aAperture.m_ApertureAttribute, aAperture.m_Radius };
+
+    std::string key( (const char*) header, sizeof( header ) );
 
-        ++tool;
+    for( unsigned ii = 0; ii < aAperture.m_Corners.size(); ii++ )
+    {
+        int corner[] = { aAperture.m_Corners[ii].x, aAperture.m_Corners[ii].y };
+        key.append( (const char*) corner, sizeof( corner ) );
     }
 
-    // Allocate a new aperture
-    APERTURE new_tool;
-    new_tool.m_Size  = aSize;
-    new_tool.m_Type  = aType;
-    new_tool.m_DCode = last_D_code + 1;
-    new_tool.m_ApertureAttribute = aApertureAttribute;
+    return key;
+}
+
+
+std::vector<APERTURE>::iterator GERBER_PLOTTER::getAperture( const APERTURE& aAperture )
+{
+    // Search an existing aperture
+    std::string key = apertureKey( aAperture );
+    std::unordered_map<std::string, int>::const_iterator it = m_apertureIndex.find( key );
+
+    if( it != m_apertureIndex.end() )
+        return apertures.begin() + it->second;
 
+    // Allocate a new aperture; D codes are allocated in sequence from D10
+    APERTURE new_tool = aAperture;
+    new_tool.m_DCode = apertures.empty() ? 10 : apertures.back().m_DCode + 1;
+
+    m_apertureIndex[key] = apertures.size();
     apertures.push_back( new_tool );
 
     return apertures.end() - 1;
@@ -316,29 +333,113 @@ void GERBER_PLOTTER::selectAperture( const wxSize&           aSize,
                                      APERTURE::APERTURE_TYPE aType,
                                      int aApertureAttribute )
 {
-    bool change = ( currentAperture == apertures.end() ) ||
-                  ( currentAperture->m_Type != aType ) ||
-                  ( currentAperture->m_Size != aSize );
+    APERTURE tool;
+    tool.m_Size  = aSize;
+    tool.m_Type  = aType;
+    tool.m_ApertureAttribute = aApertureAttribute;
+
+    selectAperture( tool );
+}
+
+
+void GERBER_PLOTTER::selectAperture( const APERTURE& aAperture )
+{
+    int attribute = aAperture.m_ApertureAttribute;
 
     if( !m_useX2Attributes || !m_useNetAttributes )
-        aApertureAttribute = 0;
-    else
-        change = change || ( currentAperture->m_ApertureAttribute != aApertureAttribute );
+        attribute = 0;
+
+    bool change = ( currentAperture == apertures.end() ) ||
+                  ( currentAperture->m_Type != aAperture.m_Type ) ||
+                  ( currentAperture->m_Size != aAperture.m_Size ) ||
+                  ( currentAperture->m_Radius != aAperture.m_Radius ) ||
+                  ( currentAperture->m_Corners != aAperture.m_Corners ) ||
+                  ( currentAperture->m_ApertureAttribute != attribute );
 
     if( change )
     {
         // Pick an existing aperture or create a new one
-        currentAperture = getAperture( aSize, aType, aApertureAttribute );
+        if( attribute == aAperture.m_ApertureAttribute )
+        {
+            currentAperture = getAperture( aAperture );
+        }
+        else
+        {
+            APERTURE tool = aAperture;
+            tool.m_ApertureAttribute = attribute;
+            currentAperture = getAperture( tool );
+        }
+
         fprintf( outputFile, "D%d*\n", currentAperture->m_DCode );
     }
 }
 
 
+void GERBER_PLOTTER::flashMacroAperture( const wxPoint& aPadPos, APERTURE::APERTURE_TYPE aType,
+                                         const wxPoint* aCorners, int aRadius, void* aData )
+{
+    GBR_METADATA* gbr_metadata = static_cast<GBR_METADATA*>( aData );
+    DPOINT pos_dev = userToDeviceCoordinates( aPadPos );
+
+    APERTURE tool;
+    tool.m_Type   = aType;
+    tool.m_Radius = aRadius;
+    tool.m_ApertureAttribute = gbr_metadata ? gbr_metadata->GetApertureAttrib() : 0;
+
+    // The corners are given along the device axis (the Y axis is reversed),
+    // but in IUs like the other aperture sizes
+    for( int ii = 0; ii < 4; ii++ )
+    {
+        DPOINT corner_dev = userToDeviceCoordinates( aPadPos + aCorners[ii] ) - pos_dev;
+        tool.m_Corners.push_back( wxPoint( KiROUND( corner_dev.x / iuPerDeviceUnit ),
+                                           KiROUND( corner_dev.y / iuPerDeviceUnit ) ) );
+    }
+
+    selectAperture( tool );
+
+    if( gbr_metadata )
+        formatNetAttribute( &gbr_metadata->m_NetlistMetadata );
+
+    emitDcode( pos_dev, 3 );
+}
+
+
 void GERBER_PLOTTER::writeApertureList()
 {
     wxASSERT( outputFile );
     char cbuf[1024];
 
+    // The aperture macros must be defined before their first use
+    bool useOutline4P = false;
+    bool useRoundRect = false;
+
+    for( unsigned ii = 0; ii < apertures.size(); ii++ )
+    {
+        useOutline4P |= apertures[ii].m_Type == APERTURE::Outline4P;
+        useRoundRect |= apertures[ii].m_Type == APERTURE::RoundRect;
+    }
+
+    if( useOutline4P )
+        fputs( "%AMOutline4P*\n"
+               "0 Free polygon, 4 corners, relative to the flash position*\n"
+               "0 $1 to $8: X, Y of the 4 corners*\n"
+               "4,1,4,$1,$2,$3,$4,$5,$6,$7,$8,$1,$2,0*%\n", outputFile );
+
+    if( useRoundRect )
+        fputs( "%AMRoundRect*\n"
+               "0 Rectangle with rounded corners*\n"
+               "0 $1: rounding radius*\n"
+               "0 $2 to $9: X, Y of the 4 corner centers, relative to the flash position*\n"
+               "4,1,4,$2,$3,$4,$5,$6,$7,$8,$9,$2,$3,0*\n"
+               "1,1,$1+$1,$2,$3*\n"
+               "1,1,$1+$1,$4,$5*\n"
+               "1,1,$1+$1,$6,$7*\n"
+               "1,1,$1+$1,$8,$9*\n"
+               "20,1,$1+$1,$2,$3,$4,$5,0*\n"
+               "20,1,$1+$1,$4,$5,$6,$7,0*\n"
+               "20,1,$1+$1,$6,$7,$8,$9,0*\n"
+               "20,1,$1+$1,$8,$9,$2,$3,0*%\n", outputFile );
+
     // Init
     for( std::vector<APERTURE>::iterator tool = apertures.begin();
          tool != apertures.end(); ++tool )
@@ -386,6 +487,21 @@ void GERBER_PLOTTER::writeApertureList()
 	            tool->m_Size.x * fscale,
 		    tool->m_Size.y * fscale );
             break;
+
+        case APERTURE::Outline4P:
+        case APERTURE::RoundRect:
+            if( tool->m_Type == APERTURE::Outline4P )
+                text += sprintf( text, "Outline4P," );
+            else
+                text += sprintf( text, "RoundRect,%#fX", tool->m_Radius * fscale );
+
+            for( unsigned ii = 0; ii < tool->m_Corners.size(); ii++ )
+                text += sprintf( text, ii ? "X%#fX%#f" : "%#fX%#f",
+                                 tool->m_Corners[ii].x * fscale,
+                                 tool->m_Corners[ii].y * fscale );
+
+            sprintf( text, "*%%\n" );
+            break;
         }
 
         fputs( cbuf, outputFile );
@@ -797,8 +913,26 @@ void GERBER_PLOTTER::FlashPadRoundRect( const wxPoint& aPadPos, const wxSize& aS
                                      EDA_DRAW_MODE_T aTraceMode, void* aData )
 
 {
-    // Currently, a Pad RoundRect is plotted as polygon.
-    // TODO: use Aperture macro and flash it
+    wxSize innerSize( aSize.x - 2 * aCornerRadius, aSize.y - 2 * aCornerRadius );
+
+    // In compact mode, the pad is flashed with the RoundRect aperture macro
+    if( m_compactOutput && aTraceMode == FILLED && aCornerRadius > 0
+        && innerSize.x > 0 && innerSize.y > 0 )
+    {
+        wxPoint corners[4];
+        corners[0] = wxPoint( -innerSize.x / 2, -innerSize.y / 2 );
+        corners[1] = wxPoint(  innerSize.x / 2, -innerSize.y / 2 );
+        corners[2] = wxPoint(  innerSize.x / 2,  innerSize.y / 2 );
+        corners[3] = wxPoint( -innerSize.x / 2,  innerSize.y / 2 );
+
+        for( int ii = 0; ii < 4; ii++ )
+            RotatePoint( &corners[ii], aOrient );
+
+        flashMacroAperture( aPadPos, APERTURE::RoundRect, corners, aCornerRadius, aData );
+        return;
+    }
+
+    // Otherwise, a Pad RoundRect is plotted as polygon.
     SHAPE_POLY_SET outline;
     const int segmentToCircleCount = 64;
     TransformRoundRectToPolygon( outline, aPadPos, aSize, aOrient,
@@ -882,8 +1016,22 @@ void GERBER_PLOTTER::FlashPadTrapez( const wxPoint& aPadPos,  const wxPoint* aCo
                                      double aPadOrient, EDA_DRAW_MODE_T aTrace_Mode, void* aData )
 
 {
-    // Currently, a Pad Trapezoid is plotted as polygon.
-    // TODO: use Aperture macro and flash it
+    // In compact mode, the pad is flashed with the Outline4P aperture macro
+    if( m_compactOutput && aTrace_Mode == FILLED )
+    {
+        wxPoint corners[4];
+
+        for( int ii = 0; ii < 4; ii++ )
+        {
+            corners[ii] = aCorners[ii];
+            RotatePoint( &corners[ii], aPadOrient );
+        }
+
+        flashMacroAperture( aPadPos, APERTURE::Outline4P, corners, 0, aData );
+        return;
+    }
+
+    // Otherwise, a Pad Trapezoid is plotted as polygon.
 
     // polygon corners list
     std::vector< wxPoint > cornerList;
@@ -936,6 +1084,85 @@ void GERBER_PLOTTER::FlashPadTrapez( const wxPoint& aPadPos,  const wxPoint* aCo
 }
 
 
+// Build the closed corner list of a polygon outline
+static void outlineToCornerList( const SHAPE_LINE_CHAIN& aOutline, std::vector<wxPoint>& aCornerList )
+{
+    aCornerList.clear();
+
+    for( int ii = 0; ii < aOutline.PointCount(); ++ii )
+        aCornerList.push_back( wxPoint( aOutline.CPoint( ii ).x, aOutline.CPoint( ii ).y ) );
+
+    // Close polygon
+    if( !aCornerList.empty() )
+        aCornerList.push_back( aCornerList[0] );
+}
+
+
+void GERBER_PLOTTER::PlotRegions( const SHAPE_POLY_SET& aPolygons, int aWidth, void* aData )
+{
+    std::vector<wxPoint> cornerList;
+
+    if( !m_compactOutput )
+    {
+        for( int cnt = 0; cnt < aPolygons.OutlineCount(); ++cnt )
+        {
+            outlineToCornerList( aPolygons.COutline( cnt ), cornerList );
+
+            if( cornerList.size() > 2 )
+                PlotPoly( cornerList, FILLED_SHAPE, aWidth, aData );
+        }
+
+        return;
+    }
+
+    SetCurrentLineWidth( aWidth, aData );
+
+    GBR_METADATA* gbr_metadata = static_cast<GBR_METADATA*>( aData );
+
+    if( gbr_metadata )
+        formatNetAttribute( &gbr_metadata->m_NetlistMetadata );
+
+    // All the outlines are written in a single region statement
+    fputs( "G36*\n", outputFile );
+
+    for( int cnt = 0; cnt < aPolygons.OutlineCount(); ++cnt )
+    {
+        outlineToCornerList( aPolygons.COutline( cnt ), cornerList );
+
+        if( cornerList.size() <= 2 )
+            continue;
+
+        MoveTo( cornerList[0] );
+
+        for( unsigned ii = 1; ii < cornerList.size() - 1; ii++ )
+            LineTo( cornerList[ii] );
+
+        FinishTo( cornerList[0] );
+    }
+
+    fputs( "G37*\n", outputFile );
+
+    // Draw the outlines with the pen width, like PlotPoly does
+    if( aWidth > 0 )
+    {
+        for( int cnt = 0; cnt < aPolygons.OutlineCount(); ++cnt )
+        {
+            outlineToCornerList( aPolygons.COutline( cnt ), cornerList );
+
+            if( cornerList.size() <= 2 )
+                continue;
+
+            MoveTo( cornerList[0] );
+
+            for( unsigned ii = 1; ii < cornerList.size(); ii++ )
+                LineTo( cornerList[ii] );
+
+            PenFinish();
+        }
+    }
+}
+
+
 void GERBER_PLOTTER::Text( const wxPoint& aPos, enum EDA_COLOR_T aColor,
                            const wxString& aText, double aOrient, const wxSize& aSize,
                            enum EDA_TEXT_HJUSTIFY_T aH_justify, enum EDA_TEXT_VJUSTIFY_T aV_justify,
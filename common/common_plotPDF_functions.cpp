@@ -39,6 +39,111 @@
 #include <wx/zstream.h>
 #include <wx/mstream.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+/// Closed pages are written as soon as their uncompressed streams exceed this size
+#define PDF_PENDING_BYTES_MAX   ( 32 * 1024 * 1024 )
+
+
+/**
+ * Function formatNumber
+ * writes aValue to aBuf exactly as printf( "%g" ) would, without the cost of
+ * parsing a format; page streams are mostly made of such numbers.
+ * @param aBuf receives the text and must hold at least 32 bytes
+ * @return the length of the text
+ */
+static int formatNumber( char* aBuf, double aValue )
+{
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    static const double decade[] = { 1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5 };
+
+    double magnitude = std::fabs( aValue );
+
+    if( magnitude == 0.0 )
+        return sprintf( aBuf, std::signbit( aValue ) ? "-0" : "0" );
+
+    // %g switches to the exponent form out of [1e-4, 1e6); leave that and
+    // the non finite values to printf
+    if( !( magnitude >= 1e-4 && magnitude < 999999.0 ) )
+        return sprintf( aBuf, "%g", aValue );
+
+    // decimal exponent of the leading digit
+    int exponent = 5;
+
+    while( exponent > -4 && magnitude < decade[exponent + 4] )
+        --exponent;
+
+    // 6 significant digits
+    int     decimals = 5 - exponent;
+    double  scaled   = magnitude * pow10[decimals];
+    double  fraction = scaled - floor( scaled );
+
+    // the product can be one ulp off, so the near ties are left to printf
+    if( std::fabs( fraction - 0.5 ) < 1e-6 )
+        return sprintf( aBuf, "%g", aValue );
+
+    long long mantissa = (long long) floor( scaled + 0.5 );
+
+    // the rounding carried into the next decade (9.999995 -> 10)
+    if( mantissa >= 1000000 )
+    {
+        mantissa /= 10;
+        --decimals;
+    }
+
+    return FixedPointToStr( aBuf, aValue < 0 ? -mantissa : mantissa, decimals );
+}
+
+
+/**
+ * Function appendNumber
+ * appends aValue in %g format and a separating space to a page stream
+ */
+static inline void appendNumber( std::string& aOut, double aValue )
+{
+    char buf[32];
+    int  len = formatNumber( buf, aValue );
+
+    buf[len++] = ' ';
+    aOut.append( buf, len );
+}
+
+
+/**
+ * Function deflateStream
+ * compresses a page content stream to the zlib format required by /FlateDecode.
+ * Pages are independent, so this may run concurrently for different pages.
+ */
+static void deflateStream( const std::string& aContent, std::string& aDeflated )
+{
+    // NULL means memos owns the memory, but provide a hint on optimum size needed.
+    wxMemoryOutputStream    memos( NULL, std::max( (size_t) 2000, aContent.size() ) );
+
+    {
+        /* Somewhat standard parameters to compress in DEFLATE. The PDF spec is
+         * misleading, it says it wants a DEFLATE stream but it really want a ZLIB
+         * stream! (a DEFLATE stream would be generated with -15 instead of 15)
+         * rc = deflateInit2( &zstrm, Z_BEST_COMPRESSION, Z_DEFLATED, 15,
+         *                    8, Z_DEFAULT_STRATEGY );
+         */
+
+        wxZlibOutputStream      zos( memos, wxZ_BEST_COMPRESSION, wxZLIB_ZLIB );
+
+        zos.Write( aContent.data(), aContent.size() );
+
+    }   // flush the zip stream using zos destructor
+
+    wxStreamBuffer* sb = memos.GetOutputStreamBuffer();
+
+    aDeflated.assign( (const char*) sb->GetBufferStart(), sb->Tell() );
+}
+
 
 /*
  * Open or create the plot file aFullFilename
@@ -63,14 +168,14 @@ bool PDF_PLOTTER::OpenFile( const wxString& aFullFilename )
 
 void PDF_PLOTTER::SetPageSettings( const PAGE_INFO& aPageSettings )
 {
-    wxASSERT( !workFile );
+    wxASSERT( !workStream );
     pageInfo = aPageSettings;
 }
 
 void PDF_PLOTTER::SetViewport( const wxPoint& aOffset, double aIusPerDecimil,
                               double aScale, bool aMirror )
 {
-    wxASSERT( !workFile );
+    wxASSERT( !workStream );
     m_plotMirror = aMirror;
     plotOffset = aOffset;
     plotScale = aScale;
@@ -96,7 +201,7 @@ void PDF_PLOTTER::SetViewport( const wxPoint& aOffset, double aIusPerDecimil,
  */
 void PDF_PLOTTER::SetCurrentLineWidth( int width, void* aData )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     int pen_width;
 
     if( width > 0 )
@@ -107,8 +212,10 @@ void PDF_PLOTTER::SetCurrentLineWidth( int width, void* aData )
         pen_width = defaultPenWidth;
 
     if( pen_width != currentPenWidth )
-        fprintf( workFile, "%g w\n",
-                 userToDeviceSize( pen_width ) );
+    {
+        appendNumber( *workStream, userToDeviceSize( pen_width ) );
+        *workStream += "w\n";
+    }
 
     currentPenWidth = pen_width;
 }
@@ -125,9 +232,15 @@ void PDF_PLOTTER::SetCurrentLineWidth( int width, void* aData )
  */
 void PDF_PLOTTER::emitSetRGBColor( double r, double g, double b )
 {
-    wxASSERT( workFile );
-    fprintf( workFile, "%g %g %g rg %g %g %g RG\n",
-             r, g, b, r, g, b );
+    wxASSERT( workStream );
+    appendNumber( *workStream, r );
+    appendNumber( *workStream, g );
+    appendNumber( *workStream, b );
+    *workStream += "rg ";
+    appendNumber( *workStream, r );
+    appendNumber( *workStream, g );
+    appendNumber( *workStream, b );
+    *workStream += "RG\n";
 }
 
 /**
@@ -135,12 +248,12 @@ void PDF_PLOTTER::emitSetRGBColor( double r, double g, double b )
  */
 void PDF_PLOTTER::SetDash( bool dashed )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     if( dashed )
-        fprintf( workFile, "[%d %d] 0 d\n",
-                 (int) GetDashMarkLenIU(), (int) GetDashGapLenIU() );
+        workPrintf( "[%d %d] 0 d\n",
+                    (int) GetDashMarkLenIU(), (int) GetDashGapLenIU() );
     else
-        fputs( "[] 0 d\n", workFile );
+        *workStream += "[] 0 d\n";
 }
 
 
@@ -149,14 +262,14 @@ void PDF_PLOTTER::SetDash( bool dashed )
  */
 void PDF_PLOTTER::Rect( const wxPoint& p1, const wxPoint& p2, FILL_T fill, int width )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     DPOINT p1_dev = userToDeviceCoordinates( p1 );
     DPOINT p2_dev = userToDeviceCoordinates( p2 );
 
     SetCurrentLineWidth( width );
-    fprintf( workFile, "%g %g %g %g re %c\n", p1_dev.x, p1_dev.y,
-             p2_dev.x - p1_dev.x, p2_dev.y - p1_dev.y,
-             fill == NO_FILL ? 'S' : 'B' );
+    workCoord( p1_dev.x, p1_dev.y, "" );
+    workCoord( p2_dev.x - p1_dev.x, p2_dev.y - p1_dev.y,
+               fill == NO_FILL ? "re S\n" : "re B\n" );
 }
 
 
@@ -165,7 +278,7 @@ void PDF_PLOTTER::Rect( const wxPoint& p1, const wxPoint& p2, FILL_T fill, int w
  */
 void PDF_PLOTTER::Circle( const wxPoint& pos, int diametre, FILL_T aFill, int width )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     DPOINT pos_dev = userToDeviceCoordinates( pos );
     double radius = userToDeviceSize( diametre / 2.0 );
 
@@ -179,30 +292,24 @@ void PDF_PLOTTER::Circle( const wxPoint& pos, int diametre, FILL_T aFill, int wi
     double magic = radius * 0.551784; // You don't want to know where this come from
 
     // This is the convex hull for the bezier approximated circle
-    fprintf( workFile, "%g %g m "
-                       "%g %g %g %g %g %g c "
-                       "%g %g %g %g %g %g c "
-                       "%g %g %g %g %g %g c "
-                       "%g %g %g %g %g %g c %c\n",
-             pos_dev.x - radius, pos_dev.y,
-
-             pos_dev.x - radius, pos_dev.y + magic,
-             pos_dev.x - magic, pos_dev.y + radius,
-             pos_dev.x, pos_dev.y + radius,
-
-             pos_dev.x + magic, pos_dev.y + radius,
-             pos_dev.x + radius, pos_dev.y + magic,
-             pos_dev.x + radius, pos_dev.y,
-
-             pos_dev.x + radius, pos_dev.y - magic,
-             pos_dev.x + magic, pos_dev.y - radius,
-             pos_dev.x, pos_dev.y - radius,
-
-             pos_dev.x - magic, pos_dev.y - radius,
-             pos_dev.x - radius, pos_dev.y - magic,
-             pos_dev.x - radius, pos_dev.y,
-
-             aFill == NO_FILL ? 's' : 'b' );
+    workCoord( pos_dev.x - radius, pos_dev.y, "m " );
+
+    workCoord( pos_dev.x - radius, pos_dev.y + magic, "" );
+    workCoord( pos_dev.x - magic, pos_dev.y + radius, "" );
+    workCoord( pos_dev.x, pos_dev.y + radius, "c " );
+
+    workCoord( pos_dev.x + magic, pos_dev.y + radius, "" );
+    workCoord( pos_dev.x + radius, pos_dev.y + magic, "" );
+    workCoord( pos_dev.x + radius, pos_dev.y, "c " );
+
+    workCoord( pos_dev.x + radius, pos_dev.y - magic, "" );
+    workCoord( pos_dev.x + magic, pos_dev.y - radius, "" );
+    workCoord( pos_dev.x, pos_dev.y - radius, "c " );
+
+    workCoord( pos_dev.x - magic, pos_dev.y - radius, "" );
+    workCoord( pos_dev.x - radius, pos_dev.y - magic, "" );
+    workCoord( pos_dev.x - radius, pos_dev.y,
+               aFill == NO_FILL ? "c s\n" : "c b\n" );
 }
 
 
@@ -213,7 +320,7 @@ void PDF_PLOTTER::Circle( const wxPoint& pos, int diametre, FILL_T aFill, int wi
 void PDF_PLOTTER::Arc( const wxPoint& centre, double StAngle, double EndAngle, int radius,
                       FILL_T fill, int width )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     if( radius <= 0 )
         return;
 
@@ -231,30 +338,30 @@ void PDF_PLOTTER::Arc( const wxPoint& centre, double StAngle, double EndAngle, i
     start.x = centre.x + KiROUND( cosdecideg( radius, -StAngle ) );
     start.y = centre.y + KiROUND( sindecideg( radius, -StAngle ) );
     DPOINT pos_dev = userToDeviceCoordinates( start );
-    fprintf( workFile, "%g %g m ", pos_dev.x, pos_dev.y );
+    workCoord( pos_dev.x, pos_dev.y, "m " );
     for( int ii = StAngle + delta; ii < EndAngle; ii += delta )
     {
         end.x = centre.x + KiROUND( cosdecideg( radius, -ii ) );
         end.y = centre.y + KiROUND( sindecideg( radius, -ii ) );
         pos_dev = userToDeviceCoordinates( end );
-        fprintf( workFile, "%g %g l ", pos_dev.x, pos_dev.y );
+        workCoord( pos_dev.x, pos_dev.y, "l " );
     }
 
     end.x = centre.x + KiROUND( cosdecideg( radius, -EndAngle ) );
     end.y = centre.y + KiROUND( sindecideg( radius, -EndAngle ) );
     pos_dev = userToDeviceCoordinates( end );
-    fprintf( workFile, "%g %g l ", pos_dev.x, pos_dev.y );
+    workCoord( pos_dev.x, pos_dev.y, "l " );
 
     // The arc is drawn... if not filled we stroke it, otherwise we finish
     // closing the pie at the center
     if( fill == NO_FILL )
     {
-        fputs( "S\n", workFile );
+        *workStream += "S\n";
     }
     else
     {
         pos_dev = userToDeviceCoordinates( centre );
-        fprintf( workFile, "%g %g l b\n", pos_dev.x, pos_dev.y );
+        workCoord( pos_dev.x, pos_dev.y, "l b\n" );
     }
 }
 
@@ -265,34 +372,34 @@ void PDF_PLOTTER::Arc( const wxPoint& centre, double StAngle, double EndAngle, i
 void PDF_PLOTTER::PlotPoly( const std::vector< wxPoint >& aCornerList,
                            FILL_T aFill, int aWidth, void * aData )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     if( aCornerList.size() <= 1 )
         return;
 
     SetCurrentLineWidth( aWidth );
 
     DPOINT pos = userToDeviceCoordinates( aCornerList[0] );
-    fprintf( workFile, "%g %g m\n", pos.x, pos.y );
+    workCoord( pos.x, pos.y, "m\n" );
 
     for( unsigned ii = 1; ii < aCornerList.size(); ii++ )
     {
         pos = userToDeviceCoordinates( aCornerList[ii] );
-        fprintf( workFile, "%g %g l\n", pos.x, pos.y );
+        workCoord( pos.x, pos.y, "l\n" );
     }
 
     // Close path and stroke(/fill)
-    fprintf( workFile, "%c\n", aFill == NO_FILL ? 'S' : 'b' );
+    *workStream += aFill == NO_FILL ? "S\n" : "b\n";
 }
 
 
 void PDF_PLOTTER::PenTo( const wxPoint& pos, char plume )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     if( plume == 'Z' )
     {
         if( penState != 'Z' )
         {
-            fputs( "S\n", workFile );
+            *workStream += "S\n";
             penState     = 'Z';
             penLastpos.x = -1;
             penLastpos.y = -1;
@@ -303,9 +410,7 @@ void PDF_PLOTTER::PenTo( const wxPoint& pos, char plume )
     if( penState != plume || pos != penLastpos )
     {
         DPOINT pos_dev = userToDeviceCoordinates( pos );
-        fprintf( workFile, "%g %g %c\n",
-                 pos_dev.x, pos_dev.y,
-                 ( plume=='D' ) ? 'l' : 'm' );
+        workCoord( pos_dev.x, pos_dev.y, ( plume=='D' ) ? "l\n" : "m\n" );
     }
     penState   = plume;
     penLastpos = pos;
@@ -317,7 +422,7 @@ void PDF_PLOTTER::PenTo( const wxPoint& pos, char plume )
 void PDF_PLOTTER::PlotImage( const wxImage & aImage, const wxPoint& aPos,
                             double aScaleFactor )
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
     wxSize pix_size( aImage.GetWidth(), aImage.GetHeight() );
 
     // Requested size (in IUs)
@@ -340,7 +445,7 @@ void PDF_PLOTTER::PlotImage( const wxImage & aImage, const wxPoint& aPos,
        3) restore the CTM
        4) profit
      */
-    fprintf( workFile, "q %g 0 0 %g %g %g cm\n", // Step 1
+    workPrintf( "q %g 0 0 %g %g %g cm\n", // Step 1
             userToDeviceSize( drawsize.x ),
             userToDeviceSize( drawsize.y ),
             dev_start.x, dev_start.y );
@@ -349,16 +454,17 @@ void PDF_PLOTTER::PlotImage( const wxImage & aImage, const wxPoint& aPos,
        A real ugly construct (compared with the elegance of the PDF
        format). Also it accepts some 'abbreviations', which is stupid
        since the content stream is usually compressed anyway... */
-    fprintf( workFile,
-             "BI\n"
-             "  /BPC 8\n"
-             "  /CS %s\n"
-             "  /W %d\n"
-             "  /H %d\n"
-             "ID\n", colorMode ? "/RGB" : "/G", pix_size.x, pix_size.y );
+    workPrintf( "BI\n"
+                "  /BPC 8\n"
+                "  /CS %s\n"
+                "  /W %d\n"
+                "  /H %d\n"
+                "ID\n", colorMode ? "/RGB" : "/G", pix_size.x, pix_size.y );
 
     /* Here comes the stream (in binary!). I *could* have hex or ascii84
        encoded it, but who cares? I'll go through zlib anyway */
+    workStream->reserve( workStream->size() + pix_size.x * pix_size.y * ( colorMode ? 3 : 1 ) );
+
     for( int y = 0; y < pix_size.y; y++ )
     {
         for( int x = 0; x < pix_size.x; x++ )
@@ -366,22 +472,21 @@ void PDF_PLOTTER::PlotImage( const wxImage & aImage, const wxPoint& aPos,
             unsigned char r = aImage.GetRed( x, y ) & 0xFF;
             unsigned char g = aImage.GetGreen( x, y ) & 0xFF;
             unsigned char b = aImage.GetBlue( x, y ) & 0xFF;
-            // As usual these days, stdio buffering has to suffeeeeerrrr
             if( colorMode )
             {
-            putc( r, workFile );
-            putc( g, workFile );
-            putc( b, workFile );
+                *workStream += (char) r;
+                *workStream += (char) g;
+                *workStream += (char) b;
             }
             else
             {
                 // Grayscale conversion
-                putc( (r + g + b) / 3, workFile );
+                *workStream += (char) ( (r + g + b) / 3 );
             }
         }
     }
 
-    fputs( "EI Q\n", workFile ); // Finish step 2 and do step 3
+    *workStream += "EI Q\n"; // Finish step 2 and do step 3
 }
 
 
@@ -404,7 +509,7 @@ int PDF_PLOTTER::allocPdfObject()
 int PDF_PLOTTER::startPdfObject(int handle)
 {
     wxASSERT( outputFile );
-    wxASSERT( !workFile );
+    wxASSERT( !workStream );
     if( handle < 0)
         handle = allocPdfObject();
 
@@ -420,7 +525,7 @@ int PDF_PLOTTER::startPdfObject(int handle)
 void PDF_PLOTTER::closePdfObject()
 {
     wxASSERT( outputFile );
-    wxASSERT( !workFile );
+    wxASSERT( !workStream );
     fputs( "endobj\n", outputFile );
 }
 
@@ -429,98 +534,166 @@ void PDF_PLOTTER::closePdfObject()
  * Starts a PDF stream (for the page). Returns the object handle opened
  * Pass -1 (default) for a fresh object. Especially from PDF 1.5 streams
  * can contain a lot of things, but for the moment we only handle page
- * content.
+ * content. The stream is accumulated in memory; its object is written
+ * by flushPdfPages once the page is closed.
  */
 int PDF_PLOTTER::startPdfStream(int handle)
 {
     wxASSERT( outputFile );
-    wxASSERT( !workFile );
-    handle = startPdfObject( handle );
+    wxASSERT( !workStream );
+    if( handle < 0 )
+        handle = allocPdfObject();
 
-    // This is guaranteed to be handle+1 but needs to be allocated since
-    // you could allocate more object during stream preparation
+    // The length is only known once compressed, so it goes in a deferred object
     streamLengthHandle = allocPdfObject();
-    fprintf( outputFile,
-             "<< /Length %d 0 R /Filter /FlateDecode >>\n" // Length is deferred
-             "stream\n", handle + 1 );
 
-    // Open a temporary file to accumulate the stream
-    workFilename = filename + wxT(".tmp");
-    workFile = wxFopen( workFilename, wxT( "w+b" ));
-    wxASSERT( workFile );
+    pendingPages.push_back( PDF_PAGE_STREAM() );
+
+    PDF_PAGE_STREAM& page = pendingPages.back();
+    page.streamHandle = handle;
+    page.lengthHandle = streamLengthHandle;
+    page.pageHandle   = 0;
+
+    workStream = &page.content;
     return handle;
 }
 
 
 /**
- * Finish the current PDF stream (writes the deferred length, too)
+ * Finish the current PDF stream; it stays pending until flushPdfPages
  */
 void PDF_PLOTTER::closePdfStream()
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
+
+    pendingBytes += workStream->size();
+    workStream = NULL;
+}
 
-    long stream_len = ftell( workFile );
 
-    if( stream_len < 0 )
+/**
+ * Compress the streams of the pending pages and write them with their
+ * length and page objects, in page order. The deflating, which is most
+ * of the work, runs for several pages at once.
+ */
+void PDF_PLOTTER::flushPdfPages()
+{
+    wxASSERT( outputFile );
+    wxASSERT( !workStream );
+
+    const int count = pendingPages.size();
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for( int i = 0; i < count; ++i )
     {
-        wxASSERT( false );
-        return;
+        PDF_PAGE_STREAM& page = pendingPages[i];
+
+        deflateStream( page.content, page.deflated );
+        std::string().swap( page.content );
     }
 
-    // Rewind the file, read in the page stream and DEFLATE it
-    fseek( workFile, 0, SEEK_SET );
-    unsigned char *inbuf = new unsigned char[stream_len];
+    for( int i = 0; i < count; ++i )
+    {
+        const PDF_PAGE_STREAM& page = pendingPages[i];
 
-    int rc = fread( inbuf, 1, stream_len, workFile );
-    wxASSERT( rc == stream_len );
-    (void) rc;
+        startPdfObject( page.streamHandle );
+        fprintf( outputFile,
+                 "<< /Length %d 0 R /Filter /FlateDecode >>\n" // Length is deferred
+                 "stream\n", page.lengthHandle );
+        fwrite( page.deflated.data(), 1, page.deflated.size(), outputFile );
+        fputs( "endstream\n", outputFile );
+        closePdfObject();
 
-    // We are done with the temporary file, junk it
-    fclose( workFile );
-    workFile = 0;
-    ::wxRemoveFile( workFilename );
+        // Writing the deferred length as an indirect object
+        startPdfObject( page.lengthHandle );
+        fprintf( outputFile, "%u\n", (unsigned) page.deflated.size() );
+        closePdfObject();
 
-    // NULL means memos owns the memory, but provide a hint on optimum size needed.
-    wxMemoryOutputStream    memos( NULL, std::max( 2000l, stream_len ) ) ;
+        /* Page size is in 1/72 of inch (default user space units)
+           Works like the bbox in postscript but there is no need for
+           swapping the sizes, since PDF doesn't require a portrait page.
+           We use the MediaBox but PDF has lots of other less used boxes
+           to use */
+        startPdfObject( page.pageHandle );
+        fprintf( outputFile,
+                 "<<\n"
+                 "/Type /Page\n"
+                 "/Parent %d 0 R\n"
+                 "/Resources <<\n"
+                 "    /ProcSet [/PDF /Text /ImageC /ImageB]\n"
+                 "    /Font %d 0 R >>\n"
+                 "/MediaBox [0 0 %d %d]\n"
+                 "/Contents %d 0 R\n"
+                 ">>\n",
+                 pageTreeHandle,
+                 fontResDictHandle,
+                 page.mediaBox.x,
+                 page.mediaBox.y,
+                 page.streamHandle );
+        closePdfObject();
+    }
 
-    {
-        /* Somewhat standard parameters to compress in DEFLATE. The PDF spec is
-         * misleading, it says it wants a DEFLATE stream but it really want a ZLIB
-         * stream! (a DEFLATE stream would be generated with -15 instead of 15)
-         * rc = deflateInit2( &zstrm, Z_BEST_COMPRESSION, Z_DEFLATED, 15,
-         *                    8, Z_DEFAULT_STRATEGY );
-         */
+    pendingPages.clear();
+    pendingBytes = 0;
+}
 
-        wxZlibOutputStream      zos( memos, wxZ_BEST_COMPRESSION, wxZLIB_ZLIB );
 
-        zos.Write( inbuf, stream_len );
+/**
+ * Append printf formatted text to the content stream of the open page
+ */
+void PDF_PLOTTER::workPrintf( const char* aFormat, ... )
+{
+    wxASSERT( workStream );
 
-        delete[] inbuf;
+    char    buf[256];
+    va_list args;
 
-    }   // flush the zip stream using zos destructor
+    va_start( args, aFormat );
+    int len = vsnprintf( buf, sizeof(buf), aFormat, args );
+    va_end( args );
 
-    wxStreamBuffer* sb = memos.GetOutputStreamBuffer();
+    if( len < 0 )
+        return;
 
-    unsigned out_count = sb->Tell();
+    if( len < (int) sizeof(buf) )
+    {
+        workStream->append( buf, len );
+        return;
+    }
 
-    fwrite( sb->GetBufferStart(), 1, out_count, outputFile );
+    std::vector<char> bigbuf( len + 1 );
 
-    fputs( "endstream\n", outputFile );
-    closePdfObject();
+    va_start( args, aFormat );
+    vsnprintf( &bigbuf[0], bigbuf.size(), aFormat, args );
+    va_end( args );
 
-    // Writing the deferred length as an indirect object
-    startPdfObject( streamLengthHandle );
-    fprintf( outputFile, "%u\n", out_count );
-    closePdfObject();
+    workStream->append( &bigbuf[0], len );
 }
 
+
+/**
+ * Append a coordinate pair (as "%g %g ") and then aOperator to the content
+ * stream of the open page
+ */
+void PDF_PLOTTER::workCoord( double x, double y, const char* aOperator )
+{
+    wxASSERT( workStream );
+
+    appendNumber( *workStream, x );
+    appendNumber( *workStream, y );
+    *workStream += aOperator;
+}
+
+
 /**
  * Starts a new page in the PDF document
  */
 void PDF_PLOTTER::StartPage()
 {
     wxASSERT( outputFile );
-    wxASSERT( !workFile );
+    wxASSERT( !workStream );
 
     // Compute the paper size in IUs
     paperSize = pageInfo.GetSizeMils();
@@ -530,57 +703,50 @@ void PDF_PLOTTER::StartPage()
     // Open the content stream; the page object will go later
     pageStreamHandle = startPdfStream();
 
-    /* Now, until ClosePage *everything* must be wrote in workFile, to be
-       compressed later in closePdfStream */
+    /* Now, until ClosePage *everything* must be wrote in workStream, to be
+       compressed later in flushPdfPages */
 
     // Default graphic settings (coordinate system, default color and line style)
-    fprintf( workFile,
-             "%g 0 0 %g 0 0 cm 1 J 1 j 0 0 0 rg 0 0 0 RG %g w\n",
-             0.0072 * plotScaleAdjX, 0.0072 * plotScaleAdjY,
-             userToDeviceSize( defaultPenWidth ) );
+    workPrintf( "%g 0 0 %g 0 0 cm 1 J 1 j 0 0 0 rg 0 0 0 RG %g w\n",
+                0.0072 * plotScaleAdjX, 0.0072 * plotScaleAdjY,
+                userToDeviceSize( defaultPenWidth ) );
 }
 
 /**
- * Close the current page in the PDF document (and emit its compressed stream)
+ * Close the current page in the PDF document. Its compressed stream and
+ * page object are written when enough pages are pending to be deflated
+ * together, or at the end of the plot.
  */
 void PDF_PLOTTER::ClosePage()
 {
-    wxASSERT( workFile );
+    wxASSERT( workStream );
 
-    // Close the page stream (and compress it)
+    // Close the page stream
     closePdfStream();
 
-    // Emit the page object and put it in the page list for later
-    pageHandles.push_back( startPdfObject() );
+    // Allocate the page object and put it in the page list for later
+    PDF_PAGE_STREAM& page = pendingPages.back();
 
-    /* Page size is in 1/72 of inch (default user space units)
-       Works like the bbox in postscript but there is no need for
-       swapping the sizes, since PDF doesn't require a portrait page.
-       We use the MediaBox but PDF has lots of other less used boxes
-       to use */
+    page.pageHandle = allocPdfObject();
+    pageHandles.push_back( page.pageHandle );
 
     const double BIGPTsPERMIL = 0.072;
     wxSize psPaperSize = pageInfo.GetSizeMils();
 
-    fprintf( outputFile,
-             "<<\n"
-             "/Type /Page\n"
-             "/Parent %d 0 R\n"
-             "/Resources <<\n"
-             "    /ProcSet [/PDF /Text /ImageC /ImageB]\n"
-             "    /Font %d 0 R >>\n"
-             "/MediaBox [0 0 %d %d]\n"
-             "/Contents %d 0 R\n"
-             ">>\n",
-             pageTreeHandle,
-             fontResDictHandle,
-             int( ceil( psPaperSize.x * BIGPTsPERMIL ) ),
-             int( ceil( psPaperSize.y * BIGPTsPERMIL ) ),
-             pageStreamHandle );
-    closePdfObject();
+    page.mediaBox.x = int( ceil( psPaperSize.x * BIGPTsPERMIL ) );
+    page.mediaBox.y = int( ceil( psPaperSize.y * BIGPTsPERMIL ) );
 
     // Mark the page stream as idle
     pageStreamHandle = 0;
+
+    size_t batchSize = 1;
+
+#ifdef USE_OPENMP
+    batchSize = omp_get_max_threads();
+#endif
+
+    if( pendingPages.size() >= batchSize || pendingBytes >= PDF_PENDING_BYTES_MAX )
+        flushPdfPages();
 }
 
 /**
@@ -621,8 +787,9 @@ bool PDF_PLOTTER::EndPlot()
 {
     wxASSERT( outputFile );
 
-    // Close the current page (often the only one)
+    // Close the current page (often the only one) and write the pending ones
     ClosePage();
+    flushPdfPages();
 
     /* We need to declare the resources we're using (fonts in particular)
        The useful standard one is the Helvetica family. Adding external fonts
@@ -789,15 +956,15 @@ void PDF_PLOTTER::Text( const wxPoint&              aPos,
            for the trig part of the matrix to avoid %g going in exponential
            format (which is not supported)
            Rendermode 0 shows the text, rendermode 3 is invisible */
-        fprintf( workFile, "q %f %f %f %f %g %g cm BT %s %g Tf %d Tr %g Tz ",
-                ctm_a, ctm_b, ctm_c, ctm_d, ctm_e, ctm_f,
-                fontname, heightFactor,
-                (m_textMode == PLOTTEXTMODE_NATIVE) ? 0 : 3,
-                wideningFactor * 100 );
+        workPrintf( "q %f %f %f %f %g %g cm BT %s %g Tf %d Tr %g Tz ",
+                    ctm_a, ctm_b, ctm_c, ctm_d, ctm_e, ctm_f,
+                    fontname, heightFactor,
+                    (m_textMode == PLOTTEXTMODE_NATIVE) ? 0 : 3,
+                    wideningFactor * 100 );
 
         // The text must be escaped correctly
-        fputsPostscriptString( workFile, aText );
-        fputs( " Tj ET\n", workFile );
+        appendPostscriptString( *workStream, aText );
+        *workStream += " Tj ET\n";
 
         /* We are still in text coordinates, plot the overbars (if we're
          * not doing phantom text) */
@@ -814,13 +981,13 @@ void PDF_PLOTTER::Text( const wxPoint&              aPos,
                    is the right function to use here... */
                 DPOINT dev_from = userToDeviceSize( wxSize( pos_pairs[i], overbar_y ) );
                 DPOINT dev_to = userToDeviceSize( wxSize( pos_pairs[i + 1], overbar_y ) );
-                fprintf( workFile, "%g %g m %g %g l ",
-                        dev_from.x, dev_from.y, dev_to.x, dev_to.y );
+                workCoord( dev_from.x, dev_from.y, "m " );
+                workCoord( dev_to.x, dev_to.y, "l " );
             }
         }
 
         // Stroke and restore the CTM
-        fputs( "S Q\n", workFile );
+        *workStream += "S Q\n";
     }
 
     // Plot the stroked text (if requested)
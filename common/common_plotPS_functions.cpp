@@ -143,9 +143,8 @@ void PSLIKE_PLOTTER::FlashPadCircle( const wxPoint& aPadPos, int aDiameter,
 void PSLIKE_PLOTTER::FlashPadRect( const wxPoint& aPadPos, const wxSize& aSize,
                                    double aPadOrient, EDA_DRAW_MODE_T aTraceMode, void* aData )
 {
-    static std::vector< wxPoint > cornerList;
+    std::vector< wxPoint > cornerList;
     wxSize size( aSize );
-    cornerList.clear();
 
     if( aTraceMode == FILLED )
         SetCurrentLineWidth( 0 );
@@ -263,8 +262,7 @@ void PSLIKE_PLOTTER::FlashPadCustom( const wxPoint& aPadPos, const wxSize& aSize
 void PSLIKE_PLOTTER::FlashPadTrapez( const wxPoint& aPadPos, const wxPoint *aCorners,
                                      double aPadOrient, EDA_DRAW_MODE_T aTraceMode, void* aData )
 {
-    static std::vector< wxPoint > cornerList;
-    cornerList.clear();
+    std::vector< wxPoint > cornerList;
 
     for( int ii = 0; ii < 4; ii++ )
         cornerList.push_back( aCorners[ii] );
@@ -311,10 +309,23 @@ void PSLIKE_PLOTTER::FlashPadTrapez( const wxPoint& aPadPos, const wxPoint *aCor
  */
 void PSLIKE_PLOTTER::fputsPostscriptString(FILE *fout, const wxString& txt)
 {
-    putc( '(', fout );
+    std::string escaped;
+
+    appendPostscriptString( escaped, txt );
+    fwrite( escaped.data(), 1, escaped.size(), fout );
+}
+
+
+/**
+ * Append a postscript string literal, escaped and parenthesized, to aOut
+ * (the PDF plotter builds its page streams in memory)
+ */
+void PSLIKE_PLOTTER::appendPostscriptString( std::string& aOut, const wxString& txt )
+{
+    aOut += '(';
+
     for( unsigned i = 0; i < txt.length(); i++ )
     {
-        // Lazyness made me use stdio buffering yet another time...
         wchar_t ch = txt[i];
 
         if( ch < 256 )
@@ -328,17 +339,17 @@ void PSLIKE_PLOTTER::fputsPostscriptString(FILE *fout, const wxString& txt)
             case '(':
             case ')':
             case '\\':
-                putc( '\\', fout );
+                aOut += '\\';
 
                 // FALLTHRU
             default:
-                putc( ch, fout );
+                aOut += (char) ch;
                 break;
             }
         }
     }
 
-    putc( ')', fout );
+    aOut += ')';
 }
 
 
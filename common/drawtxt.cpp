@@ -38,9 +38,18 @@
 #include <macros.h>
 #include <class_drawpanel.h>
 #include <class_base_screen.h>
+#include <hashtables.h>
 
 #include <basic_gal.h>
 
+#include <unordered_map>
+
+
+/* The stroked texts are cached until they hold this many points (32 MB), then the cache
+ * is emptied and filled again.
+ */
+#define TEXT_STROKES_CACHE_MAX_POINTS   4000000
+
 /**
  * Function GetPensizeForBold
  * @return the "best" value for a pen size to draw/plot a bold text
@@ -87,6 +96,8 @@ int Clamp_Text_PenSize( int aPenSize, wxSize aSize, bool aBold )
 
 int GraphicTextWidth( const wxString& aText, const wxSize& aSize, bool aItalic, bool aBold )
 {
+    MUTLOCK lock( basic_galLock );
+
     basic_gal.SetFontItalic( aItalic );
     basic_gal.SetFontBold( aBold );
     basic_gal.SetGlyphSize( VECTOR2D( aSize ) );
@@ -97,6 +108,164 @@ int GraphicTextWidth( const wxString& aText, const wxSize& aSize, bool aItalic,
 }
 
 
+/**
+ * Function setTextAttributes
+ * sets the basic_gal font and pen for a text drawn by DrawGraphicText.
+ * The caller must hold basic_galLock.
+ */
+static void setTextAttributes( const wxSize& aSize,
+                               enum EDA_TEXT_HJUSTIFY_T aH_justify,
+                               enum EDA_TEXT_VJUSTIFY_T aV_justify,
+                               int aWidth, bool aFill, bool aItalic, bool aBold )
+{
+    basic_gal.SetIsFill( aFill );
+    basic_gal.SetLineWidth( aWidth );
+
+    EDA_TEXT dummy;
+    dummy.SetItalic( aItalic );
+    dummy.SetBold( aBold );
+    dummy.SetHorizJustify( aH_justify );
+    dummy.SetVertJustify( aV_justify );
+
+    wxSize size = aSize;
+    dummy.SetMirrored( size.x < 0 );
+
+    if( size.x < 0 )
+        size.x = - size.x;
+
+    dummy.SetSize( size );
+
+    basic_gal.SetTextAttributes( &dummy );
+}
+
+
+/**
+ * Struct TEXT_STROKES_KEY
+ * holds everything the strokes of a text depend on.
+ */
+struct TEXT_STROKES_KEY
+{
+    wxString                 m_text;
+    wxPoint                  m_pos;
+    double                   m_orient;
+    wxSize                   m_size;
+    enum EDA_TEXT_HJUSTIFY_T m_hJustify;
+    enum EDA_TEXT_VJUSTIFY_T m_vJustify;
+    int                      m_width;
+    bool                     m_italic;
+    bool                     m_bold;
+
+    bool operator==( const TEXT_STROKES_KEY& aOther ) const
+    {
+        return m_pos == aOther.m_pos && m_orient == aOther.m_orient
+            && m_size == aOther.m_size && m_hJustify == aOther.m_hJustify
+            && m_vJustify == aOther.m_vJustify && m_width == aOther.m_width
+            && m_italic == aOther.m_italic && m_bold == aOther.m_bold
+            && m_text == aOther.m_text;
+    }
+};
+
+
+struct TEXT_STROKES_KEY_HASH
+{
+    static void combine( std::size_t& aHash, std::size_t aValue )
+    {
+        aHash ^= aValue + 0x9e3779b9 + ( aHash << 6 ) + ( aHash >> 2 );
+    }
+
+    std::size_t operator()( const TEXT_STROKES_KEY& aKey ) const
+    {
+        std::hash<int> hashInt;
+        std::size_t    hash = WXSTRING_HASH()( aKey.m_text );
+
+        combine( hash, hashInt( aKey.m_pos.x ) );
+        combine( hash, hashInt( aKey.m_pos.y ) );
+        combine( hash, std::hash<double>()( aKey.m_orient ) );
+        combine( hash, hashInt( aKey.m_size.x ) );
+        combine( hash, hashInt( aKey.m_size.y ) );
+        combine( hash, hashInt( aKey.m_width ) );
+        combine( hash, hashInt( aKey.m_hJustify * 16 + aKey.m_vJustify * 4
+                                + aKey.m_italic * 2 + aKey.m_bold ) );
+
+        return hash;
+    }
+};
+
+
+typedef std::unordered_map< TEXT_STROKES_KEY, std::shared_ptr<const TEXT_STROKES>,
+                            TEXT_STROKES_KEY_HASH > TEXT_STROKES_CACHE;
+
+// Guarded by basic_galLock
+static TEXT_STROKES_CACHE s_strokesCache;
+static size_t             s_strokesCachePoints = 0;
+
+
+std::shared_ptr<const TEXT_STROKES> GetGraphicTextStrokes( const wxPoint& aPos,
+                                                           const wxString& aText,
+                                                           double aOrient,
+                                                           const wxSize& aSize,
+                                                           enum EDA_TEXT_HJUSTIFY_T aH_justify,
+                                                           enum EDA_TEXT_VJUSTIFY_T aV_justify,
+                                                           int aWidth,
+                                                           bool aItalic,
+                                                           bool aBold )
+{
+    if( aWidth == 0 && aBold ) // Use default values if aWidth == 0
+        aWidth = GetPenSizeForBold( std::min( aSize.x, aSize.y ) );
+
+    // The sketch mode only matters when drawing in a wxDC
+    if( aWidth < 0 )
+        aWidth = -aWidth;
+
+    TEXT_STROKES_KEY key;
+    key.m_text = aText;
+    key.m_pos = aPos;
+    key.m_orient = aOrient;
+    key.m_size = aSize;
+    key.m_hJustify = aH_justify;
+    key.m_vJustify = aV_justify;
+    key.m_width = aWidth;
+    key.m_italic = aItalic;
+    key.m_bold = aBold;
+
+    MUTLOCK lock( basic_galLock );
+
+    TEXT_STROKES_CACHE::const_iterator it = s_strokesCache.find( key );
+
+    if( it != s_strokesCache.end() )
+        return it->second;
+
+    std::shared_ptr<TEXT_STROKES> strokes = std::make_shared<TEXT_STROKES>();
+
+    setTextAttributes( aSize, aH_justify, aV_justify, aWidth, true, aItalic, aBold );
+    basic_gal.SetPlotter( NULL );
+    basic_gal.SetCallback( NULL );
+    basic_gal.SetStrokeList( strokes.get() );
+    basic_gal.m_DC = NULL;
+    basic_gal.SetClipBox( NULL );
+
+    basic_gal.StrokeText( aText, VECTOR2D( aPos ), aOrient * M_PI/1800 );
+
+    basic_gal.SetStrokeList( NULL );
+
+    size_t points = 0;
+
+    for( unsigned ii = 0; ii < strokes->size(); ii++ )
+        points += (*strokes)[ii].size();
+
+    if( s_strokesCachePoints + points > TEXT_STROKES_CACHE_MAX_POINTS )
+    {
+        s_strokesCache.clear();
+        s_strokesCachePoints = 0;
+    }
+
+    s_strokesCache[key] = strokes;
+    s_strokesCachePoints += points;
+
+    return strokes;
+}
+
+
 /**
  * Function DrawGraphicText
  * Draw a graphic text (like module texts)
@@ -134,6 +303,39 @@ void DrawGraphicText( EDA_RECT* aClipBox,
                       void (* aCallback)( int x0, int y0, int xf, int yf ),
                       PLOTTER* aPlotter )
 {
+    // Plotted and converted texts do not depend on the pen mode: use the cached strokes
+    if( !aDC )
+    {
+        if( !aPlotter && !aCallback )
+            return;
+
+        std::shared_ptr<const TEXT_STROKES> strokes =
+                GetGraphicTextStrokes( aPos, aText, aOrient, aSize, aH_justify, aV_justify,
+                                       aWidth, aItalic, aBold );
+
+        for( unsigned ii = 0; ii < strokes->size(); ii++ )
+        {
+            const std::vector<wxPoint>& stroke = (*strokes)[ii];
+
+            if( aPlotter )
+            {
+                aPlotter->MoveTo( stroke[0] );
+
+                for( unsigned jj = 1; jj < stroke.size(); jj++ )
+                    aPlotter->LineTo( stroke[jj] );
+
+                aPlotter->PenFinish();
+            }
+            else
+            {
+                for( unsigned jj = 1; jj < stroke.size(); jj++ )
+                    aCallback( stroke[jj-1].x, stroke[jj-1].y, stroke[jj].x, stroke[jj].y );
+            }
+        }
+
+        return;
+    }
+
     bool    fill_mode = true;
 
     if( aWidth == 0 && aBold ) // Use default values if aWidth == 0
@@ -145,26 +347,11 @@ void DrawGraphicText( EDA_RECT* aClipBox,
         fill_mode = false;
     }
 
-    basic_gal.SetIsFill( fill_mode );
-    basic_gal.SetLineWidth( aWidth );
-
-    EDA_TEXT dummy;
-    dummy.SetItalic( aItalic );
-    dummy.SetBold( aBold );
-    dummy.SetHorizJustify( aH_justify );
-    dummy.SetVertJustify( aV_justify );
-
-    wxSize size = aSize;
-    dummy.SetMirrored( size.x < 0 );
+    MUTLOCK lock( basic_galLock );
 
-    if( size.x < 0 )
-        size.x = - size.x;
-
-    dummy.SetSize( size );
-
-    basic_gal.SetTextAttributes( &dummy );
-    basic_gal.SetPlotter( aPlotter );
-    basic_gal.SetCallback( aCallback );
+    setTextAttributes( aSize, aH_justify, aV_justify, aWidth, fill_mode, aItalic, aBold );
+    basic_gal.SetPlotter( NULL );
+    basic_gal.SetCallback( NULL );
     basic_gal.m_DC = aDC;
     basic_gal.m_Color = aColor;
     basic_gal.SetClipBox( aClipBox );
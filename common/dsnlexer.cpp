@@ -833,3 +833,94 @@ wxArrayString* DSNLEXER::ReadCommentLines() throw( IO_ERROR )
 
     return ret;
 }
+
+
+int DSNLEXER::ReadRawList( std::string& aText ) throw( IO_ERROR )
+{
+    wxASSERT( !specctraMode );
+
+    int         firstLine = CurLineNumber();
+    int         depth = 1;
+    const char* cur = next;
+    const char* copyFrom = start + curOffset;
+
+    // the opening parenthesis is put back just before the first token,
+    // which is where it is in any sensibly formatted file
+    aText.assign( curOffset > 0 ? curOffset - 1 : 0, ' ' );
+    aText += '(';
+
+    while( true )
+    {
+        while( cur < limit )
+        {
+            if( isSpace( *cur ) )
+            {
+                ++cur;
+            }
+            else if( *cur == '(' )
+            {
+                ++depth;
+                ++cur;
+            }
+            else if( *cur == ')' )
+            {
+                ++cur;
+
+                if( --depth == 0 )
+                {
+                    aText.append( copyFrom, cur );
+
+                    curOffset = cur - 1 - start;
+                    curTok    = DSN_RIGHT;
+                    curText   = ')';
+                    next      = cur;
+
+                    return firstLine;
+                }
+            }
+            else if( *cur == '"' )
+            {
+                // a quoted string, with the escape sequences NextTok() knows
+                for( ++cur;  cur < limit && *cur != '"';  ++cur )
+                {
+                    if( *cur == '\\' )
+                        ++cur;
+                }
+
+                if( cur >= limit )
+                {
+                    curOffset = 0;
+                    wxString errtxt( _( "Un-terminated delimited string" ) );
+                    THROW_PARSE_ERROR( errtxt, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+                }
+
+                ++cur;
+            }
+            else
+            {
+                // a symbol or a number
+                while( cur < limit && !isSep( *cur ) )
+                    ++cur;
+            }
+        }
+
+        aText.append( copyFrom, limit );
+
+        if( readLine() == 0 )
+        {
+            curOffset = 0;
+            wxString errtxt( _( "Unexpected end of file" ) );
+            THROW_PARSE_ERROR( errtxt, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+        }
+
+        cur      = start;
+        copyFrom = start;
+
+        while( cur < limit && isSpace( *cur ) )
+            ++cur;
+
+        // comment lines are copied but not scanned, NextTok() skips them too
+        if( cur < limit && *cur == '#' )
+            cur = limit;
+    }
+}
@@ -80,13 +80,7 @@ void EDA_TEXT::SetOrientation( double aOrientation )
 
 int EDA_TEXT::LenSize( const wxString& aLine ) const
 {
-    basic_gal.SetFontItalic( m_Italic );
-    basic_gal.SetFontBold( m_Bold );
-    basic_gal.SetGlyphSize( VECTOR2D( m_Size ) );
-
-    VECTOR2D tsize = basic_gal.GetTextLineSize( aLine );
-
-    return KiROUND( tsize.x );
+    return GraphicTextWidth( aLine, m_Size, m_Italic, m_Bold );
 }
 
 
@@ -151,6 +145,8 @@ EDA_RECT EDA_TEXT::GetTextBox( int aLine, int aThickness, bool aInvertY ) const
         }
     }
 
+    MUTLOCK lock( basic_galLock );
+
     // calculate the H and V size
     int dx = KiROUND( basic_gal.GetStrokeFont().ComputeStringBoundaryLimits(
                             text, VECTOR2D( m_Size ), double( thickness ) ).x );
@@ -737,6 +737,117 @@ bool SHAPE_POLY_SET::Contains( const VECTOR2I& aP, int aSubpolyIndex ) const
 }
 
 
+static bool compareY( const VECTOR2I& aA, const VECTOR2I& aB )
+{
+    return aA.y < aB.y;
+}
+
+
+bool SHAPE_POLY_SET::ContainsAny( const std::vector<VECTOR2I>& aSortedPoints,
+                                  int aSubpolyIndex ) const
+{
+    if( aSortedPoints.empty() || m_polys[aSubpolyIndex].empty() )
+        return false;
+
+    const SHAPE_LINE_CHAIN& path = m_polys[aSubpolyIndex][0];
+    int cnt = path.PointCount();
+
+    if( cnt < 3 )
+        return false;
+
+    // Only the points inside the bounding box can be inside the outline.
+    // They are kept sorted by y, so the points crossed by each edge are a range.
+    const BOX2I bbox = path.BBox();
+    std::vector<VECTOR2I> candidates;
+
+    std::vector<VECTOR2I>::const_iterator first = std::lower_bound( aSortedPoints.begin(),
+            aSortedPoints.end(), VECTOR2I( 0, bbox.GetY() ), compareY );
+    std::vector<VECTOR2I>::const_iterator last = std::upper_bound( first,
+            aSortedPoints.end(), VECTOR2I( 0, bbox.GetBottom() ), compareY );
+
+    for( ; first != last; ++first )
+    {
+        if( bbox.Contains( *first ) )
+            candidates.push_back( *first );
+    }
+
+    if( candidates.empty() )
+        return false;
+
+    // Same crossing test as pointInPolygon(), applied edge by edge to
+    // the points having their y coordinate in the edge span
+    std::vector<char> result( candidates.size(), 0 );
+    VECTOR2I ip = path.CPoint( 0 );
+
+    for( int i = 1; i <= cnt; ++i )
+    {
+        VECTOR2I ipNext = ( i == cnt ? path.CPoint( 0 ) : path.CPoint( i ) );
+
+        std::vector<VECTOR2I>::const_iterator begin = std::lower_bound( candidates.cbegin(),
+                candidates.cend(), VECTOR2I( 0, std::min( ip.y, ipNext.y ) ), compareY );
+        std::vector<VECTOR2I>::const_iterator end = std::upper_bound( begin,
+                candidates.cend(), VECTOR2I( 0, std::max( ip.y, ipNext.y ) ), compareY );
+
+        for( std::vector<VECTOR2I>::const_iterator it = begin; it != end; ++it )
+        {
+            const VECTOR2I& aP = *it;
+            char& res = result[it - candidates.cbegin()];
+
+            if( ipNext.y == aP.y )
+            {
+                if( ( ipNext.x == aP.x ) || ( ip.y == aP.y &&
+                    ( ( ipNext.x > aP.x ) == ( ip.x < aP.x ) ) ) )
+                    return true;
+            }
+
+            if( ( ip.y < aP.y ) != ( ipNext.y < aP.y ) )
+            {
+                if( ip.x >= aP.x )
+                {
+                    if( ipNext.x > aP.x )
+                        res = 1 - res;
+                    else
+                    {
+                        int64_t d = (int64_t)( ip.x - aP.x ) * (int64_t)( ipNext.y - aP.y ) -
+                                    (int64_t)( ipNext.x - aP.x ) * (int64_t)( ip.y - aP.y );
+
+                        if( !d )
+                            return true;
+
+                        if( ( d > 0 ) == ( ipNext.y > ip.y ) )
+                            res = 1 - res;
+                    }
+                }
+                else
+                {
+                    if( ipNext.x > aP.x )
+                    {
+                        int64_t d = (int64_t)( ip.x - aP.x ) * (int64_t)( ipNext.y - aP.y ) -
+                                    (int64_t)( ipNext.x - aP.x ) * (int64_t)( ip.y - aP.y );
+
+                        if( !d )
+                            return true;
+
+                        if( ( d > 0 ) == ( ipNext.y > ip.y ) )
+                            res = 1 - res;
+                    }
+                }
+            }
+        }
+
+        ip = ipNext;
+    }
+
+    for( unsigned int k = 0; k < result.size(); k++ )
+    {
+        if( result[k] )
+            return true;
+    }
+
+    return false;
+}
+
+
 bool SHAPE_POLY_SET::pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const
 {
     int result = 0;
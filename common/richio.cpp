@@ -23,6 +23,7 @@
  */
 
 
+#include <algorithm>
 #include <cstdarg>
 #include <config.h> // HAVE_FGETC_NOLOCK
 
@@ -413,13 +414,18 @@ int OUTPUTFORMATTER::Print( int nestLevel, const char* fmt, ... ) throw( IO_ERRO
 
     va_start( args, fmt );
 
+    static const char blanks[] = "                                ";    // 32 spaces
+
     int result = 0;
     int total  = 0;
 
-    for( int i=0; i<nestLevel;  ++i )
+    // the indentation is written directly, it need not go through vsnprintf()
+    for( int count = nestLevel * NESTWIDTH;  count > 0;  count -= result )
     {
+        result = std::min( count, (int) sizeof( blanks ) - 1 );
+
         // no error checking needed, an exception indicates an error.
-        result = sprint( "%*c", NESTWIDTH, ' ' );
+        write( blanks, result );
 
         total += result;
     }
@@ -532,6 +538,11 @@ FILE_OUTPUTFORMATTER::FILE_OUTPUTFORMATTER( const wxString& aFileName,
                             m_filename.GetData() );
         THROW_IO_ERROR( msg );
     }
+
+    // Boards and libraries are written in many small pieces, use a buffer large
+    // enough to hand them to the system in big blocks.
+    m_buffer.resize( FILE_OUTPUTFMTBUFZ );
+    setvbuf( m_fp, &m_buffer[0], _IOFBF, m_buffer.size() );
 }
 
 
@@ -186,6 +186,47 @@ char* StrPurge( char* text )
 }
 
 
+int FixedPointToStr( char* aBuf, long long aValue, int aDecimals )
+{
+    char                digits[24];
+    int                 count = 0;
+    unsigned long long  magnitude = aValue < 0 ? 0ULL - (unsigned long long) aValue : aValue;
+
+    // least significant digit first, with at least one digit before the decimal point
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while( magnitude || count <= aDecimals );
+
+    // the trailing zeros of the fractional part are dropped
+    int last = 0;
+
+    while( last < aDecimals && digits[last] == '0' )
+        ++last;
+
+    char* cp = aBuf;
+
+    if( aValue < 0 )
+        *cp++ = '-';
+
+    for( int i = count - 1;  i >= aDecimals;  --i )
+        *cp++ = digits[i];
+
+    if( last < aDecimals )
+    {
+        *cp++ = '.';
+
+        for( int i = aDecimals - 1;  i >= last;  --i )
+            *cp++ = digits[i];
+    }
+
+    *cp = '\0';
+
+    return cp - aBuf;
+}
+
+
 char* GetLine( FILE* File, char* Line, int* LineNum, int SizeLine )
 {
     do {
@@ -90,4 +90,97 @@ void XNODE::FormatContents( OUTPUTFORMATTER* out, int nestLevel ) throw( IO_ERRO
     }
 }
 
+
+/**
+ * Function xmlEscape
+ * escapes aString like wxXmlDocument::Save() does for text or attribute values.
+ */
+static wxString xmlEscape( const wxString& aString, bool aAttribute )
+{
+    wxString escaped;
+    escaped.reserve( aString.length() );
+
+    for( wxString::const_iterator it = aString.begin();  it != aString.end();  ++it )
+    {
+        const wxChar c = *it;
+
+        switch( c )
+        {
+        case wxT( '<' ):    escaped.append( wxT( "&lt;" ) );    break;
+        case wxT( '>' ):    escaped.append( wxT( "&gt;" ) );    break;
+        case wxT( '&' ):    escaped.append( wxT( "&amp;" ) );   break;
+        case wxT( '\r' ):   escaped.append( wxT( "&#xD;" ) );   break;
+
+        case wxT( '"' ):
+            escaped.append( aAttribute ? wxT( "&quot;" ) : wxT( "\"" ) );
+            break;
+
+        case wxT( '\t' ):
+            escaped.append( aAttribute ? wxT( "&#x9;" ) : wxT( "\t" ) );
+            break;
+
+        case wxT( '\n' ):
+            escaped.append( aAttribute ? wxT( "&#xA;" ) : wxT( "\n" ) );
+            break;
+
+        default:
+            escaped.append( 1, c );
+        }
+    }
+
+    return escaped;
+}
+
+
+void XNODE::FormatXml( OUTPUTFORMATTER* out, int aIndent ) throw( IO_ERROR )
+{
+    const int indentStep = 2;
+
+    switch( GetType() )
+    {
+    case wxXML_ELEMENT_NODE:
+        out->Print( 0, "<%s", TO_UTF8( GetName() ) );
+
+        for( XATTR* attr = (XATTR*) GetAttributes();  attr;  attr = (XATTR*) attr->GetNext() )
+        {
+            out->Print( 0, " %s=\"%s\"", TO_UTF8( attr->GetName() ),
+                        TO_UTF8( xmlEscape( attr->GetValue(), true ) ) );
+        }
+
+        if( GetChildren() )
+        {
+            XNODE* prev = NULL;
+
+            out->Print( 0, ">" );
+
+            // Text children are not indented
+            for( XNODE* kid = GetChildren();  kid;  kid = kid->GetNext() )
+            {
+                if( kid->GetType() != wxXML_TEXT_NODE )
+                    out->Print( 0, "\n%*s", aIndent + indentStep, "" );
+
+                kid->FormatXml( out, aIndent + indentStep );
+                prev = kid;
+            }
+
+            if( prev->GetType() != wxXML_TEXT_NODE )
+                out->Print( 0, "\n%*s", aIndent, "" );
+
+            out->Print( 0, "</%s>", TO_UTF8( GetName() ) );
+        }
+        else
+        {
+            out->Print( 0, "/>" );
+        }
+        break;
+
+    case wxXML_TEXT_NODE:
+        out->Print( 0, "%s", TO_UTF8( xmlEscape( GetContent(), false ) ) );
+        break;
+
+    default:
+        ;   // not supported
+    }
+}
+
 // EOF
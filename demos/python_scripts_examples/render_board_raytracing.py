@@ -0,0 +1,44 @@
+'''
+    A python script example to render a board with the raytracing engine
+    of the 3D viewer, without opening any window, and to report the scene
+    build time and the trace time of each render pass.
+
+    Usage:
+        render_board_raytracing.py board.kicad_pcb image.png [width height [passes]]
+
+    Important note:
+        the 3D models of the footprints are not rendered, because they are
+        found using the project settings, which are not available here.
+'''
+
+import sys
+
+from pcbnew import *
+
+if len(sys.argv) < 3:
+    print("usage: %s board.kicad_pcb image.png [width height [passes]]" % sys.argv[0])
+    sys.exit(1)
+
+filename = sys.argv[1]
+imagename = sys.argv[2]
+
+width = 1280
+height = 720
+passes = 1
+
+if len(sys.argv) > 4:
+    width = int(sys.argv[3])
+    height = int(sys.argv[4])
+
+if len(sys.argv) > 5:
+    passes = int(sys.argv[5])
+
+board = LoadBoard(filename)
+
+report = RenderBoardRaytracing(board, imagename, width, height, passes)
+
+if not report:
+    print("Unable to save %s" % imagename)
+    sys.exit(1)
+
+print(report)
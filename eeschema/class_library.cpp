@@ -47,6 +47,8 @@
 #include <wx/tokenzr.h>
 #include <wx/regex.h>
 
+#include <exception>
+
 #define DUPLICATE_NAME_MSG  \
     _(  "Library '%s' has duplicate entry name '%s'.\n" \
         "This may cause some unexpected behavior when loading components into a schematic." )
@@ -711,7 +713,10 @@ PART_LIB* PART_LIB::LoadLibrary( const wxString& aFileName ) throw( IO_ERROR, bo
 {
     std::unique_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, aFileName ) );
 
-    wxBusyCursor ShowWait;  // Do we want UI elements in PART_LIB?
+    // Do we want UI elements in PART_LIB?
+    // The busy cursor can only be shown from the main thread, libraries are
+    // also loaded from worker threads by PART_LIBS::LoadAllLibraries.
+    std::unique_ptr<wxBusyCursor> showWait( wxIsMainThread() ? new wxBusyCursor : NULL );
 
     wxString errorMsg;
 
@@ -840,8 +845,45 @@ wxArrayString PART_LIBS::GetLibraryNames( bool aSorted )
 }
 
 
+void PART_LIBS::updateIndex()
+{
+    bool changed = m_indexHash != GetModifyHash() || m_indexLibs.size() != size();
+
+    for( unsigned i = 0; !changed && i < size(); ++i )
+        changed = m_indexLibs[i] != &(*this)[i];
+
+    if( !changed )
+        return;
+
+    m_aliasIndex.clear();
+    m_nearAliasIndex.clear();
+    m_indexLibs.clear();
+
+    for( PART_LIB& lib : *this )
+    {
+        m_indexLibs.push_back( &lib );
+
+        for( LIB_ALIAS_MAP::iterator it = lib.m_amap.begin(); it != lib.m_amap.end(); ++it )
+        {
+            // The first library in the list has priority, like in a sequential search
+            m_aliasIndex.insert( std::make_pair( it->first, it->second ) );
+            m_nearAliasIndex[ it->first.Lower() ].push_back( it->second );
+        }
+    }
+
+    m_indexHash = GetModifyHash();
+}
+
+
 LIB_PART* PART_LIBS::FindLibPart( const wxString& aPartName, const wxString& aLibraryName )
 {
+    if( aLibraryName.IsEmpty() )
+    {
+        LIB_ALIAS* alias = FindLibraryEntry( aPartName );
+
+        return alias ? alias->GetPart() : NULL;
+    }
+
     LIB_PART* part = NULL;
 
     for( PART_LIB& lib : *this )
@@ -861,6 +903,15 @@ LIB_PART* PART_LIBS::FindLibPart( const wxString& aPartName, const wxString& aLi
 
 LIB_ALIAS* PART_LIBS::FindLibraryEntry( const wxString& aEntryName, const wxString& aLibraryName )
 {
+    if( !aLibraryName )
+    {
+        updateIndex();
+
+        ALIAS_INDEX::const_iterator it = m_aliasIndex.find( aEntryName );
+
+        return it != m_aliasIndex.end() ? it->second : NULL;
+    }
+
     LIB_ALIAS* entry = NULL;
 
     for( PART_LIB& lib : *this )
@@ -885,30 +936,25 @@ void PART_LIBS::FindLibraryNearEntries( std::vector<LIB_ALIAS*>& aCandidates,
                                         const wxString& aEntryName,
                                         const wxString& aLibraryName )
 {
-    for( PART_LIB& lib : *this )
-    {
-        if( !!aLibraryName && lib.GetName() != aLibraryName )
-            continue;
+    updateIndex();
 
-        LIB_ALIAS* entry = lib.GetFirstEntry();
+    NEAR_ALIAS_INDEX::const_iterator it = m_nearAliasIndex.find( aEntryName.Lower() );
 
-        if( ! entry )
-            continue;
+    if( it == m_nearAliasIndex.end() )
+        return;
 
-        wxString first_entry_name = entry->GetName();
-        wxString entry_name = first_entry_name;
+    PART_LIB* lib = !!aLibraryName ? FindLibrary( aLibraryName ) : NULL;
 
-        for( ;; )
-        {
-            if( entry_name.CmpNoCase( aEntryName ) == 0 )
-                aCandidates.push_back( entry );
+    if( !!aLibraryName && !lib )
+        return;
 
-            entry = lib.GetNextEntry( entry_name );
-            entry_name = entry->GetName();
+    // The candidates are stored in library order
+    for( LIB_ALIAS* entry : it->second )
+    {
+        if( lib && lib->FindAlias( entry->GetName() ) != entry )
+            continue;
 
-            if( first_entry_name == entry_name )
-                break;
-        }
+        aCandidates.push_back( entry );
     }
 }
 
@@ -1020,6 +1066,11 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR, boost::ba
 
     wxASSERT( !size() );    // expect to load into "this" empty container.
 
+    // The library files are first located, then loaded concurrently,
+    // and added to the list in the configured order.
+    wxArrayString   lib_files;
+    wxArrayString   lib_file_names;
+
     for( unsigned i = 0; i < lib_names.GetCount();  ++i )
     {
         fn.Clear();
@@ -1046,46 +1097,95 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR, boost::ba
             filename = fn.GetFullPath();
         }
 
-        try
-        {
-            AddLibrary( filename );
-        }
-        catch( const IO_ERROR& ioe )
-        {
-            wxString msg = wxString::Format( _(
-                    "Part library '%s' failed to load. Error:\n"
-                    "%s" ),
-                    GetChars( filename ),
-                    GetChars( ioe.What() )
-                    );
+        // Don't load the library twice (see AddLibrary).
+        if( lib_file_names.Index( wxFileName( filename ).GetName() ) != wxNOT_FOUND )
+            continue;
 
-            THROW_IO_ERROR( msg );
-        }
+        lib_files.Add( filename );
+        lib_file_names.Add( wxFileName( filename ).GetName() );
     }
 
-    // add the special cache library.
+    // add the special cache library, loaded with the others.
     wxString cache_name = CacheName( aProject->GetProjectFullName() );
-    PART_LIB* cache_lib;
+    int cache_index = -1;
 
-    if( !!cache_name )
+    if( !!cache_name
+        && lib_file_names.Index( wxFileName( cache_name ).GetName() ) == wxNOT_FOUND )
     {
-        try
-        {
-            cache_lib = AddLibrary( cache_name );
+        cache_index = lib_files.GetCount();
+        lib_files.Add( cache_name );
+    }
+
+    int                     count = lib_files.GetCount();
+    std::vector<PART_LIB*>  libs( count, NULL );
+    std::vector<wxString>   errors( count );
+
+    // Other exceptions cannot leave the parallel loop, they are thrown after it.
+    std::vector<std::exception_ptr> failures( count );
+
+    {
+        // Show the busy cursor once, the workers cannot show it.
+        wxBusyCursor showWait;
+
+        // The library parsers switch to the C locale with their own LOCALE_IO.
+        // Switching once here keeps the workers from calling setlocale() concurrently.
+        LOCALE_IO toggle;
 
-            if( cache_lib )
-                cache_lib->SetCache();
+#ifdef USE_OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for( int i = 0; i < count; ++i )
+        {
+            try
+            {
+                libs[i] = PART_LIB::LoadLibrary( lib_files[i] );
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                errors[i] = ioe.What();
+            }
+            catch( ... )
+            {
+                failures[i] = std::current_exception();
+            }
         }
-        catch( const IO_ERROR& ioe )
+    }
+
+    for( int i = 0; i < count; ++i )
+    {
+        if( !libs[i] )
         {
-            wxString msg = wxString::Format( _(
-                    "Part library '%s' failed to load.\nError: %s" ),
-                    GetChars( cache_name ),
-                    GetChars( ioe.What() )
-                    );
+            // Keep the libraries preceding the failing one, like a sequential
+            // load would do, and release the others.
+            for( int j = i + 1; j < count; ++j )
+                delete libs[j];
+
+            if( failures[i] )
+                std::rethrow_exception( failures[i] );
+
+            wxString msg;
+
+            if( i == cache_index )
+                msg = wxString::Format( _(
+                        "Part library '%s' failed to load.\nError: %s" ),
+                        GetChars( lib_files[i] ),
+                        GetChars( errors[i] )
+                        );
+            else
+                msg = wxString::Format( _(
+                        "Part library '%s' failed to load. Error:\n"
+                        "%s" ),
+                        GetChars( lib_files[i] ),
+                        GetChars( errors[i] )
+                        );
 
             THROW_IO_ERROR( msg );
         }
+
+        if( i == cache_index )
+            libs[i]->SetCache();
+
+        push_back( libs[i] );
     }
 
     // Print the libraries not found
@@ -36,6 +36,7 @@
 #include <class_libentry.h>
 
 #include <project.h>
+#include <hashtables.h>
 
 #include <map>
 
@@ -195,7 +196,8 @@ public:
 
     static int s_modify_generation;     ///< helper for GetModifyHash()
 
-    PART_LIBS()
+    PART_LIBS() :
+        m_indexHash( 0 )
     {
         ++s_modify_generation;
     }
@@ -330,6 +332,22 @@ public:
             const wxString& aLibraryName = wxEmptyString );
 
     int GetLibraryCount() { return size(); }
+
+private:
+    typedef std::unordered_map< wxString, LIB_ALIAS*, WXSTRING_HASH > ALIAS_INDEX;
+    typedef std::unordered_map< wxString, LIB_ALIASES, WXSTRING_HASH > NEAR_ALIAS_INDEX;
+
+    /**
+     * Function updateIndex
+     * rebuilds the symbol index of all the libraries if one of them was
+     * modified, added, removed or moved since the last build.
+     */
+    void updateIndex();
+
+    ALIAS_INDEX         m_aliasIndex;       ///< Alias name -> first alias in library order
+    NEAR_ALIAS_INDEX    m_nearAliasIndex;   ///< Lower case alias name -> all the aliases
+    int                 m_indexHash;        ///< GetModifyHash() when the index was built
+    std::vector<PART_LIB*> m_indexLibs;     ///< Library order when the index was built
 };
 
 
@@ -31,12 +31,15 @@
 #include <fctsys.h>
 #include <macros.h>
 #include <schframe.h>
+#include <ki_mutex.h>
 
 #include <sch_component.h>
 #include <class_netlist_object.h>
 
 #include <wx/regex.h>
 
+#include <algorithm>
+
 
 /**
  * The regular expression string for label bus notation.  Valid bus labels are defined as
@@ -45,12 +48,17 @@
  */
 static wxRegEx busLabelRe( wxT( "^([^[:space:]]+)(\\[[\\d]+\\.+[\\d]+\\])$" ), wxRE_ADVANCED );
 
+// wxRegEx stores the last match: net list items are built by several threads
+static MUTEX busLabelReLock;
+
 
 bool IsBusLabel( const wxString& aLabel )
 {
     wxCHECK_MSG( busLabelRe.IsValid(), false,
                  wxT( "Invalid regular expression in IsBusLabel()." ) );
 
+    MUTLOCK lock( busLabelReLock );
+
     return busLabelRe.Matches( aLabel );
 }
 
@@ -172,6 +180,9 @@ NETLIST_OBJECT::NETLIST_OBJECT()
                                      * SCH_SHEET_PIN For Pins: pointer to the component that
                                      * contains this pin
                                      */
+    m_IncludedSheet = NULL;         /* For SCH_SHEET_PIN: the sheet which contains the
+                                     * hierarchical label
+                                     */
     m_Flag = 0;                     /* flag used in calculations */
     m_ElectricalPinType = PIN_INPUT;   /* Has meaning only for Pins: electrical type of the pin
                                      * used to detect conflicts between pins in ERC
@@ -213,6 +224,18 @@ bool NETLIST_OBJECT::IsLabelType() const
         || m_Type == NET_PINLABEL;
 }
 
+bool NETLIST_OBJECT::IsSheetPathInclude( const SCH_SHEET_PATH& aSheetPath ) const
+{
+    if( !m_IncludedSheet )
+        return aSheetPath == m_SheetPath;
+
+    if( aSheetPath.size() != m_SheetPath.size() + 1 || aSheetPath.back() != m_IncludedSheet )
+        return false;
+
+    return std::equal( m_SheetPath.begin(), m_SheetPath.end(), aSheetPath.begin() );
+}
+
+
 bool NETLIST_OBJECT::IsLabelConnected( NETLIST_OBJECT* aNetItem )
 {
     if( aNetItem == this )   // Don't compare the same net list object.
@@ -224,7 +247,7 @@ bool NETLIST_OBJECT::IsLabelConnected( NETLIST_OBJECT* aNetItem )
     if(  ( at == NET_HIERLABEL || at == NET_HIERBUSLABELMEMBER )
       && ( bt == NET_SHEETLABEL || bt == NET_SHEETBUSLABELMEMBER ) )
     {
-        if( m_SheetPath == aNetItem->m_SheetPathInclude )
+        if( aNetItem->IsSheetPathInclude( m_SheetPath ) )
         {
             return true; //connected!
         }
@@ -241,8 +264,17 @@ bool NETLIST_OBJECT::IsLabelConnected( NETLIST_OBJECT* aNetItem )
 
 void NETLIST_OBJECT::ConvertBusToNetListItems( NETLIST_OBJECT_LIST& aNetListItems )
 {
-    wxCHECK_RET( IsBusLabel( m_Label ),
-                 wxT( "<" ) + m_Label + wxT( "> is not a valid bus label." ) );
+    wxString tmp, busName, busNumber;
+
+    {
+        MUTLOCK lock( busLabelReLock );
+
+        wxCHECK_RET( busLabelRe.Matches( m_Label ),
+                     wxT( "<" ) + m_Label + wxT( "> is not a valid bus label." ) );
+
+        busName = busLabelRe.GetMatch( m_Label, 1 );
+        busNumber = busLabelRe.GetMatch( m_Label, 2 );
+    }
 
     if( m_Type == NET_HIERLABEL )
         m_Type = NET_HIERBUSLABELMEMBER;
@@ -256,12 +288,8 @@ void NETLIST_OBJECT::ConvertBusToNetListItems( NETLIST_OBJECT_LIST& aNetListItem
         wxCHECK_RET( false, wxT( "Net list object type is not valid." ) );
 
     unsigned i;
-    wxString tmp, busName, busNumber;
     long begin, end, member;
 
-    busName = busLabelRe.GetMatch( m_Label, 1 );
-    busNumber = busLabelRe.GetMatch( m_Label, 2 );
-
     /* Search for  '[' because a bus label is like "busname[nn..mm]" */
     i = busNumber.Find( '[' );
     i++;
@@ -304,7 +332,7 @@ void NETLIST_OBJECT::ConvertBusToNetListItems( NETLIST_OBJECT_LIST& aNetListItem
 
     for( member++; member <= end; member++ )
     {
-        NETLIST_OBJECT* item = new NETLIST_OBJECT( *this );
+        NETLIST_OBJECT* item = aNetListItems.NewItem( this );
 
         // Conversion of bus label to the root name + the current member id.
         tmp = busName;
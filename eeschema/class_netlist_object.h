@@ -35,6 +35,12 @@
 #include <sch_sheet_path.h>
 #include <lib_pin.h>      // LIB_PIN::PinStringNum( m_PinNum )
 #include <sch_item_struct.h>
+#include <hashtables.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
 
 class NETLIST_OBJECT_LIST;
 class SCH_COMPONENT;
@@ -102,9 +108,13 @@ public:
                                          * For Pins: pointer to the schematic component
                                          * that contains this pin
                                          */
+    SCH_SHEET* m_IncludedSheet;         /* For sheet labels: the sheet which contains the
+                                         * hierarchical label, i.e. the sheet path which
+                                         * contains the hierarchical label is m_SheetPath
+                                         * followed by this sheet. NULL for other items.
+                                         */
     int m_Flag;                         /* flag used in calculations */
     SCH_SHEET_PATH  m_SheetPath;        // the sheet path which contains this item
-    SCH_SHEET_PATH  m_SheetPathInclude; // sheet path which contains the hierarchical label
     ELECTRICAL_PINTYPE m_ElectricalPinType; // Has meaning only for Pins: electrical type of the pin
     int m_BusNetCode;                   /* Used for BUS connections */
     int m_Member;                       /* for labels type NET_BUSLABELMEMBER ( bus member
@@ -201,6 +211,14 @@ public:
         return NULL;
     }
 
+    /**
+     * Function IsSheetPathInclude
+     * @return true if \a aSheetPath is the sheet path which contains the hierarchical
+     * label connected to this sheet label (m_SheetPath followed by m_IncludedSheet),
+     * or for other items, if \a aSheetPath is m_SheetPath.
+     */
+    bool IsSheetPathInclude( const SCH_SHEET_PATH& aSheetPath ) const;
+
     /**
      * Function IsLabelConnected
      * tests if the net list object is a hierarchical label or sheet label and is
@@ -275,17 +293,71 @@ public:
 typedef std::vector<NETLIST_OBJECT*>    NETLIST_OBJECTS;
 
 
+/**
+ * Class SHEET_CONNECTIVITY_CACHE
+ * keeps the connections found inside each sheet of the hierarchy by
+ * NETLIST_OBJECT_LIST::BuildNetListInfo().  The next call searches again only the
+ * connections of the sheets having wires, labels, pins ... added, moved or deleted.
+ * A sheet is compared item by item to the state the connections were found for,
+ * so no notification of the schematic changes is needed.
+ */
+class SHEET_CONNECTIVITY_CACHE
+{
+    friend class NETLIST_OBJECT_LIST;
+
+    // A connected item of a sheet: the item data used to find the connections
+    // inside the sheet, and the net codes found
+    struct ITEM
+    {
+        NETLIST_ITEM_T m_Type;
+        wxPoint        m_Start;
+        wxPoint        m_End;
+        int            m_NetCode;
+        int            m_BusNetCode;
+    };
+
+    struct SHEET
+    {
+        std::vector<ITEM> m_Items;      // In the order of the sheet net list items
+        int m_LastNetCode;              // Net codes of the sheet are < m_LastNetCode
+        int m_LastBusNetCode;           // Bus net codes of the sheet are < m_LastBusNetCode
+
+        SHEET() : m_LastNetCode( 1 ), m_LastBusNetCode( 1 ) {}
+    };
+
+    std::map<SCH_SHEETS, SHEET> m_sheets;       // Sheets by sheet path
+
+public:
+    /** Forget all the connections found */
+    void Clear() { m_sheets.clear(); }
+};
+
+
 /**
  * Class NETLIST_OBJECT_LIST
  * is a container holding and _owning_ NETLIST_OBJECTs, which are connected items
  * in a full schematic hierarchy.  It is helpful for netlist and ERC calculations.
+ * The objects are allocated by blocks (see NewItem()) and freed by Clear().
  */
 class NETLIST_OBJECT_LIST : public NETLIST_OBJECTS
 {
+    std::vector< std::unique_ptr<NETLIST_OBJECT[]> > m_blocks;  // Storage of the items
+    unsigned m_blockSize;   // Count of items of the last block
+    unsigned m_blockUsed;   // Count of items used in the last block
+
     int m_lastNetCode;      // Used in intermediate calculation: last net code created
     int m_lastBusNetCode;   // Used in intermediate calculation:
                             // last net code created for bus members
 
+    // Labels of the net tested by TestforNonOrphanLabel(), which is called
+    // for each label of a net: the net is only scanned once.
+    unsigned m_orphanNetStart;      // Index of the first item of the net
+    unsigned m_orphanNetEnd;        // and of the first item after it
+    int      m_orphanNetCode;
+    std::unordered_map<wxString, int, WXSTRING_HASH> m_orphanGlobalLabels;  // Label count
+    std::unordered_set<std::string> m_orphanHierLabelPaths; // Sheet paths of hier labels
+    std::unordered_set<std::string> m_orphanSheetLabelPaths;// Included paths of sheet labels
+
 public:
     /**
      * Constructor.
@@ -298,8 +370,12 @@ public:
     NETLIST_OBJECT_LIST()
     {
         // Do not leave some members uninitialized:
+        m_blockSize = 0;
+        m_blockUsed = 0;
         m_lastNetCode = 0;
         m_lastBusNetCode = 0;
+        m_orphanNetStart = m_orphanNetEnd = 0;
+        m_orphanNetCode = -1;
     }
 
     ~NETLIST_OBJECT_LIST();
@@ -310,9 +386,11 @@ public:
      * Build the list of connected objects (pins, labels ...) and
      * all info to generate netlists or run ERC diags
      * @param aSheets = the flattened sheet list
+     * @param aCache = the connections found inside the sheets by a previous call,
+     * reused for the unchanged sheets and updated; NULL to search all the connections
      * @return true if OK, false is not item found
      */
-    bool BuildNetListInfo( SCH_SHEET_LIST& aSheets );
+    bool BuildNetListInfo( SCH_SHEET_LIST& aSheets, SHEET_CONNECTIVITY_CACHE* aCache = NULL );
 
     /**
      * Acces to an item in list
@@ -358,6 +436,14 @@ public:
     /** Delete all objects in list and clear list */
     void Clear();
 
+    /**
+     * Function NewItem
+     * creates a NETLIST_OBJECT owned by the list.  The item is not added to the list:
+     * the caller initializes it and calls push_back().
+     * @param aSource = an item to copy, or NULL to create a default item
+     */
+    NETLIST_OBJECT* NewItem( NETLIST_OBJECT* aSource = NULL );
+
     /**
      * Reset the connection type of all items to UNCONNECTED type
      */
@@ -372,13 +458,6 @@ public:
      */
     void SortListbyNetcode();
 
-    /*
-     * Sorts the list of connected items by sheet.
-     * This sorting is used when searching "physical" connection between items
-     * because obviously only items inside the same sheet can be connected
-     */
-    void SortListbySheet();
-
     /**
      * Counts number of pins connected on the same net.
      * Used to count all pins connected to a no connect symbol
@@ -418,6 +497,21 @@ public:
     #endif
 
 private:
+    /**
+     * Appends the items of \a aList and takes the ownership of them.
+     * \a aList is empty on return.
+     */
+    void takeItems( NETLIST_OBJECT_LIST& aList );
+
+    /**
+     * Searches the connections between the items of a list holding the items of a
+     * single sheet (wires, junctions, buses, pins ... at the same place) and gives
+     * the connected items the same net code.  Net codes start at 1 for each sheet.
+     * @param aSheetCache = the connections of the sheet found by a previous call,
+     * reused if the items were not changed, and updated; can be NULL
+     */
+    void connectSheetItems( SHEET_CONNECTIVITY_CACHE::SHEET* aSheetCache );
+
     /*
      * Propagate aNewNetCode to items having an internal netcode aOldNetCode
      * used to interconnect group of items already physically connected,
@@ -439,13 +533,6 @@ private:
         return Objet1->GetNet() < Objet2->GetNet();
     }
 
-    /* Comparison routine to sort items by Sheet path
-     */
-    static bool sortItemsBySheet( const NETLIST_OBJECT* Objet1, const NETLIST_OBJECT* Objet2 )
-    {
-        return Objet1->m_SheetPath.Cmp( Objet2->m_SheetPath ) < 0;
-    }
-
     /**
      * Propagate net codes from a parent sheet to an include sheet,
      * from a pin sheet connection
@@ -43,6 +43,10 @@
 // result is very unspecific.
 static const unsigned kLowestDefaultScore = 1;
 
+// Characters having a meaning for the regex or wildcard matchers. A search term
+// without them is a plain string, matched the same way by all the matchers.
+static const wxString kPatternChars = wxT( ".*+?^${}()|[]/\\" );
+
 struct COMPONENT_TREE_SEARCH_CONTAINER::TREE_NODE
 {
     // Levels of nodes.
@@ -197,6 +201,8 @@ void COMPONENT_TREE_SEARCH_CONTAINER::AddAliasList( const wxString& aNodeName,
         TREE_NODE* alias_node = new TREE_NODE( TREE_NODE::TYPE_ALIAS, lib_node,
                                                a, a->GetName(), display_info, search_text );
         m_nodes.push_back( alias_node );
+        m_alias_nodes.push_back( alias_node );
+        indexNode( m_alias_nodes.size() - 1 );
 
         if( a->GetPart()->IsMulti() )    // Add all units as sub-nodes.
         {
@@ -215,6 +221,109 @@ void COMPONENT_TREE_SEARCH_CONTAINER::AddAliasList( const wxString& aNodeName,
 
         ++m_components_added;
     }
+
+    // The previous search results do not include the new aliases
+    m_last_search.Empty();
+    m_last_matches.clear();
+}
+
+
+// Returns true if aTerm is a plain string, i.e. contains no regex or wildcard syntax.
+static bool isPlainTerm( const wxString& aTerm )
+{
+    for( wxString::const_iterator it = aTerm.begin(); it != aTerm.end(); ++it )
+    {
+        if( kPatternChars.Find( *it ) != wxNOT_FOUND )
+            return false;
+    }
+
+    return true;
+}
+
+
+// Calls aFunc for each trigram of aText, packed in an unsigned long long
+template <typename FUNC>
+static void forEachTrigram( const wxString& aText, FUNC aFunc )
+{
+    unsigned long long trigram = 0;
+    int count = 0;
+
+    for( wxString::const_iterator it = aText.begin(); it != aText.end(); ++it )
+    {
+        // Unicode code points use 21 bits
+        trigram = ( ( trigram << 21 ) | (unsigned long long) ( *it ).GetValue() ) & ( ( 1ULL << 63 ) - 1 );
+
+        if( ++count >= 3 )
+            aFunc( trigram );
+    }
+}
+
+
+void COMPONENT_TREE_SEARCH_CONTAINER::indexNode( unsigned aIndex )
+{
+    const TREE_NODE* node = m_alias_nodes[aIndex];
+
+    auto add = [&]( unsigned long long aTrigram )
+    {
+        std::vector<unsigned>& list = m_trigram_index[aTrigram];
+
+        // Aliases are indexed in sequence: a duplicate can only be the last one
+        if( list.empty() || list.back() != aIndex )
+            list.push_back( aIndex );
+    };
+
+    forEachTrigram( node->MatchName, add );
+    forEachTrigram( node->SearchText, add );
+}
+
+
+void COMPONENT_TREE_SEARCH_CONTAINER::narrowCandidates( std::vector<unsigned>& aCandidates,
+                                                        const wxString& aTerm )
+{
+    if( aTerm.length() < 3 )
+        return;
+
+    // A match needs all the trigrams of the term; the shortest list is enough
+    // to narrow the candidates, the matching itself is done by the caller.
+    const std::vector<unsigned>* shortest = NULL;
+    bool missing = false;
+
+    forEachTrigram( aTerm, [&]( unsigned long long aTrigram )
+    {
+        TRIGRAM_INDEX::const_iterator it = m_trigram_index.find( aTrigram );
+
+        if( it == m_trigram_index.end() )
+            missing = true;
+        else if( !shortest || it->second.size() < shortest->size() )
+            shortest = &it->second;
+    } );
+
+    // The aliases of the libraries matching the term are kept, whatever their text.
+    std::set<const TREE_NODE*> matching_libs;
+
+    for( const TREE_NODE* node : m_nodes )
+    {
+        if( node->Type == TREE_NODE::TYPE_LIB && node->MatchName.Find( aTerm ) != wxNOT_FOUND )
+            matching_libs.insert( node );
+    }
+
+    std::vector<char> selected( m_alias_nodes.size(), 0 );
+
+    if( !missing && shortest )
+    {
+        for( unsigned idx : *shortest )
+            selected[idx] = 1;
+    }
+
+    unsigned count = 0;
+
+    for( unsigned idx : aCandidates )
+    {
+        if( selected[idx] || matching_libs.count( m_alias_nodes[idx]->Parent ) )
+            aCandidates[count++] = idx;
+    }
+
+    aCandidates.resize( count );
 }
 
 
@@ -332,15 +441,51 @@ void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch
 
     // We score the list by going through it several time, essentially with a complexity
     // of O(n). For the default library of 2000+ items, this typically takes less than 5ms
-    // on an i5. Good enough, no index needed.
+    // on an i5. For large library sets, plain search terms (the usual case) only score
+    // the candidates found by the trigram index, and a term typed on from the previous
+    // one only scores the previous matches.
+    wxArrayString terms;
+    bool plain_terms = true;
+    wxStringTokenizer tokenizer( aSearch );
+
+    while ( tokenizer.HasMoreTokens() )
+    {
+        terms.Add( tokenizer.GetNextToken().Lower() );
+        plain_terms = plain_terms && isPlainTerm( terms.Last() );
+    }
+
+    std::vector<unsigned> candidates;
+
+    if( plain_terms && !terms.IsEmpty() )
+    {
+        // Every match of the new search string also matches a prefix of it
+        if( !m_last_search.IsEmpty() && aSearch.StartsWith( m_last_search ) )
+        {
+            candidates = m_last_matches;
+        }
+        else
+        {
+            candidates.resize( m_alias_nodes.size() );
+
+            for( unsigned idx = 0; idx < candidates.size(); ++idx )
+                candidates[idx] = idx;
+        }
+
+        for( const wxString& term : terms )
+            narrowCandidates( candidates, term );
+    }
 
     // Initial AND condition: Leaf nodes are considered to match initially.
     for( TREE_NODE* node : m_nodes )
     {
         node->PreviousScore = node->MatchScore;
-        node->MatchScore = ( node->Type == TREE_NODE::TYPE_LIB ) ? 0 : kLowestDefaultScore;
+        node->MatchScore = ( node->Type == TREE_NODE::TYPE_LIB || ( plain_terms && !terms.IsEmpty() ) )
+                                ? 0 : kLowestDefaultScore;
     }
 
+    for( unsigned idx : candidates )
+        m_alias_nodes[idx]->MatchScore = kLowestDefaultScore;
+
     // Create match scores for each node for all the terms, that come space-separated.
     // Scoring adds up values for each term according to importance of the match. If a term does
     // not match at all, the result is thrown out of the results (AND semantics).
@@ -352,11 +497,37 @@ void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch
     //     first so contribute more to the score.
     //
     // This is of course subject to tweaking.
-    wxStringTokenizer tokenizer( aSearch );
-
-    while ( tokenizer.HasMoreTokens() )
+    for( const wxString& term : terms )
     {
-        const wxString term = tokenizer.GetNextToken().Lower();
+        if( plain_terms )
+        {
+            // All the matchers find a plain term at the same position:
+            // score it like below, with the three matchers firing.
+            for( unsigned idx : candidates )
+            {
+                TREE_NODE* node = m_alias_nodes[idx];
+                int found_pos;
+
+                if( node->MatchScore == 0 )
+                    continue;
+
+                if( term == node->MatchName )
+                    node->MatchScore += 1000;
+                else if( ( found_pos = node->MatchName.Find( term ) ) != wxNOT_FOUND )
+                    node->MatchScore += matchPosScore( found_pos, 20 ) + 20 + 2 * 3;
+                else if( node->Parent->MatchName.Find( term ) != wxNOT_FOUND )
+                    node->MatchScore += 19 + 2 * 3;
+                else if( ( found_pos = node->SearchText.Find( term ) ) != wxNOT_FOUND )
+                    node->MatchScore += ( ( term.length() >= 2 )
+                                           ? matchPosScore( found_pos, 17 ) + 1
+                                           : 0 ) + 2 * 3;
+                else
+                    node->MatchScore = 0;
+            }
+
+            continue;
+        }
+
         EDA_COMBINED_MATCHER matcher( term );
 
         for( TREE_NODE* node : m_nodes )
@@ -400,6 +571,15 @@ void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch
         }
     }
 
+    m_last_search = aSearch;
+    m_last_matches.clear();
+
+    for( unsigned idx = 0; idx < m_alias_nodes.size(); ++idx )
+    {
+        if( m_alias_nodes[idx]->MatchScore > 0 )
+            m_last_matches.push_back( idx );
+    }
+
     // Library nodes have the maximum score seen in any of their children.
     // Alias nodes have the score of their parents.
     unsigned highest_score_seen = 0;
@@ -24,6 +24,7 @@
 #ifndef COMPONENT_TREE_SEARCH_CONTAINER_H
 #define COMPONENT_TREE_SEARCH_CONTAINER_H
 
+#include <unordered_map>
 #include <vector>
 #include <wx/string.h>
 
@@ -129,7 +130,27 @@ private:
     struct TREE_NODE;
     static bool scoreComparator( const TREE_NODE* a1, const TREE_NODE* a2 );
 
+    /// Trigram -> indices in m_alias_nodes of the aliases having it in their
+    /// name, keywords or description.
+    typedef std::unordered_map< unsigned long long, std::vector<unsigned> > TRIGRAM_INDEX;
+
+    /** Function indexNode
+     * Add the trigrams of the alias node m_alias_nodes[aIndex] to m_trigram_index.
+     */
+    void indexNode( unsigned aIndex );
+
+    /** Function narrowCandidates
+     * Remove from aCandidates the aliases that cannot match the plain
+     * (non regex, non wildcard) search term aTerm, using the trigram index.
+     */
+    void narrowCandidates( std::vector<unsigned>& aCandidates, const wxString& aTerm );
+
     std::vector<TREE_NODE*> m_nodes;
+    std::vector<TREE_NODE*> m_alias_nodes;  // The alias nodes, in m_trigram_index order
+    TRIGRAM_INDEX m_trigram_index;
+
+    wxString m_last_search;                 // The previous search string
+    std::vector<unsigned> m_last_matches;   // and the aliases it matched
     wxTreeCtrl* m_tree;
     int m_libraries_added;
     int m_components_added;
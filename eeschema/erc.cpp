@@ -43,6 +43,8 @@
 
 #include <wx/ffile.h>
 
+#include <algorithm>
+
 
 /* ERC tests :
  *  1 - conflicts between connected pins ( example: 2 connected outputs )
@@ -581,37 +583,102 @@ bool WriteDiagnosticERC( const wxString& aFullFileName )
 }
 
 
-void NETLIST_OBJECT_LIST::TestforNonOrphanLabel( unsigned aNetItemRef, unsigned aStartNet )
+// Helper function: a key identifying a sheet path, like SCH_SHEET_PATH::operator==
+// aIncluded, when not NULL, is appended to the path (see NETLIST_OBJECT::m_IncludedSheet)
+static std::string sheetPathKey( const SCH_SHEET_PATH& aPath,
+                                 const SCH_SHEET* aIncluded = NULL )
 {
-    unsigned netItemTst = aStartNet;
-    int      erc = 1;
+    std::string key;
 
-    // Review the list of labels connected to NetItemRef:
-    for( ; ; netItemTst++ )
+    for( unsigned i = 0; i < aPath.size(); i++ )
     {
-        if( netItemTst == aNetItemRef )
-            continue;
+        const SCH_SHEET* sheet = aPath.at( i );
+        key.append( (const char*) &sheet, sizeof( sheet ) );
+    }
+
+    if( aIncluded )
+        key.append( (const char*) &aIncluded, sizeof( aIncluded ) );
+
+    return key;
+}
+
+
+void NETLIST_OBJECT_LIST::TestforNonOrphanLabel( unsigned aNetItemRef, unsigned aStartNet )
+{
+    // This function is called for each label of a net: the labels of the net
+    // are collected once, and a label is tested against them with a lookup.
+    if( aStartNet != m_orphanNetStart || m_orphanNetEnd > size()
+        || aStartNet >= m_orphanNetEnd || GetItemNet( aStartNet ) != m_orphanNetCode )
+    {
+        m_orphanNetStart = aStartNet;
+        m_orphanNetCode = GetItemNet( aStartNet );
+        m_orphanGlobalLabels.clear();
+        m_orphanHierLabelPaths.clear();
+        m_orphanSheetLabelPaths.clear();
 
-        /* Is always in the same net? */
-        if( ( netItemTst == size() )
-          || ( GetItemNet( aNetItemRef ) != GetItemNet( netItemTst ) ) )
+        unsigned netItem;
+
+        for( netItem = aStartNet; netItem < size(); netItem++ )
         {
-            /* End Netcode found. */
-            if( erc )
+            NETLIST_OBJECT* item = GetItem( netItem );
+
+            /* Is always in the same net? */
+            if( item->GetNet() != m_orphanNetCode )
+                break;
+
+            switch( item->m_Type )
             {
-                /* Glabel or SheetLabel orphaned. */
-                Diagnose( GetItem( aNetItemRef ), NULL, -1, WAR );
-            }
+            case NET_GLOBLABEL:
+                m_orphanGlobalLabels[item->m_Label]++;
+                break;
 
-            return;
+            case NET_HIERLABEL:
+            case NET_HIERBUSLABELMEMBER:
+                m_orphanHierLabelPaths.insert( sheetPathKey( item->m_SheetPath ) );
+                break;
+
+            case NET_SHEETLABEL:
+            case NET_SHEETBUSLABELMEMBER:
+                m_orphanSheetLabelPaths.insert( sheetPathKey( item->m_SheetPath, item->m_IncludedSheet ) );
+                break;
+
+            default:
+                break;
+            }
         }
 
-        if( GetItem( aNetItemRef )->IsLabelConnected( GetItem( netItemTst ) ) )
-            erc = 0;
+        m_orphanNetEnd = netItem;
+    }
+
+    // See NETLIST_OBJECT::IsLabelConnected() for the connection rules.
+    NETLIST_OBJECT* ref = GetItem( aNetItemRef );
+    bool connected = false;
 
-        //same thing, different order.
-        if( GetItem( netItemTst )->IsLabelConnected( GetItem( aNetItemRef ) ) )
-            erc = 0;
+    switch( ref->m_Type )
+    {
+    case NET_GLOBLABEL:
+        // Another global label with the same name (the count includes ref)
+        connected = m_orphanGlobalLabels[ref->m_Label] > 1;
+        break;
+
+    case NET_HIERLABEL:
+    case NET_HIERBUSLABELMEMBER:
+        connected = m_orphanSheetLabelPaths.count( sheetPathKey( ref->m_SheetPath ) ) > 0;
+        break;
+
+    case NET_SHEETLABEL:
+    case NET_SHEETBUSLABELMEMBER:
+        connected = m_orphanHierLabelPaths.count( sheetPathKey( ref->m_SheetPath, ref->m_IncludedSheet ) ) > 0;
+        break;
+
+    default:
+        break;
+    }
+
+    if( !connected )
+    {
+        /* Glabel or SheetLabel orphaned. */
+        Diagnose( ref, NULL, -1, WAR );
     }
 }
 
@@ -620,51 +687,87 @@ void NETLIST_OBJECT_LIST::TestforNonOrphanLabel( unsigned aNetItemRef, unsigned
 // when they are compared using case insensitive coparisons.
 
 
-// A helper struct to compare NETLIST_OBJECT items by sheetpath and label texts
-// for a std::set<NETLIST_OBJECT*> container
-// the full text is "sheetpath+label" for local labels and "label" for global labels
-struct compare_labels
+// A label of TestforSimilarLabels(), with its sheet path computed once
+struct SIMILAR_LABEL
 {
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
-    {
-        wxString str1 = lab1->m_SheetPath.Path() + lab1->m_Label;
-        wxString str2 = lab2->m_SheetPath.Path() + lab2->m_Label;
-
-        return str1.Cmp( str2 ) < 0;
-    }
+    NETLIST_OBJECT* m_Item;
+    wxString        m_Path;     // m_Item->m_SheetPath.Path()
+    unsigned        m_Group;    // Index of the group of similar labels
 };
 
-struct compare_label_names
+// Sort SIMILAR_LABELs by label texts, like a std::set sorted by label does
+static bool compareLabelNames( const SIMILAR_LABEL* aLab1, const SIMILAR_LABEL* aLab2 )
 {
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
-    {
-        return lab1->m_Label.Cmp( lab2->m_Label ) < 0;
-    }
-};
+    return aLab1->m_Item->m_Label.Cmp( aLab2->m_Item->m_Label ) < 0;
+}
 
-struct compare_paths
+// Sort SIMILAR_LABELs by sheet path, then by label texts
+static bool comparePathsAndLabelNames( const SIMILAR_LABEL* aLab1, const SIMILAR_LABEL* aLab2 )
 {
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
-    {
-        return lab1->m_SheetPath.Path().Cmp( lab2->m_SheetPath.Path() ) < 0;
-    }
-};
+    int cmp = aLab1->m_Path.Cmp( aLab2->m_Path );
+
+    if( cmp != 0 )
+        return cmp < 0;
+
+    return compareLabelNames( aLab1, aLab2 );
+}
 
 // Helper functions to build the warning messages about Similar Labels:
-static int countIndenticalLabels( std::vector<NETLIST_OBJECT*>& aList, NETLIST_OBJECT* aLabel );
 static void SimilarLabelsDiagnose( NETLIST_OBJECT* aItemA, NETLIST_OBJECT* aItemB );
 
 
+// Helper function: report the similar labels of aGroups, i.e. each label
+// against the labels of its group which follow it in aLabels.
+// aCount returns the number of labels identical to a label.
+template <typename COUNT>
+static void diagnoseSimilarLabels( std::vector<SIMILAR_LABEL*>& aLabels,
+                                   std::vector< std::vector<SIMILAR_LABEL*> >& aGroups,
+                                   bool aSkipGlobalPairs, COUNT aCount )
+{
+    std::vector<unsigned> rank( aGroups.size(), 0 );
+
+    for( SIMILAR_LABEL* label : aLabels )
+    {
+        std::vector<SIMILAR_LABEL*>& group = aGroups[label->m_Group];
+
+        // The group is sorted like aLabels: the following labels come next
+        for( unsigned ii = ++rank[label->m_Group]; ii < group.size(); ++ii )
+        {
+            NETLIST_OBJECT* itemA = label->m_Item;
+            NETLIST_OBJECT* itemB = group[ii]->m_Item;
+
+            // global label versus global label was already examined.
+            if( aSkipGlobalPairs && itemA->IsLabelGlobal() && itemB->IsLabelGlobal() )
+                continue;
+
+            // Create new marker for ERC.
+            int cntA = aCount( label );
+            int cntB = aCount( group[ii] );
+
+            if( cntA <= cntB )
+                SimilarLabelsDiagnose( itemA, itemB );
+            else
+                SimilarLabelsDiagnose( itemB, itemA );
+        }
+    }
+}
+
+
 void NETLIST_OBJECT_LIST::TestforSimilarLabels()
 {
     // Similar labels which are different when using case sensitive comparisons
-    // but are equal when using case insensitive comparisons
-
-    // list of all labels (used the better item to build diag messages)
-    std::vector<NETLIST_OBJECT*> fullLabelList;
-    // list of all labels , each label appears only once (used to to detect similar labels)
-    std::set<NETLIST_OBJECT*, compare_labels> uniqueLabelList;
-    wxString msg;
+    // but are equal when using case insensitive comparisons.
+    // Labels are grouped in hash tables by their case folded text, so the
+    // test is linear, only the similar labels found are sorted to report
+    // them in a stable order.
+    typedef std::unordered_map<wxString, int, WXSTRING_HASH> LABEL_COUNTS;
+
+    // list of all labels
+    std::vector<SIMILAR_LABEL> fullLabelList;
+    // count of labels by name, for global labels, and by sheet path and name
+    // for all labels (used the better item to build diag messages)
+    LABEL_COUNTS globalCounts;
+    std::unordered_map<wxString, LABEL_COUNTS, WXSTRING_HASH> localCounts;
 
     // Build a list of differents labels. If inside a given sheet there are
     // more than one given label, only one label is stored.
@@ -683,10 +786,20 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
         case NET_HIERLABEL:
         case NET_HIERBUSLABELMEMBER:
         case NET_GLOBLABEL:
+        {
             // add this label in lists
-            uniqueLabelList.insert( GetItem( netItem ) );
-            fullLabelList.push_back( GetItem( netItem ) );
+            SIMILAR_LABEL label;
+            label.m_Item = GetItem( netItem );
+            label.m_Path = label.m_Item->m_SheetPath.Path();
+            label.m_Group = 0;
+            fullLabelList.push_back( label );
+
+            if( label.m_Item->IsLabelGlobal() )
+                globalCounts[label.m_Item->m_Label]++;
+
+            localCounts[label.m_Path][label.m_Item->m_Label]++;
             break;
+        }
 
         case NET_SHEETLABEL:
         case NET_SHEETBUSLABELMEMBER:
@@ -695,118 +808,112 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
         }
     }
 
-    // build global labels and compare
-    std::set<NETLIST_OBJECT*, compare_label_names> loc_labelList;
-    std::set<NETLIST_OBJECT*>::const_iterator it;
+    // Each label appears only once in the unique list: the first one found
+    // for a given "sheetpath+label" text (used to to detect similar labels)
+    std::unordered_map<wxString, SIMILAR_LABEL*, WXSTRING_HASH> uniqueLabels;
+    std::vector<SIMILAR_LABEL*> uniqueLabelList;
 
-    for( it = uniqueLabelList.begin(); it != uniqueLabelList.end(); ++it )
+    for( SIMILAR_LABEL& label : fullLabelList )
     {
-        if( (*it)->IsLabelGlobal() )
-            loc_labelList.insert( *it );
+        if( uniqueLabels.insert( std::make_pair( label.m_Path + label.m_Item->m_Label,
+                                                 &label ) ).second )
+            uniqueLabelList.push_back( &label );
     }
 
-    // compare global labels (same label names appears only once in list)
-    for( it = loc_labelList.begin(); it != loc_labelList.end(); ++it )
+    // build global labels and compare: each global label name appears once, as the
+    // first one in "sheetpath+label" order.
+    std::unordered_map<wxString, SIMILAR_LABEL*, WXSTRING_HASH> globalLabels;
+
+    for( SIMILAR_LABEL* label : uniqueLabelList )
     {
-        std::set<NETLIST_OBJECT*>::const_iterator it_aux = it;
+        if( !label->m_Item->IsLabelGlobal() )
+            continue;
 
-        for( ++it_aux; it_aux != loc_labelList.end(); ++it_aux )
-        {
-            if( (*it)->m_Label.CmpNoCase( (*it_aux)->m_Label ) == 0 )
-            {
-                // Create new marker for ERC.
-                int cntA = countIndenticalLabels( fullLabelList, *it );
-                int cntB = countIndenticalLabels( fullLabelList, *it_aux );
-
-                if( cntA <= cntB )
-                    SimilarLabelsDiagnose( (*it), (*it_aux) );
-                else
-                    SimilarLabelsDiagnose( (*it_aux), (*it) );
-            }
-        }
-    }
+        SIMILAR_LABEL*& first = globalLabels[label->m_Item->m_Label];
 
-    // Build paths list
-    std::set<NETLIST_OBJECT*, compare_paths> pathsList;
+        if( !first || ( label->m_Path + label->m_Item->m_Label ).Cmp(
+                                first->m_Path + first->m_Item->m_Label ) < 0 )
+            first = label;
+    }
 
-    for( it = uniqueLabelList.begin(); it != uniqueLabelList.end(); ++it )
-        pathsList.insert( *it );
+    // Group the global labels by case folded names
+    std::unordered_map<wxString, unsigned, WXSTRING_HASH> groupIndex;
+    std::vector< std::vector<SIMILAR_LABEL*> > groups;
+    std::vector<SIMILAR_LABEL*> similarLabels;
 
-    // Examine each label inside a sheet path:
-    for( it = pathsList.begin(); it != pathsList.end(); ++it )
+    for( auto& entry : globalLabels )
     {
-        loc_labelList.clear();
+        SIMILAR_LABEL* label = entry.second;
+        auto it = groupIndex.insert( std::make_pair( label->m_Item->m_Label.Lower(),
+                                                     groups.size() ) ).first;
 
-        std::set<NETLIST_OBJECT*>::const_iterator it_aux = uniqueLabelList.begin();
+        if( it->second == groups.size() )
+            groups.push_back( std::vector<SIMILAR_LABEL*>() );
 
-        for( ; it_aux != uniqueLabelList.end(); ++it_aux )
-        {
-            if( (*it)->m_SheetPath.Path() == (*it_aux)->m_SheetPath.Path() )
-                loc_labelList.insert( *it_aux );
-        }
+        label->m_Group = it->second;
+        groups[it->second].push_back( label );
+    }
 
-        // at this point, loc_labelList contains labels of the current sheet path.
-        // Detect similar labels (same label names appears only once in list)
-        std::set<NETLIST_OBJECT*>::const_iterator ref_it;
+    for( std::vector<SIMILAR_LABEL*>& group : groups )
+    {
+        if( group.size() < 2 )
+            continue;
 
-        for( ref_it = loc_labelList.begin(); ref_it != loc_labelList.end(); ++ref_it )
-        {
-            NETLIST_OBJECT* ref_item = *ref_it;
-            it_aux = ref_it;
+        std::sort( group.begin(), group.end(), compareLabelNames );
+        similarLabels.insert( similarLabels.end(), group.begin(), group.end() );
+    }
+
+    std::sort( similarLabels.begin(), similarLabels.end(), compareLabelNames );
 
-            for( ++it_aux; it_aux != loc_labelList.end(); ++it_aux )
+    // compare global labels (same label names appears only once in list):
+    // the count is the number of identical global labels in the full project
+    diagnoseSimilarLabels( similarLabels, groups, false,
+            [&]( const SIMILAR_LABEL* aLabel ) -> int
             {
-                // global label versus global label was already examined.
-                // here, at least one label must be local
-                if( ref_item->IsLabelGlobal() && (*it_aux)->IsLabelGlobal() )
-                    continue;
+                return globalCounts[aLabel->m_Item->m_Label];
+            } );
 
-                if( ref_item->m_Label.CmpNoCase( (*it_aux)->m_Label ) == 0 )
-                {
-                    // Create new marker for ERC.
-                    int cntA = countIndenticalLabels( fullLabelList, ref_item );
-                    int cntB = countIndenticalLabels( fullLabelList, *it_aux );
-
-                    if( cntA <= cntB )
-                        SimilarLabelsDiagnose( ref_item, (*it_aux) );
-                    else
-                        SimilarLabelsDiagnose( (*it_aux), ref_item );
-                }
-            }
-        }
-    }
-}
+    // Examine each label inside a sheet path: group the labels by sheet path
+    // and case folded names
+    groupIndex.clear();
+    groups.clear();
+    similarLabels.clear();
 
-// Helper function: count the number of labels identical to aLabel
-//  for global label: global labels in the full project
-//  for local label: all labels in the current sheet
-static int countIndenticalLabels( std::vector<NETLIST_OBJECT*>& aList, NETLIST_OBJECT* aLabel )
-{
-    int count = 0;
-
-    if( aLabel->IsLabelGlobal() )
+    for( SIMILAR_LABEL* label : uniqueLabelList )
     {
-        for( unsigned netItem = 0; netItem < aList.size(); ++netItem )
-        {
-            NETLIST_OBJECT* item = aList[netItem];
+        auto it = groupIndex.insert( std::make_pair( label->m_Path + wxT( "\n" )
+                                                     + label->m_Item->m_Label.Lower(),
+                                                     groups.size() ) ).first;
 
-            if( item->IsLabelGlobal() && item->m_Label == aLabel->m_Label )
-                count++;
-        }
+        if( it->second == groups.size() )
+            groups.push_back( std::vector<SIMILAR_LABEL*>() );
+
+        label->m_Group = it->second;
+        groups[it->second].push_back( label );
     }
-    else
+
+    for( std::vector<SIMILAR_LABEL*>& group : groups )
     {
-        for( unsigned netItem = 0; netItem < aList.size(); ++netItem )
-        {
-            NETLIST_OBJECT* item = aList[netItem];
+        if( group.size() < 2 )
+            continue;
 
-            if( item->m_Label == aLabel->m_Label &&
-                item->m_SheetPath.Path() == aLabel->m_SheetPath.Path() )
-                count++;
-        }
+        std::sort( group.begin(), group.end(), compareLabelNames );
+        similarLabels.insert( similarLabels.end(), group.begin(), group.end() );
     }
 
-    return count;
+    std::sort( similarLabels.begin(), similarLabels.end(), comparePathsAndLabelNames );
+
+    // at least one label of a pair must be local:
+    // for global label: the count is global labels in the full project
+    // for local label: all labels in the current sheet
+    diagnoseSimilarLabels( similarLabels, groups, true,
+            [&]( const SIMILAR_LABEL* aLabel ) -> int
+            {
+                if( aLabel->m_Item->IsLabelGlobal() )
+                    return globalCounts[aLabel->m_Item->m_Label];
+
+                return localCounts[aLabel->m_Path][aLabel->m_Item->m_Label];
+            } );
 }
 
 // Helper function: creates a marker for similar labels ERC warning
@@ -131,27 +131,64 @@ NETLIST_OBJECT_LIST::~NETLIST_OBJECT_LIST()
 
 void NETLIST_OBJECT_LIST::Clear()
 {
-    NETLIST_OBJECTS::iterator iter;
+    clear();
+    m_blocks.clear();
+    m_blockSize = 0;
+    m_blockUsed = 0;
+}
+
+
+// Items are allocated by blocks: a design has many thousands of them, all freed
+// at the same time.  Each sheet has its own list while building the net list, and
+// most sheets are small: the first block is small, and the next ones are bigger.
+#define NETLIST_OBJECT_MIN_BLOCK_SIZE   16
+#define NETLIST_OBJECT_MAX_BLOCK_SIZE   1024
 
-    for( iter = begin(); iter != end(); iter++ )
+NETLIST_OBJECT* NETLIST_OBJECT_LIST::NewItem( NETLIST_OBJECT* aSource )
+{
+    if( m_blocks.empty() || m_blockUsed >= m_blockSize )
     {
-        NETLIST_OBJECT* item = *iter;
-        delete item;
+        if( m_blocks.empty() )
+            m_blockSize = NETLIST_OBJECT_MIN_BLOCK_SIZE;
+        else
+            m_blockSize = std::min( 2 * m_blockSize, (unsigned) NETLIST_OBJECT_MAX_BLOCK_SIZE );
+
+        m_blocks.emplace_back( new NETLIST_OBJECT[m_blockSize] );
+        m_blockUsed = 0;
     }
 
-    clear();
+    NETLIST_OBJECT* item = &m_blocks.back()[m_blockUsed++];
+
+    if( aSource )
+        *item = *aSource;
+
+    return item;
 }
 
 
-void NETLIST_OBJECT_LIST::SortListbyNetcode()
+void NETLIST_OBJECT_LIST::takeItems( NETLIST_OBJECT_LIST& aList )
 {
-    sort( this->begin(), this->end(), NETLIST_OBJECT_LIST::sortItemsbyNetcode );
+    insert( end(), aList.begin(), aList.end() );
+    aList.clear();
+
+    if( aList.m_blocks.empty() )
+        return;
+
+    // The last block of aList becomes the block new items are taken from
+    for( unsigned ii = 0; ii < aList.m_blocks.size(); ii++ )
+        m_blocks.push_back( std::move( aList.m_blocks[ii] ) );
+
+    m_blockSize = aList.m_blockSize;
+    m_blockUsed = aList.m_blockUsed;
+    aList.m_blocks.clear();
+    aList.m_blockSize = 0;
+    aList.m_blockUsed = 0;
 }
 
 
-void NETLIST_OBJECT_LIST::SortListbySheet()
+void NETLIST_OBJECT_LIST::SortListbyNetcode()
 {
-    sort( this->begin(), this->end(), NETLIST_OBJECT_LIST::sortItemsBySheet );
+    sort( this->begin(), this->end(), NETLIST_OBJECT_LIST::sortItemsbyNetcode );
 }
 
 
@@ -164,7 +201,7 @@ NETLIST_OBJECT_LIST* SCH_EDIT_FRAME::BuildNetListBase()
     SCH_SHEET_LIST aSheets( g_RootSheet );
 
     // Build netlist info
-    bool success = ret->BuildNetListInfo( aSheets );
+    bool success = ret->BuildNetListInfo( aSheets, m_connectivityCache );
 
     if( !success )
     {
@@ -180,44 +217,208 @@ NETLIST_OBJECT_LIST* SCH_EDIT_FRAME::BuildNetListBase()
 }
 
 
-bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
+bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets,
+                                            SHEET_CONNECTIVITY_CACHE* aCache )
 {
-    SCH_SHEET_PATH* sheet;
+    // Connections found by the previous call, for the sheets still in the hierarchy
+    std::vector<SHEET_CONNECTIVITY_CACHE::SHEET*> sheetCaches( aSheets.size(), NULL );
+
+    if( aCache )
+    {
+        std::map<SCH_SHEETS, SHEET_CONNECTIVITY_CACHE::SHEET> sheets;
+
+        for( unsigned i = 0; i < aSheets.size();  i++ )
+        {
+            auto cached = aCache->m_sheets.find( aSheets[i] );
+
+            if( cached != aCache->m_sheets.end() )
+                sheets[aSheets[i]] = std::move( cached->second );
+
+            sheetCaches[i] = &sheets[aSheets[i]];
+        }
+
+        aCache->m_sheets.swap( sheets );
+    }
+
+    // Fill list with connected items from the flattened sheet list, and connect the
+    // items inside each sheet.
+    // Sheets are handled in parallel, each one in its own list, and the lists are
+    // appended in sheet order: the result does not depend on the thread count.
+    std::vector<NETLIST_OBJECT_LIST> sheetItems( aSheets.size() );
 
-    // Fill list with connected items from the flattened sheet list
-    for( unsigned i = 0; i < aSheets.size();  i++ )
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for( int i = 0; i < (int) aSheets.size();  i++ )
+    {
+        SCH_SHEET_PATH* sheetPath = &aSheets[i];
+
+        for( SCH_ITEM* item = sheetPath->LastScreen()->GetDrawItems(); item; item = item->Next() )
+        {
+            item->GetNetListItem( sheetItems[i], sheetPath );
+        }
+
+        sheetItems[i].connectSheetItems( sheetCaches[i] );
+    }
+
+    // Net codes of each sheet start at 1: shift them to make them unique
+    int netCodeShift = 0;
+    int busNetCodeShift = 0;
+
+    for( unsigned i = 0; i < sheetItems.size();  i++ )
     {
-        sheet = &aSheets[i];
+        NETLIST_OBJECT_LIST& sheetList = sheetItems[i];
 
-        for( SCH_ITEM* item = sheet->LastScreen()->GetDrawItems(); item; item = item->Next() )
+        for( unsigned ii = 0; ii < sheetList.size(); ii++ )
         {
-            item->GetNetListItem( *this, sheet );
+            NETLIST_OBJECT* net_item = sheetList.GetItem( ii );
+
+            if( net_item->m_Type == NET_ITEM_UNSPECIFIED )
+                wxMessageBox( wxT( "BuildNetListInfo() error" ) );
+
+            if( net_item->GetNet() )
+                net_item->SetNet( net_item->GetNet() + netCodeShift );
+
+            if( net_item->m_BusNetCode )
+                net_item->m_BusNetCode += busNetCodeShift;
         }
+
+        netCodeShift += sheetList.m_lastNetCode - 1;
+        busNetCodeShift += sheetList.m_lastBusNetCode - 1;
+        takeItems( sheetList );
     }
 
     if( size() == 0 )
         return false;
 
-    // Sort objects by Sheet
-    SortListbySheet();
+    m_lastNetCode = netCodeShift + 1;
+    m_lastBusNetCode = busNetCodeShift + 1;
 
-    sheet = &(GetItem( 0 )->m_SheetPath);
-    m_lastNetCode = m_lastBusNetCode = 1;
+#if defined(NETLIST_DEBUG) && defined(DEBUG)
+    std::cout << "\n\nafter sheet local\n\n";
+    DumpNetTable();
+#endif
 
-    for( unsigned ii = 0, istart = 0; ii < size(); ii++ )
+    // Updating the Bus Labels Netcode connected by Bus
+    connectBusLabels();
+
+    // Group objects by label.
+    for( unsigned ii = 0; ii < size(); ii++ )
     {
-        NETLIST_OBJECT* net_item = GetItem( ii );
+        switch( GetItem( ii )->m_Type )
+        {
+        case NET_PIN:
+        case NET_SHEETLABEL:
+        case NET_SEGMENT:
+        case NET_JUNCTION:
+        case NET_BUS:
+        case NET_NOCONNECT:
+            break;
+
+        case NET_LABEL:
+        case NET_GLOBLABEL:
+        case NET_PINLABEL:
+        case NET_BUSLABELMEMBER:
+        case NET_GLOBBUSLABELMEMBER:
+            labelConnect( GetItem( ii ) );
+            break;
 
-        if( net_item->m_SheetPath != *sheet )   // Sheet change
+        case NET_SHEETBUSLABELMEMBER:
+        case NET_HIERLABEL:
+        case NET_HIERBUSLABELMEMBER:
+            break;
+
+        case NET_ITEM_UNSPECIFIED:
+            break;
+        }
+    }
+
+#if defined(NETLIST_DEBUG) && defined(DEBUG)
+    std::cout << "\n\nafter sheet global\n\n";
+    DumpNetTable();
+#endif
+
+    // Connection between hierarchy sheets
+    for( unsigned ii = 0; ii < size(); ii++ )
+    {
+        if( GetItem( ii )->m_Type == NET_SHEETLABEL
+            || GetItem( ii )->m_Type == NET_SHEETBUSLABELMEMBER )
+            sheetLabelConnect( GetItem( ii ) );
+    }
+
+    // Sort objects by NetCode
+    SortListbyNetcode();
+
+#if defined(NETLIST_DEBUG) && defined(DEBUG)
+    std::cout << "\n\nafter qsort()\n";
+    DumpNetTable();
+#endif
+
+    // Compress numbers of Netcode having consecutive values.
+    int NetCode = 0;
+    m_lastNetCode = 0;
+
+    for( unsigned ii = 0; ii < size(); ii++ )
+    {
+        if( GetItem( ii )->GetNet() != m_lastNetCode )
         {
-            sheet  = &(net_item->m_SheetPath);
-            istart = ii;
+            NetCode++;
+            m_lastNetCode = GetItem( ii )->GetNet();
         }
 
+        GetItem( ii )->SetNet( NetCode );
+    }
+
+    // Set the minimal connection info:
+    setUnconnectedFlag();
+
+    // find the best label object to give the best net name to each net
+    findBestNetNameForEachNet();
+
+    return true;
+}
+
+void NETLIST_OBJECT_LIST::connectSheetItems( SHEET_CONNECTIVITY_CACHE::SHEET* aSheetCache )
+{
+    // The connections depend only on the type and the position of the items:
+    // reuse the ones found for the same items
+    if( aSheetCache && aSheetCache->m_Items.size() == size() )
+    {
+        unsigned ii = 0;
+
+        for( ; ii < size(); ii++ )
+        {
+            const NETLIST_OBJECT*                 net_item = GetItem( ii );
+            const SHEET_CONNECTIVITY_CACHE::ITEM& cached = aSheetCache->m_Items[ii];
+
+            if( net_item->m_Type != cached.m_Type || net_item->m_Start != cached.m_Start
+                || net_item->m_End != cached.m_End )
+                break;
+        }
+
+        if( ii == size() )
+        {
+            for( ii = 0; ii < size(); ii++ )
+            {
+                GetItem( ii )->SetNet( aSheetCache->m_Items[ii].m_NetCode );
+                GetItem( ii )->m_BusNetCode = aSheetCache->m_Items[ii].m_BusNetCode;
+            }
+
+            m_lastNetCode = aSheetCache->m_LastNetCode;
+            m_lastBusNetCode = aSheetCache->m_LastBusNetCode;
+            return;
+        }
+    }
+
+    m_lastNetCode = m_lastBusNetCode = 1;
+
+    for( unsigned ii = 0, istart = 0; ii < size(); ii++ )
+    {
+        NETLIST_OBJECT* net_item = GetItem( ii );
+
         switch( net_item->m_Type )
         {
-        case NET_ITEM_UNSPECIFIED:
-            wxMessageBox( wxT( "BuildNetListInfo() error" ) );
+        case NET_ITEM_UNSPECIFIED:      // Reported by BuildNetListInfo()
             break;
 
         case NET_PIN:
@@ -301,90 +502,28 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         }
     }
 
-#if defined(NETLIST_DEBUG) && defined(DEBUG)
-    std::cout << "\n\nafter sheet local\n\n";
-    DumpNetTable();
-#endif
-
-    // Updating the Bus Labels Netcode connected by Bus
-    connectBusLabels();
-
-    // Group objects by label.
-    for( unsigned ii = 0; ii < size(); ii++ )
-    {
-        switch( GetItem( ii )->m_Type )
-        {
-        case NET_PIN:
-        case NET_SHEETLABEL:
-        case NET_SEGMENT:
-        case NET_JUNCTION:
-        case NET_BUS:
-        case NET_NOCONNECT:
-            break;
-
-        case NET_LABEL:
-        case NET_GLOBLABEL:
-        case NET_PINLABEL:
-        case NET_BUSLABELMEMBER:
-        case NET_GLOBBUSLABELMEMBER:
-            labelConnect( GetItem( ii ) );
-            break;
-
-        case NET_SHEETBUSLABELMEMBER:
-        case NET_HIERLABEL:
-        case NET_HIERBUSLABELMEMBER:
-            break;
-
-        case NET_ITEM_UNSPECIFIED:
-            break;
-        }
-    }
-
-#if defined(NETLIST_DEBUG) && defined(DEBUG)
-    std::cout << "\n\nafter sheet global\n\n";
-    DumpNetTable();
-#endif
-
-    // Connection between hierarchy sheets
-    for( unsigned ii = 0; ii < size(); ii++ )
+    if( aSheetCache )
     {
-        if( GetItem( ii )->m_Type == NET_SHEETLABEL
-            || GetItem( ii )->m_Type == NET_SHEETBUSLABELMEMBER )
-            sheetLabelConnect( GetItem( ii ) );
-    }
+        aSheetCache->m_Items.resize( size() );
 
-    // Sort objects by NetCode
-    SortListbyNetcode();
-
-#if defined(NETLIST_DEBUG) && defined(DEBUG)
-    std::cout << "\n\nafter qsort()\n";
-    DumpNetTable();
-#endif
-
-    // Compress numbers of Netcode having consecutive values.
-    int NetCode = 0;
-    m_lastNetCode = 0;
-
-    for( unsigned ii = 0; ii < size(); ii++ )
-    {
-        if( GetItem( ii )->GetNet() != m_lastNetCode )
+        for( unsigned ii = 0; ii < size(); ii++ )
         {
-            NetCode++;
-            m_lastNetCode = GetItem( ii )->GetNet();
+            const NETLIST_OBJECT*           net_item = GetItem( ii );
+            SHEET_CONNECTIVITY_CACHE::ITEM& cached = aSheetCache->m_Items[ii];
+
+            cached.m_Type = net_item->m_Type;
+            cached.m_Start = net_item->m_Start;
+            cached.m_End = net_item->m_End;
+            cached.m_NetCode = net_item->GetNet();
+            cached.m_BusNetCode = net_item->m_BusNetCode;
         }
 
-        GetItem( ii )->SetNet( NetCode );
+        aSheetCache->m_LastNetCode = m_lastNetCode;
+        aSheetCache->m_LastBusNetCode = m_lastBusNetCode;
     }
-
-    // Set the minimal connection info:
-    setUnconnectedFlag();
-
-    // find the best label object to give the best net name to each net
-    findBestNetNameForEachNet();
-
-    return true;
 }
 
+
 // Helper function to give a priority to sort labels:
 // NET_PINLABEL, NET_GLOBBUSLABELMEMBER and NET_GLOBLABEL are global labels
 // and the priority is high
@@ -609,7 +748,7 @@ void NETLIST_OBJECT_LIST::sheetLabelConnect( NETLIST_OBJECT* SheetLabel )
     {
         NETLIST_OBJECT* ObjetNet = GetItem( ii );
 
-        if( ObjetNet->m_SheetPath != SheetLabel->m_SheetPathInclude )
+        if( !SheetLabel->IsSheetPathInclude( ObjetNet->m_SheetPath ) )
             continue;  //use SheetInclude, not the sheet!!
 
         if( (ObjetNet->m_Type != NET_HIERLABEL ) && (ObjetNet->m_Type != NET_HIERBUSLABELMEMBER ) )
@@ -24,6 +24,7 @@
  */
 
 #include <build_version.h>
+#include <confirm.h>
 #include <sch_base_frame.h>
 #include <class_library.h>
 
@@ -38,12 +39,85 @@ bool NETLIST_EXPORTER_GENERIC::WriteNetlist( const wxString& aOutFileName, unsig
     for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
         m_masterList->GetItem( ii )->m_Flag = 0;
 
-    // output the XML format netlist.
-    wxXmlDocument   xdoc;
+    // output the XML format netlist. It is written as the sections are built, and
+    // is the same as the wxXmlDocument::Save() output of the makeRoot( GNL_ALL ) tree:
+    // the BOM generators parse it.
+    try
+    {
+        // Binary mode: wxXmlDocument only writes '\n' line ends.
+        FILE_OUTPUTFORMATTER formatter( aOutFileName, wxT( "wb" ) );
+
+        m_xmlOutput = &formatter;
+
+        formatter.Print( 0, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+        formatter.Print( 0, "<export version=\"D\">" );
+
+        writeSection( makeDesignHeader() );
+        writeSection( makeComponents() );
+        writeSection( makeLibParts() );
+        writeSection( makeLibraries() );    // must follow makeLibParts()
+        writeSection( makeListOfNets() );
+
+        formatter.Print( 0, "\n</export>\n" );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        // The section being built when the error occurred is not owned by writeSection()
+        delete m_openSection;
+        m_openSection = NULL;
+        m_xmlOutput = NULL;
+        DisplayError( NULL, ioe.What() );
+        return false;
+    }
+
+    m_xmlOutput = NULL;
+
+    return true;
+}
+
+
+void NETLIST_EXPORTER_GENERIC::addChild( XNODE* aSection, XNODE* aChild )
+{
+    std::unique_ptr<XNODE> child( aChild );
+
+    if( !m_xmlOutput )
+    {
+        aSection->AddChild( child.release() );
+        return;
+    }
+
+    // The section has the indentation 2 in the root node, its children 4.
+    // It is recorded before writing, so WriteNetlist() deletes it on error.
+    if( aSection != m_openSection )
+    {
+        m_openSection = aSection;
+        m_xmlOutput->Print( 0, "\n  <%s>", TO_UTF8( aSection->GetName() ) );
+    }
+
+    if( aChild->GetType() != wxXML_TEXT_NODE )
+        m_xmlOutput->Print( 0, "\n    " );
+
+    aChild->FormatXml( m_xmlOutput, 4 );
+}
 
-    xdoc.SetRoot( makeRoot( GNL_ALL ) );
 
-    return xdoc.Save( aOutFileName, 2 /* indent bug, today was ignored by wxXml lib */ );
+void NETLIST_EXPORTER_GENERIC::writeSection( XNODE* aSection )
+{
+    std::unique_ptr<XNODE> section( aSection );
+    bool isOpen = ( aSection == m_openSection );
+
+    // aSection is owned here from now on
+    m_openSection = NULL;
+
+    if( isOpen )
+    {
+        m_xmlOutput->Print( 0, "\n  </%s>", TO_UTF8( aSection->GetName() ) );
+    }
+    else
+    {
+        m_xmlOutput->Print( 0, "\n  " );
+        aSection->FormatXml( m_xmlOutput, 2 );
+    }
 }
 
 
@@ -130,7 +204,7 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeComponents()
             // under XSL processing systems which do sequential searching within
             // an element.
 
-            xcomps->AddChild( xcomp = node( sComponent ) );
+            xcomp = node( sComponent );
             xcomp->AddAttribute( sRef, comp->GetRef( &sheetList[i] ) );
 
             xcomp->AddChild( node( sValue, comp->GetField( VALUE )->GetText() ) );
@@ -183,6 +257,8 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeComponents()
 
             timeStamp.Printf( sTSFmt, (unsigned long)comp->GetTimeStamp() );
             xcomp->AddChild( node( sTStamp, timeStamp ) );
+
+            addChild( xcomps, xcomp );
         }
     }
 
@@ -201,12 +277,12 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeDesignHeader()
     wxFileName sourceFileName;
 
     // the root sheet is a special sheet, call it source
-    xdesign->AddChild( node( wxT( "source" ), g_RootSheet->GetScreen()->GetFileName() ) );
+    addChild( xdesign, node( wxT( "source" ), g_RootSheet->GetScreen()->GetFileName() ) );
 
-    xdesign->AddChild( node( wxT( "date" ), DateAndTime() ) );
+    addChild( xdesign, node( wxT( "date" ), DateAndTime() ) );
 
     // which Eeschema tool
-    xdesign->AddChild( node( wxT( "tool" ), wxT( "Eeschema " ) + GetBuildVersion() ) );
+    addChild( xdesign, node( wxT( "tool" ), wxT( "Eeschema " ) + GetBuildVersion() ) );
 
     /*
         Export the sheets information
@@ -217,7 +293,7 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeDesignHeader()
     {
         screen = sheetList[i].LastScreen();
 
-        xdesign->AddChild( xsheet = node( wxT( "sheet" ) ) );
+        xsheet = node( wxT( "sheet" ) );
 
         // get the string representation of the sheet index number.
         // Note that sheet->GetIndex() is zero index base and we need to increment the
@@ -256,6 +332,8 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeDesignHeader()
         xtitleBlock->AddChild( xcomment = node( wxT( "comment" ) ) );
         xcomment->AddAttribute( wxT("number"), wxT("4") );
         xcomment->AddAttribute( wxT( "value" ), tb.GetComment4() );
+
+        addChild( xdesign, xsheet );
     }
 
     return xdesign;
@@ -271,11 +349,13 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeLibraries()
         PART_LIB*    lib = (PART_LIB*) *it;
         XNODE*      xlibrary;
 
-        xlibs->AddChild( xlibrary = node( wxT( "library" ) ) );
+        xlibrary = node( wxT( "library" ) );
         xlibrary->AddAttribute( wxT( "logical" ), lib->GetLogicalName() );
         xlibrary->AddChild( node( wxT( "uri" ),  lib->GetFullFileName() ) );
 
         // @todo: add more fun stuff here
+
+        addChild( xlibs, xlibrary );
     }
 
     return xlibs;
@@ -316,7 +396,7 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeLibParts()
         m_Libraries.insert( library );  // inserts component's library if unique
 
         XNODE* xlibpart;
-        xlibparts->AddChild( xlibpart = node( sLibpart ) );
+        xlibpart = node( sLibpart );
         xlibpart->AddAttribute( sLib, library->GetLogicalName() );
         xlibpart->AddAttribute( sPart, lcomp->GetName()  );
 
@@ -409,6 +489,8 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeLibParts()
                 // caution: construction work site here, drive slowly
             }
         }
+
+        addChild( xlibparts, xlibpart );
     }
 
     return xlibparts;
@@ -473,7 +555,11 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeListOfNets()
 
         if( ++sameNetcodeCount == 1 )
         {
-            xnets->AddChild( xnet = node( sNet ) );
+            // the previous net is complete
+            if( xnet )
+                addChild( xnets, xnet );
+
+            xnet = node( sNet );
             netCodeTxt.Printf( sFmtd, netCode );
             xnet->AddAttribute( sCode, netCodeTxt );
             xnet->AddAttribute( sName, netName );
@@ -485,6 +571,9 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeListOfNets()
         xnode->AddAttribute( sPin,  nitem->GetPinNumText() );
     }
 
+    if( xnet )
+        addChild( xnets, xnet );
+
     return xnets;
 }
 
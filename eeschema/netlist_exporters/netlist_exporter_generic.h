@@ -55,7 +55,9 @@ class NETLIST_EXPORTER_GENERIC : public NETLIST_EXPORTER
 {
 public:
     NETLIST_EXPORTER_GENERIC( NETLIST_OBJECT_LIST* aMasterList, PART_LIBS* aLibs ) :
-        NETLIST_EXPORTER( aMasterList, aLibs )
+        NETLIST_EXPORTER( aMasterList, aLibs ),
+        m_xmlOutput( NULL ),
+        m_openSection( NULL )
     {
     }
 
@@ -79,6 +81,22 @@ protected:
      */
     XNODE* node( const wxString& aName, const wxString& aTextualContent = wxEmptyString );
 
+    /**
+     * Function addChild
+     * adds the complete element aChild to aSection, a child of the root node.
+     * When WriteNetlist() streams the document, aChild is written to the
+     * output file and deleted instead, so only one element of a section is
+     * in memory at a time.
+     */
+    void addChild( XNODE* aSection, XNODE* aChild );
+
+    /**
+     * Function writeSection
+     * writes the end of aSection, or all of it if it has no child, when
+     * WriteNetlist() streams the document.  aSection is deleted.
+     */
+    void writeSection( XNODE* aSection );
+
     /**
      * Function makeGenericRoot
      * builds the entire document tree for the generic export.  This is factored
@@ -123,6 +141,9 @@ protected:
      * @return XNODE* - the library nodes
      */
     XNODE* makeLibraries();
+
+    OUTPUTFORMATTER*    m_xmlOutput;    ///< The streamed XML output, if any
+    XNODE*              m_openSection;  ///< The section being streamed, deleted on error
 };
 
 #endif
@@ -1894,8 +1894,7 @@ void SCH_COMPONENT::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
 
             wxPoint pos = GetTransform().TransformCoordinate( pin->GetPosition() ) + m_Pos;
 
-            NETLIST_OBJECT* item = new NETLIST_OBJECT();
-            item->m_SheetPathInclude = *aSheetPath;
+            NETLIST_OBJECT* item = aNetListItems.NewItem();
             item->m_Comp = (SCH_ITEM*) pin;
             item->m_SheetPath = *aSheetPath;
             item->m_Type = NET_PIN;
@@ -1910,8 +1909,7 @@ void SCH_COMPONENT::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
             if( pin->IsPowerConnection() )
             {
                 // There is an associated PIN_LABEL.
-                item = new NETLIST_OBJECT();
-                item->m_SheetPathInclude = *aSheetPath;
+                item = aNetListItems.NewItem();
                 item->m_Comp = NULL;
                 item->m_SheetPath = *aSheetPath;
                 item->m_Type  = NET_PINLABEL;
@@ -173,10 +173,9 @@ void SCH_JUNCTION::GetConnectionPoints( std::vector< wxPoint >& aPoints ) const
 void SCH_JUNCTION::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
                                    SCH_SHEET_PATH*          aSheetPath )
 {
-    NETLIST_OBJECT* item = new NETLIST_OBJECT();
+    NETLIST_OBJECT* item = aNetListItems.NewItem();
 
     item->m_SheetPath = *aSheetPath;
-    item->m_SheetPathInclude = *aSheetPath;
     item->m_Comp = (SCH_ITEM*) this;
     item->m_Type = NET_JUNCTION;
     item->m_Start = item->m_End = m_pos;
@@ -45,6 +45,7 @@
 #include <sch_sheet.h>
 #include <sch_bitmap.h>
 #include <sch_legacy_plugin.h>
+#include <sch_legacy_tokenizer.h>
 #include <template_fieldnames.h>
 #include <class_sch_screen.h>
 #include <class_libentry.h>
@@ -58,11 +59,6 @@
 #include <lib_text.h>
 
 
-#define SCH_PARSE_ERROR( text, reader, pos )                         \
-    THROW_PARSE_ERROR( text, reader.GetSource(), reader.Line(),      \
-                       reader.LineNumber(), pos - reader.Line() )
-
-
 // Token delimiters.
 const char* delims = " \t\r\n";
 
@@ -70,380 +66,6 @@ const char* delims = " \t\r\n";
 const wxChar traceSchLegacyPlugin[] = wxT( "KI_SCH_LEGACY_PLUGIN" );
 
 
-/**
- * Function strCompare
- *
- * compares \a aString to the string starting at \a aLine and advances the character point to
- * the end of \a String and returns the new pointer position in \a aOutput if it is not NULL.
- *
- * @param aString - A pointer to the string to compare.
- * @param aLine - A pointer to string to begin the comparison.
- * @param aOutput - A pointer to a string pointer to the end of the comparison if not NULL.
- * @return True if \a aString was found starting at \a aLine.  Otherwise false.
- */
-static bool strCompare( const char* aString, const char* aLine, const char** aOutput = NULL )
-{
-    size_t len = strlen( aString );
-    bool retv = ( strncasecmp( aLine, aString, len ) == 0 ) && isspace( aLine[ len ] );
-
-    if( retv && aOutput )
-    {
-        const char* tmp = aLine;
-
-        // Move past the end of the token.
-        tmp += len;
-
-        // Move to the beginning of the next token.
-        while( *tmp && isspace( *tmp ) )
-            tmp++;
-
-        *aOutput = tmp;
-    }
-
-    return retv;
-}
-
-
-/**
- * Function parseInt
- *
- * parses an ASCII integer string with possible leading whitespace into
- * an integer and updates the pointer at \a aOutput if it is not NULL, just
- * like "man strtol()".
- *
- * @param aReader - The line reader used to generate exception throw information.
- * @param aLine - A pointer the current position in a string.
- * @param aOutput - The pointer to a string pointer to copy the string pointer position when
- *                  the parsing is complete.
- * @return A valid integer value.
- * @throws An #IO_ERROR on an unexpected end of line.
- * @throws A #PARSE_ERROR if the parsed token is not a valid integer.
- */
-static int parseInt( FILE_LINE_READER& aReader, const char* aLine, const char** aOutput = NULL )
-{
-    if( !*aLine )
-        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aLine );
-
-    // Clear errno before calling strtol() in case some other crt call set it.
-    errno = 0;
-
-    long retv = strtol( aLine, (char**) aOutput, 10 );
-
-    // Make sure no error occurred when calling strtol().
-    if( errno == ERANGE )
-        SCH_PARSE_ERROR( "invalid integer value", aReader, aLine );
-
-    // strtol does not strip off whitespace before the next token.
-    if( aOutput )
-    {
-        const char* next = *aOutput;
-
-        while( *next && isspace( *next ) )
-            next++;
-
-        *aOutput = next;
-    }
-
-    return (int) retv;
-}
-
-
-/**
- * Function parseHex
- *
- * parses an ASCII hex integer string with possible leading whitespace into
- * a long integer and updates the pointer at \a aOutput if it is not NULL, just
- * like "man strtol".
- *
- * @param aReader - The line reader used to generate exception throw information.
- * @param aLine - A pointer the current position in a string.
- * @param aOutput - The pointer to a string pointer to copy the string pointer position when
- *                  the parsing is complete.
- * @return A valid integer value.
- * @throws An #IO_ERROR on an unexpected end of line.
- * @throws A #PARSE_ERROR if the parsed token is not a valid integer.
- */
-static unsigned long parseHex( FILE_LINE_READER& aReader, const char* aLine,
-                               const char** aOutput = NULL )
-{
-    if( !*aLine )
-        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aLine );
-
-    unsigned long retv;
-
-    // Clear errno before calling strtoul() in case some other crt call set it.
-    errno = 0;
-    retv = strtoul( aLine, (char**) aOutput, 16 );
-
-    // Make sure no error occurred when calling strtoul().
-    if( errno == ERANGE )
-        SCH_PARSE_ERROR( "invalid hexadecimal number", aReader, aLine );
-
-    // Strip off whitespace before the next token.
-    if( aOutput )
-    {
-        // const char* next = aLine + strlen( token );
-
-        const char* next = *aOutput;
-
-        while( *next && isspace( *next ) )
-            next++;
-
-        *aOutput = next;
-    }
-
-    return retv;
-}
-
-
-/**
- * Function parseDouble
- *
- * parses an ASCII point string with possible leading whitespace into a double precision
- * floating point number and  updates the pointer at \a aOutput if it is not NULL, just
- * like "man strtod".
- *
- * @param aReader - The line reader used to generate exception throw information.
- * @param aLine - A pointer the current position in a string.
- * @param aOutput - The pointer to a string pointer to copy the string pointer position when
- *                  the parsing is complete.
- * @return A valid double value.
- * @throws An #IO_ERROR on an unexpected end of line.
- * @throws A #PARSE_ERROR if the parsed token is not a valid integer.
- */
-static double parseDouble( FILE_LINE_READER& aReader, const char* aLine,
-                           const char** aOutput = NULL )
-{
-    if( !*aLine )
-        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aLine );
-
-    // Clear errno before calling strtod() in case some other crt call set it.
-    errno = 0;
-
-    double retv = strtod( aLine, (char**) aOutput );
-
-    // Make sure no error occurred when calling strtod().
-    if( errno == ERANGE )
-        SCH_PARSE_ERROR( "invalid floating point number", aReader, aLine );
-
-    // strtod does not strip off whitespace before the next token.
-    if( aOutput )
-    {
-        const char* next = *aOutput;
-
-        while( *next && isspace( *next ) )
-            next++;
-
-        *aOutput = next;
-    }
-
-    return retv;
-}
-
-
-/**
- * Function parseChar
- *
- * parses a single ASCII character and updates the pointer at \a aOutput if it is not NULL.
- *
- * @param aReader - The line reader used to generate exception throw information.
- * @param aCurrentToken - A pointer the current position in a string.
- * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
- *                     the parsing is complete.
- * @return A valid ASCII character.
- * @throws An #IO_ERROR on an unexpected end of line.
- * @throws A #PARSE_ERROR if the parsed token is not a a single character token.
- */
-static char parseChar( FILE_LINE_READER& aReader, const char* aCurrentToken,
-                       const char** aNextToken = NULL )
-{
-    while( *aCurrentToken && isspace( *aCurrentToken ) )
-        aCurrentToken++;
-
-    if( !*aCurrentToken )
-        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
-
-    if( !isspace( *( aCurrentToken + 1 ) ) )
-        SCH_PARSE_ERROR( _( "expected single character token" ), aReader, aCurrentToken );
-
-    if( aNextToken )
-    {
-        const char* next = aCurrentToken + 2;
-
-        while( *next && isspace( *next ) )
-            next++;
-
-        *aNextToken = next;
-    }
-
-    return *aCurrentToken;
-}
-
-
-/**
- * Function parseUnquotedString.
- *
- * parses an unquoted utf8 string and updates the pointer at \a aOutput if it is not NULL.
- *
- * The parsed string must be a continuous string with no white space.
- *
- * @param aString - A reference to the parsed string.
- * @param aReader - The line reader used to generate exception throw information.
- * @param aCurrentToken - A pointer the current position in a string.
- * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
- *                     the parsing is complete.
- * @param aCanBeEmpty - True if the parsed string is optional.  False if it is mandatory.
- * @throws An #IO_ERROR on an unexpected end of line.
- * @throws A #PARSE_ERROR if the \a aCanBeEmpty is false and no string was parsed.
- */
-static void parseUnquotedString( wxString& aString, FILE_LINE_READER& aReader,
-                                 const char* aCurrentToken, const char** aNextToken = NULL,
-                                 bool aCanBeEmpty = false )
-{
-    if( !*aCurrentToken )
-    {
-        if( aCanBeEmpty )
-            return;
-        else
-            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
-    }
-
-    const char* tmp = aCurrentToken;
-
-    while( *tmp && isspace( *tmp ) )
-        tmp++;
-
-    if( !*tmp )
-    {
-        if( aCanBeEmpty )
-            return;
-        else
-            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
-    }
-
-    std::string utf8;
-
-    while( *tmp && !isspace( *tmp ) )
-        utf8 += *tmp++;
-
-    aString = FROM_UTF8( utf8.c_str() );
-
-    if( aString.IsEmpty() && !aCanBeEmpty )
-        SCH_PARSE_ERROR( _( "expected unquoted string" ), aReader, aCurrentToken );
-
-    if( aNextToken )
-    {
-        const char* next = tmp;
-
-        while( *next && isspace( *next ) )
-            next++;
-
-        *aNextToken = next;
-    }
-}
-
-
-/**
- * Function parseQuotedString.
- *
- * parses an quoted ASCII utf8 and updates the pointer at \a aOutput if it is not NULL.
- *
- * The parsed string must be contained within a single line.  There are no multi-line
- * quoted strings in the legacy schematic file format.
- *
- * @param aString - A reference to the parsed string.
- * @param aReader - The line reader used to generate exception throw information.
- * @param aCurrentToken - A pointer the current position in a string.
- * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
- *                     the parsing is complete.
- * @param aCanBeEmpty - True if the parsed string is optional.  False if it is mandatory.
- * @throws An #IO_ERROR on an unexpected end of line.
- * @throws A #PARSE_ERROR if the \a aCanBeEmpty is false and no string was parsed.
- */
-static void parseQuotedString( wxString& aString, FILE_LINE_READER& aReader,
-                               const char* aCurrentToken, const char** aNextToken = NULL,
-                               bool aCanBeEmpty = false )
-{
-    if( !*aCurrentToken )
-    {
-        if( aCanBeEmpty )
-            return;
-        else
-            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
-    }
-
-    const char* tmp = aCurrentToken;
-
-    while( *tmp && isspace( *tmp ) )
-        tmp++;
-
-    if( !*tmp )
-    {
-        if( aCanBeEmpty )
-            return;
-        else
-            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
-    }
-
-    // Verify opening quote.
-    if( *tmp != '"' )
-        SCH_PARSE_ERROR( _( "expecting opening quote" ), aReader, aCurrentToken );
-
-    tmp++;
-
-    std::string utf8;     // utf8 without escapes and quotes.
-
-    // Fetch everything up to closing quote.
-    while( *tmp )
-    {
-        if( *tmp == '\\' )
-        {
-            tmp++;
-
-            if( !*tmp )
-                SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
-
-            // Do not copy the escape byte if it is followed by \ or "
-            if( *tmp != '"' && *tmp != '\\' )
-                    utf8 += '\\';
-
-            utf8 += *tmp;
-        }
-        else if( *tmp == '"' )  // Closing double quote.
-        {
-            break;
-        }
-        else
-        {
-            utf8 += *tmp;
-        }
-
-        tmp++;
-    }
-
-    aString = FROM_UTF8( utf8.c_str() );
-
-    if( aString.IsEmpty() && !aCanBeEmpty )
-        SCH_PARSE_ERROR( _( "expected quoted string" ), aReader, aCurrentToken );
-
-    if( *tmp && *tmp != '"' )
-        SCH_PARSE_ERROR( _( "no closing quote for string found" ), aReader, tmp );
-
-    // Move past the closing quote.
-    tmp++;
-
-    if( aNextToken )
-    {
-        const char* next = tmp;
-
-        while( *next && *next == ' ' )
-            next++;
-
-        *aNextToken = next;
-    }
-}
-
-
 SCH_LEGACY_PLUGIN::SCH_LEGACY_PLUGIN()
 {
     init( NULL );
@@ -668,13 +290,13 @@ void SCH_LEGACY_PLUGIN::loadPageSettings( FILE_LINE_READER& aReader, SCH_SCREEN*
     }
     else
     {
-        wxString orientation;
+        const char* orientation;
 
         // Non custom size, set portrait if its present.  Can be empty string which defaults
         // to landscape.
-        parseUnquotedString( orientation, aReader, line, &line, true );
+        size_t len = parseToken( aReader, line, &orientation, &line, true );
 
-        if( orientation == "portrait" )
+        if( len == 8 && strncmp( orientation, "portrait", len ) == 0 )
             pageInfo.SetPortrait( true );
     }
 
@@ -967,9 +589,9 @@ SCH_JUNCTION* SCH_LEGACY_PLUGIN::loadJunction( FILE_LINE_READER& aReader )
 
     wxCHECK( strCompare( "Connection", line, &line ), NULL );
 
-    wxString name;
+    const char* name;
 
-    parseUnquotedString( name, aReader, line, &line );
+    parseToken( aReader, line, &name, &line );     // Not used
 
     wxPoint position;
 
@@ -989,9 +611,9 @@ SCH_NO_CONNECT* SCH_LEGACY_PLUGIN::loadNoConnect( FILE_LINE_READER& aReader )
 
     wxCHECK( strCompare( "NoConn", line, &line ), NULL );
 
-    wxString name;
+    const char* name;
 
-    parseUnquotedString( name, aReader, line, &line );
+    parseToken( aReader, line, &name, &line );     // Not used
 
     wxPoint position;
 
@@ -1162,16 +784,7 @@ SCH_TEXT* SCH_LEGACY_PLUGIN::loadText( FILE_LINE_READER& aReader )
     tmp = strtok( tmp, "\r\n" );
     wxString val = FROM_UTF8( tmp );
 
-    for( ; ; )
-    {
-        int i = val.find( wxT( "\\n" ) );
-
-        if( i == wxNOT_FOUND )
-            break;
-
-        val.erase( i, 2 );
-        val.insert( i, wxT( "\n" ) );
-    }
+    val.Replace( wxT( "\\n" ), wxT( "\n" ) );
 
     text->SetText( val );
 
@@ -1314,10 +927,10 @@ SCH_COMPONENT* SCH_LEGACY_PLUGIN::loadComponent( FILE_LINE_READER& aReader )
             // Prior to version 2 of the schematic file format, none of the following existed.
             if( m_version > 1 )
             {
-                wxString textAttrs;
+                const char* textAttrs;
                 char hjustify = parseChar( aReader, line, &line );
 
-                parseUnquotedString( textAttrs, aReader, line, &line );
+                size_t textAttrsLen = parseToken( aReader, line, &textAttrs, &line );
 
                 // The name of the field is optional.
                 parseQuotedString( name, aReader, line, &line, true );
@@ -1341,7 +954,7 @@ SCH_COMPONENT* SCH_LEGACY_PLUGIN::loadComponent( FILE_LINE_READER& aReader )
                                         "B, T, or C" ), aReader, line );
 
                 // Newer file formats include the bold and italics text attribute.
-                if( textAttrs.Length() != 3 )
+                if( textAttrsLen != 3 )
                     SCH_PARSE_ERROR( _( "component field text attributes must be 3 characters wide" ),
                                      aReader, line );
 
@@ -2529,11 +2142,10 @@ void SCH_LEGACY_PLUGIN_CACHE::loadField( std::unique_ptr< LIB_PART >& aPart,
             SCH_PARSE_ERROR( _( "invalid field text horizontal justification parameter" ),
                              aReader, line );
 
-        wxString attributes;
-
-        parseUnquotedString( attributes, aReader, line, &line );
+        const char* attributes;
+        size_t attributesLen = parseToken( aReader, line, &attributes, &line );
 
-        if( !(attributes.size() == 3 || attributes.size() == 1 ) )
+        if( !(attributesLen == 3 || attributesLen == 1 ) )
             SCH_PARSE_ERROR( _( "invalid field text attributes size" ),
                              aReader, line );
 
@@ -2547,7 +2159,7 @@ void SCH_LEGACY_PLUGIN_CACHE::loadField( std::unique_ptr< LIB_PART >& aPart,
             SCH_PARSE_ERROR( _( "invalid field text vertical justification parameter" ),
                              aReader, line );
 
-        if( attributes.size() == 3 )
+        if( attributesLen == 3 )
         {
             if( attributes[1] == 'I' )        // Italic
                 field->SetItalic( true );
@@ -2936,10 +2548,10 @@ LIB_PIN* SCH_LEGACY_PLUGIN_CACHE::loadPin( std::unique_ptr< LIB_PART >& aPart,
 
     char type = parseChar( aReader, line, &line );
 
-    wxString attributes;
+    const char* attributes;
 
     // Optional
-    parseUnquotedString( attributes, aReader, line, &line, true );
+    size_t attributesLen = parseToken( aReader, line, &attributes, &line, true );
 
     switch( type )
     {
@@ -2991,7 +2603,7 @@ LIB_PIN* SCH_LEGACY_PLUGIN_CACHE::loadPin( std::unique_ptr< LIB_PART >& aPart,
         SCH_PARSE_ERROR( _( "unknown pin type" ), aReader, line );
     }
 
-    if( !attributes.IsEmpty() )       /* Special Symbol defined */
+    if( attributesLen )       /* Special Symbol defined */
     {
         enum
         {
@@ -3005,9 +2617,9 @@ LIB_PIN* SCH_LEGACY_PLUGIN_CACHE::loadPin( std::unique_ptr< LIB_PART >& aPart,
 
         int flags = 0;
 
-        for( int j = attributes.size(); j > 0; )
+        for( int j = attributesLen; j > 0; )
         {
-            switch( attributes[--j].GetValue() )
+            switch( attributes[--j] )
             {
             case '~':
                 break;
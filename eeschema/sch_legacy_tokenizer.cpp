@@ -0,0 +1,413 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 CERN
+ * Copyright (C) 2016 KiCad Developers, see change_log.txt for contributors.
+ *
+ * @author Wayne Stambaugh <stambaughw@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include <sch_legacy_tokenizer.h>
+
+
+// Converts aLength bytes of utf8 text to a wxString like FROM_UTF8(), without copying
+// them to a null terminated string first.
+static wxString fromUTF8( const char* aText, size_t aLength )
+{
+    wxString text = wxString::FromUTF8( aText, aLength );
+
+    if( text.IsEmpty() && aLength )     // happens when aText is not a valid UTF8 sequence
+        text = wxConvCurrent->cMB2WC( std::string( aText, aLength ).c_str() );
+
+    return text;
+}
+
+
+static inline bool isDigit( char aChar )
+{
+    return aChar >= '0' && aChar <= '9';
+}
+
+
+static inline int hexDigitValue( char aChar )
+{
+    if( aChar >= '0' && aChar <= '9' )
+        return aChar - '0';
+
+    if( aChar >= 'a' && aChar <= 'f' )
+        return aChar - 'a' + 10;
+
+    if( aChar >= 'A' && aChar <= 'F' )
+        return aChar - 'A' + 10;
+
+    return -1;
+}
+
+
+bool strCompare( const char* aString, const char* aLine, const char** aOutput )
+{
+    size_t len = strlen( aString );
+    bool retv = ( strncasecmp( aLine, aString, len ) == 0 ) && isspace( aLine[ len ] );
+
+    if( retv && aOutput )
+    {
+        const char* tmp = aLine;
+
+        // Move past the end of the token.
+        tmp += len;
+
+        // Move to the beginning of the next token.
+        while( *tmp && isspace( *tmp ) )
+            tmp++;
+
+        *aOutput = tmp;
+    }
+
+    return retv;
+}
+
+
+int parseInt( FILE_LINE_READER& aReader, const char* aLine, const char** aOutput )
+{
+    if( !*aLine )
+        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aLine );
+
+    // Same result as strtol( aLine, aOutput, 10 ) without its locale and errno overhead:
+    // the files hold millions of integers.
+    const char* tmp = aLine;
+
+    while( *tmp && isspace( *tmp ) )
+        tmp++;
+
+    bool negative = ( *tmp == '-' );
+
+    if( *tmp == '-' || *tmp == '+' )
+        tmp++;
+
+    long retv = 0;
+
+    if( !isDigit( *tmp ) )
+    {
+        // Not a number: strtol() returns 0 and does not move.
+        tmp = aLine;
+    }
+    else
+    {
+        const unsigned long limit = negative ? (unsigned long) LONG_MAX + 1 : LONG_MAX;
+        unsigned long value = 0;
+
+        for( ; isDigit( *tmp ); tmp++ )
+        {
+            unsigned long digit = *tmp - '0';
+
+            if( value > ( limit - digit ) / 10 )
+                SCH_PARSE_ERROR( "invalid integer value", aReader, aLine );
+
+            value = value * 10 + digit;
+        }
+
+        retv = negative ? (long) ( ~value + 1 ) : (long) value;
+    }
+
+    // strtol does not strip off whitespace before the next token.
+    if( aOutput )
+    {
+        const char* next = tmp;
+
+        while( *next && isspace( *next ) )
+            next++;
+
+        *aOutput = next;
+    }
+
+    return (int) retv;
+}
+
+
+unsigned long parseHex( FILE_LINE_READER& aReader, const char* aLine, const char** aOutput )
+{
+    if( !*aLine )
+        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aLine );
+
+    const char* tmp = aLine;
+
+    while( *tmp && isspace( *tmp ) )
+        tmp++;
+
+    unsigned long retv = 0;
+
+    // Time stamps and attributes are plain hex digits, read without strtoul().
+    // Signs and "0x" prefixes are left to strtoul().
+    if( hexDigitValue( *tmp ) >= 0 && !( tmp[0] == '0' && ( tmp[1] == 'x' || tmp[1] == 'X' ) ) )
+    {
+        for( int digit = hexDigitValue( *tmp ); digit >= 0; digit = hexDigitValue( *++tmp ) )
+        {
+            if( retv > ( ULONG_MAX >> 4 ) )
+                SCH_PARSE_ERROR( "invalid hexadecimal number", aReader, aLine );
+
+            retv = ( retv << 4 ) | digit;
+        }
+
+        if( aOutput )
+            *aOutput = tmp;
+    }
+    else
+    {
+        // Clear errno before calling strtoul() in case some other crt call set it.
+        errno = 0;
+        retv = strtoul( aLine, (char**) aOutput, 16 );
+
+        // Make sure no error occurred when calling strtoul().
+        if( errno == ERANGE )
+            SCH_PARSE_ERROR( "invalid hexadecimal number", aReader, aLine );
+    }
+
+    // Strip off whitespace before the next token.
+    if( aOutput )
+    {
+        const char* next = *aOutput;
+
+        while( *next && isspace( *next ) )
+            next++;
+
+        *aOutput = next;
+    }
+
+    return retv;
+}
+
+
+double parseDouble( FILE_LINE_READER& aReader, const char* aLine, const char** aOutput )
+{
+    if( !*aLine )
+        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aLine );
+
+    // Clear errno before calling strtod() in case some other crt call set it.
+    errno = 0;
+
+    double retv = strtod( aLine, (char**) aOutput );
+
+    // Make sure no error occurred when calling strtod().
+    if( errno == ERANGE )
+        SCH_PARSE_ERROR( "invalid floating point number", aReader, aLine );
+
+    // strtod does not strip off whitespace before the next token.
+    if( aOutput )
+    {
+        const char* next = *aOutput;
+
+        while( *next && isspace( *next ) )
+            next++;
+
+        *aOutput = next;
+    }
+
+    return retv;
+}
+
+
+char parseChar( FILE_LINE_READER& aReader, const char* aCurrentToken, const char** aNextToken )
+{
+    while( *aCurrentToken && isspace( *aCurrentToken ) )
+        aCurrentToken++;
+
+    if( !*aCurrentToken )
+        SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
+
+    if( !isspace( *( aCurrentToken + 1 ) ) )
+        SCH_PARSE_ERROR( _( "expected single character token" ), aReader, aCurrentToken );
+
+    if( aNextToken )
+    {
+        const char* next = aCurrentToken + 2;
+
+        while( *next && isspace( *next ) )
+            next++;
+
+        *aNextToken = next;
+    }
+
+    return *aCurrentToken;
+}
+
+
+size_t parseToken( FILE_LINE_READER& aReader, const char* aCurrentToken, const char** aToken,
+                   const char** aNextToken, bool aCanBeEmpty )
+{
+    if( !*aCurrentToken )
+    {
+        if( aCanBeEmpty )
+            return 0;
+        else
+            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
+    }
+
+    const char* tmp = aCurrentToken;
+
+    while( *tmp && isspace( *tmp ) )
+        tmp++;
+
+    if( !*tmp )
+    {
+        if( aCanBeEmpty )
+            return 0;
+        else
+            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
+    }
+
+    *aToken = tmp;
+
+    while( *tmp && !isspace( *tmp ) )
+        tmp++;
+
+    size_t len = tmp - *aToken;
+
+    if( aNextToken )
+    {
+        const char* next = tmp;
+
+        while( *next && isspace( *next ) )
+            next++;
+
+        *aNextToken = next;
+    }
+
+    return len;
+}
+
+
+void parseUnquotedString( wxString& aString, FILE_LINE_READER& aReader,
+                          const char* aCurrentToken, const char** aNextToken,
+                          bool aCanBeEmpty )
+{
+    const char* token;
+    const char* next;
+    size_t      len = parseToken( aReader, aCurrentToken, &token, &next, aCanBeEmpty );
+
+    if( !len )
+        return;
+
+    aString = fromUTF8( token, len );
+
+    if( aString.IsEmpty() && !aCanBeEmpty )
+        SCH_PARSE_ERROR( _( "expected unquoted string" ), aReader, aCurrentToken );
+
+    if( aNextToken )
+        *aNextToken = next;
+}
+
+
+void parseQuotedString( wxString& aString, FILE_LINE_READER& aReader,
+                        const char* aCurrentToken, const char** aNextToken,
+                        bool aCanBeEmpty )
+{
+    if( !*aCurrentToken )
+    {
+        if( aCanBeEmpty )
+            return;
+        else
+            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
+    }
+
+    const char* tmp = aCurrentToken;
+
+    while( *tmp && isspace( *tmp ) )
+        tmp++;
+
+    if( !*tmp )
+    {
+        if( aCanBeEmpty )
+            return;
+        else
+            SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
+    }
+
+    // Verify opening quote.
+    if( *tmp != '"' )
+        SCH_PARSE_ERROR( _( "expecting opening quote" ), aReader, aCurrentToken );
+
+    tmp++;
+
+    // Most strings have no escapes and are converted directly from the line buffer.
+    const char* start = tmp;
+    bool        escaped = false;
+    std::string utf8;     // utf8 without escapes and quotes, when there are escapes.
+
+    // Fetch everything up to closing quote.
+    while( *tmp )
+    {
+        if( *tmp == '\\' )
+        {
+            if( !escaped )
+            {
+                utf8.assign( start, tmp );
+                escaped = true;
+            }
+
+            tmp++;
+
+            if( !*tmp )
+                SCH_PARSE_ERROR( _( "unexpected end of line" ), aReader, aCurrentToken );
+
+            // Do not copy the escape byte if it is followed by \ or "
+            if( *tmp != '"' && *tmp != '\\' )
+                    utf8 += '\\';
+
+            utf8 += *tmp;
+        }
+        else if( *tmp == '"' )  // Closing double quote.
+        {
+            break;
+        }
+        else if( escaped )
+        {
+            utf8 += *tmp;
+        }
+
+        tmp++;
+    }
+
+    if( escaped )
+        aString = fromUTF8( utf8.c_str(), utf8.size() );
+    else
+        aString = fromUTF8( start, tmp - start );
+
+    if( aString.IsEmpty() && !aCanBeEmpty )
+        SCH_PARSE_ERROR( _( "expected quoted string" ), aReader, aCurrentToken );
+
+    if( *tmp && *tmp != '"' )
+        SCH_PARSE_ERROR( _( "no closing quote for string found" ), aReader, tmp );
+
+    // Move past the closing quote.
+    tmp++;
+
+    if( aNextToken )
+    {
+        const char* next = tmp;
+
+        while( *next && *next == ' ' )
+            next++;
+
+        *aNextToken = next;
+    }
+}
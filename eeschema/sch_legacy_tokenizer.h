@@ -0,0 +1,184 @@
+#ifndef _SCH_LEGACY_TOKENIZER_H_
+#define _SCH_LEGACY_TOKENIZER_H_
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 CERN
+ * Copyright (C) 2016 KiCad Developers, see change_log.txt for contributors.
+ *
+ * @author Wayne Stambaugh <stambaughw@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sch_legacy_tokenizer.h
+ * @brief Token parsers of the legacy schematic and symbol library file formats.
+ *
+ * The tokens are read in place in the line buffer of the FILE_LINE_READER.  Numbers and
+ * keywords are never copied, only the tokens holding text are converted to wxString.
+ */
+
+#include <richio.h>
+
+
+#define SCH_PARSE_ERROR( text, reader, pos )                         \
+    THROW_PARSE_ERROR( text, reader.GetSource(), reader.Line(),      \
+                       reader.LineNumber(), pos - reader.Line() )
+
+
+/**
+ * Function strCompare
+ *
+ * compares \a aString to the string starting at \a aLine and advances the character point to
+ * the end of \a String and returns the new pointer position in \a aOutput if it is not NULL.
+ *
+ * @param aString - A pointer to the string to compare.
+ * @param aLine - A pointer to string to begin the comparison.
+ * @param aOutput - A pointer to a string pointer to the end of the comparison if not NULL.
+ * @return True if \a aString was found starting at \a aLine.  Otherwise false.
+ */
+bool strCompare( const char* aString, const char* aLine, const char** aOutput = NULL );
+
+/**
+ * Function parseInt
+ *
+ * parses an ASCII integer string with possible leading whitespace into
+ * an integer and updates the pointer at \a aOutput if it is not NULL, just
+ * like "man strtol()".
+ *
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aLine - A pointer the current position in a string.
+ * @param aOutput - The pointer to a string pointer to copy the string pointer position when
+ *                  the parsing is complete.
+ * @return A valid integer value.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ * @throws A #PARSE_ERROR if the parsed token is not a valid integer.
+ */
+int parseInt( FILE_LINE_READER& aReader, const char* aLine, const char** aOutput = NULL );
+
+/**
+ * Function parseHex
+ *
+ * parses an ASCII hex integer string with possible leading whitespace into
+ * a long integer and updates the pointer at \a aOutput if it is not NULL, just
+ * like "man strtol".
+ *
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aLine - A pointer the current position in a string.
+ * @param aOutput - The pointer to a string pointer to copy the string pointer position when
+ *                  the parsing is complete.
+ * @return A valid integer value.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ * @throws A #PARSE_ERROR if the parsed token is not a valid integer.
+ */
+unsigned long parseHex( FILE_LINE_READER& aReader, const char* aLine,
+                        const char** aOutput = NULL );
+
+/**
+ * Function parseDouble
+ *
+ * parses an ASCII point string with possible leading whitespace into a double precision
+ * floating point number and  updates the pointer at \a aOutput if it is not NULL, just
+ * like "man strtod".
+ *
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aLine - A pointer the current position in a string.
+ * @param aOutput - The pointer to a string pointer to copy the string pointer position when
+ *                  the parsing is complete.
+ * @return A valid double value.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ * @throws A #PARSE_ERROR if the parsed token is not a valid integer.
+ */
+double parseDouble( FILE_LINE_READER& aReader, const char* aLine,
+                    const char** aOutput = NULL );
+
+/**
+ * Function parseChar
+ *
+ * parses a single ASCII character and updates the pointer at \a aOutput if it is not NULL.
+ *
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aCurrentToken - A pointer the current position in a string.
+ * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
+ *                     the parsing is complete.
+ * @return A valid ASCII character.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ * @throws A #PARSE_ERROR if the parsed token is not a a single character token.
+ */
+char parseChar( FILE_LINE_READER& aReader, const char* aCurrentToken,
+                const char** aNextToken = NULL );
+
+/**
+ * Function parseToken
+ *
+ * finds an unquoted token in the line buffer without copying it and updates the pointer
+ * at \a aNextToken if it is not NULL.  Use it instead of parseUnquotedString() for the
+ * tokens which are not text (attributes, flags ...).
+ *
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aCurrentToken - A pointer the current position in a string.
+ * @param aToken - The pointer to a string pointer to copy the token start position.
+ * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
+ *                     the parsing is complete.
+ * @param aCanBeEmpty - True if the token is optional.  False if it is mandatory.
+ * @return The token length in bytes, 0 if the optional token is missing.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ */
+size_t parseToken( FILE_LINE_READER& aReader, const char* aCurrentToken, const char** aToken,
+                   const char** aNextToken = NULL, bool aCanBeEmpty = false );
+
+/**
+ * Function parseUnquotedString.
+ *
+ * parses an unquoted utf8 string and updates the pointer at \a aOutput if it is not NULL.
+ *
+ * The parsed string must be a continuous string with no white space.
+ *
+ * @param aString - A reference to the parsed string.
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aCurrentToken - A pointer the current position in a string.
+ * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
+ *                     the parsing is complete.
+ * @param aCanBeEmpty - True if the parsed string is optional.  False if it is mandatory.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ * @throws A #PARSE_ERROR if the \a aCanBeEmpty is false and no string was parsed.
+ */
+void parseUnquotedString( wxString& aString, FILE_LINE_READER& aReader,
+                          const char* aCurrentToken, const char** aNextToken = NULL,
+                          bool aCanBeEmpty = false );
+
+/**
+ * Function parseQuotedString.
+ *
+ * parses an quoted ASCII utf8 and updates the pointer at \a aOutput if it is not NULL.
+ *
+ * The parsed string must be contained within a single line.  There are no multi-line
+ * quoted strings in the legacy schematic file format.
+ *
+ * @param aString - A reference to the parsed string.
+ * @param aReader - The line reader used to generate exception throw information.
+ * @param aCurrentToken - A pointer the current position in a string.
+ * @param aNextToken - The pointer to a string pointer to copy the string pointer position when
+ *                     the parsing is complete.
+ * @param aCanBeEmpty - True if the parsed string is optional.  False if it is mandatory.
+ * @throws An #IO_ERROR on an unexpected end of line.
+ * @throws A #PARSE_ERROR if the \a aCanBeEmpty is false and no string was parsed.
+ */
+void parseQuotedString( wxString& aString, FILE_LINE_READER& aReader,
+                        const char* aCurrentToken, const char** aNextToken = NULL,
+                        bool aCanBeEmpty = false );
+
+#endif    // _SCH_LEGACY_TOKENIZER_H_
@@ -505,9 +505,8 @@ void SCH_LINE::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
     if( (GetLayer() != LAYER_BUS) && (GetLayer() != LAYER_WIRE) )
         return;
 
-    NETLIST_OBJECT* item = new NETLIST_OBJECT();
+    NETLIST_OBJECT* item = aNetListItems.NewItem();
     item->m_SheetPath = *aSheetPath;
-    item->m_SheetPathInclude = *aSheetPath;
     item->m_Comp = (SCH_ITEM*) this;
     item->m_Start = m_start;
     item->m_End = m_end;
@@ -191,10 +191,9 @@ void SCH_NO_CONNECT::GetConnectionPoints( std::vector< wxPoint >& aPoints ) cons
 void SCH_NO_CONNECT::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
                                      SCH_SHEET_PATH*      aSheetPath )
 {
-    NETLIST_OBJECT* item = new NETLIST_OBJECT();
+    NETLIST_OBJECT* item = aNetListItems.NewItem();
 
     item->m_SheetPath = *aSheetPath;
-    item->m_SheetPathInclude = *aSheetPath;
     item->m_Comp = this;
     item->m_Type = NET_NOCONNECT;
     item->m_Start = item->m_End = m_pos;
@@ -54,6 +54,9 @@
 #include <sch_text.h>
 #include <lib_pin.h>
 
+#include <algorithm>
+#include <unordered_map>
+
 
 #define EESCHEMA_FILE_STAMP   "EESchema"
 
@@ -92,6 +95,121 @@ static GRID_TYPE SchematicGridList[] = {
 };
 
 
+/* Cell size (in mils) of the spatial hash used by the connection algorithms below.  Wires
+ * and pins sit on a 50 or 100 mil grid, so a cell holds a handful of connection points.
+ */
+#define CONNECTION_HASH_CELL    500
+
+/* Items spanning more cells than this are not spread over the hash but kept in a list
+ * returned by every query, so a stray huge item cannot blow up the table.
+ */
+#define CONNECTION_HASH_MAX_CELLS   1024
+
+
+static unsigned long long pointKey( int aX, int aY )
+{
+    return ( (unsigned long long) (unsigned) aX << 32 ) | (unsigned) aY;
+}
+
+
+/**
+ * Class CONNECTION_HASH
+ * is a uniform grid of buckets used to find the items near a point without walking the
+ * whole draw list.  It is only built for the duration of one batch algorithm: items are
+ * moved and edited in place all over eeschema without telling the screen, so an index
+ * kept alive between calls could not be trusted.
+ */
+template< typename T >
+class CONNECTION_HASH
+{
+public:
+    /**
+     * Function Add
+     * stores \a aValue in every cell touched by the box \a aMin, \a aMax (inclusive).
+     */
+    void Add( const wxPoint& aMin, const wxPoint& aMax, const T& aValue )
+    {
+        int x0 = cell( aMin.x ), x1 = cell( aMax.x );
+        int y0 = cell( aMin.y ), y1 = cell( aMax.y );
+
+        if( (long long) ( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) > CONNECTION_HASH_MAX_CELLS )
+        {
+            m_large.push_back( aValue );
+            return;
+        }
+
+        for( int x = x0; x <= x1; x++ )
+        {
+            for( int y = y0; y <= y1; y++ )
+                m_cells[ pointKey( x, y ) ].push_back( aValue );
+        }
+    }
+
+    /**
+     * Function Query
+     * appends to \a aList the values stored in the cells touched by the box \a aMin,
+     * \a aMax.  A value spanning several cells may be appended more than once.
+     */
+    void Query( const wxPoint& aMin, const wxPoint& aMax, std::vector< T >& aList ) const
+    {
+        int x0 = cell( aMin.x ), x1 = cell( aMax.x );
+        int y0 = cell( aMin.y ), y1 = cell( aMax.y );
+
+        for( int x = x0; x <= x1; x++ )
+        {
+            for( int y = y0; y <= y1; y++ )
+            {
+                auto it = m_cells.find( pointKey( x, y ) );
+
+                if( it != m_cells.end() )
+                    aList.insert( aList.end(), it->second.begin(), it->second.end() );
+            }
+        }
+
+        aList.insert( aList.end(), m_large.begin(), m_large.end() );
+    }
+
+    /**
+     * Function Query
+     * appends to \a aList the values stored in the cell holding \a aPoint.  Each value
+     * is appended once.
+     */
+    void Query( const wxPoint& aPoint, std::vector< T >& aList ) const
+    {
+        Query( aPoint, aPoint, aList );
+    }
+
+private:
+    static int cell( int aCoord )
+    {
+        // Round toward minus infinity so negative coordinates get their own cells.
+        return aCoord >= 0 ? aCoord / CONNECTION_HASH_CELL
+                           : -( ( -(long long) aCoord - 1 ) / CONNECTION_HASH_CELL ) - 1;
+    }
+
+    std::unordered_map< unsigned long long, std::vector< T > > m_cells;
+    std::vector< T >                                            m_large;
+};
+
+
+/**
+ * Function splitSegment
+ * breaks \a aSegment at \a aPoint and inserts the second half after it in \a aList.
+ * @return The new segment, which starts at \a aPoint.
+ */
+static SCH_LINE* splitSegment( DLIST< SCH_ITEM >& aList, SCH_LINE* aSegment,
+                               const wxPoint& aPoint )
+{
+    SCH_LINE* newSegment = new SCH_LINE( *aSegment );
+
+    newSegment->SetStartPoint( aPoint );
+    aSegment->SetEndPoint( aPoint );
+    aList.Insert( newSegment, aSegment->Next() );
+
+    return newSegment;
+}
+
+
 SCH_SCREEN::SCH_SCREEN( KIWAY* aKiway ) :
     BASE_SCREEN( SCH_SCREEN_T ),
     KIWAY_HOLDER( aKiway ),
@@ -297,38 +415,75 @@ void SCH_SCREEN::MarkConnections( SCH_LINE* aSegment )
     wxCHECK_RET( (aSegment) && (aSegment->Type() == SCH_LINE_T),
                  wxT( "Invalid object pointer." ) );
 
+    // Junctions by position and segments by end point, so following a wire only looks at
+    // the items actually touching it.
+    std::unordered_map< unsigned long long, std::vector< SCH_ITEM* > > ends;
+    std::unordered_map< unsigned long long, bool > hasPin;
+
     for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
     {
-        if( item->GetFlags() & CANDIDATE )
-            continue;
-
         if( item->Type() == SCH_JUNCTION_T )
         {
-            SCH_JUNCTION* junction = (SCH_JUNCTION*) item;
+            wxPoint pos = item->GetPosition();
+            ends[ pointKey( pos.x, pos.y ) ].push_back( item );
+        }
+        else if( item->Type() == SCH_LINE_T )
+        {
+            SCH_LINE* segment = (SCH_LINE*) item;
+            wxPoint   start = segment->GetStartPoint();
+            wxPoint   end = segment->GetEndPoint();
 
-            if( aSegment->IsEndPoint( junction->GetPosition() ) )
-                item->SetFlags( CANDIDATE );
+            ends[ pointKey( start.x, start.y ) ].push_back( item );
 
-            continue;
+            if( end != start )
+                ends[ pointKey( end.x, end.y ) ].push_back( item );
         }
+    }
 
-        if( item->Type() != SCH_LINE_T )
-            continue;
+    std::vector< SCH_LINE* > pending( 1, aSegment );
 
-        SCH_LINE* segment = (SCH_LINE*) item;
+    while( !pending.empty() )
+    {
+        SCH_LINE* segment = pending.back();
+        pending.pop_back();
 
-        if( aSegment->IsEndPoint( segment->GetStartPoint() )
-            && !GetPin( segment->GetStartPoint(), NULL, true ) )
-        {
-            item->SetFlags( CANDIDATE );
-            MarkConnections( segment );
-        }
+        wxPoint points[2] = { segment->GetStartPoint(), segment->GetEndPoint() };
 
-        if( aSegment->IsEndPoint( segment->GetEndPoint() )
-            && !GetPin( segment->GetEndPoint(), NULL, true ) )
+        for( int i = 0; i < 2; i++ )
         {
-            item->SetFlags( CANDIDATE );
-            MarkConnections( segment );
+            if( i == 1 && points[1] == points[0] )
+                break;
+
+            unsigned long long key = pointKey( points[i].x, points[i].y );
+            auto it = ends.find( key );
+
+            if( it == ends.end() )
+                continue;
+
+            auto pin = hasPin.find( key );
+
+            if( pin == hasPin.end() )
+            {
+                bool found = GetPin( points[i], NULL, true ) != NULL;
+                pin = hasPin.insert( std::make_pair( key, found ) ).first;
+            }
+
+            for( SCH_ITEM* item : it->second )
+            {
+                if( item->GetFlags() & CANDIDATE )
+                    continue;
+
+                // Wires stop at pins, junctions are always part of the connection.
+                if( item->Type() == SCH_JUNCTION_T )
+                {
+                    item->SetFlags( CANDIDATE );
+                }
+                else if( !pin->second )
+                {
+                    item->SetFlags( CANDIDATE );
+                    pending.push_back( (SCH_LINE*) item );
+                }
+            }
         }
     }
 }
@@ -425,47 +580,140 @@ bool SCH_SCREEN::IsTerminalPoint( const wxPoint& aPosition, int aLayer )
 
 bool SCH_SCREEN::SchematicCleanUp()
 {
-    bool      modified = false;
+    bool                         modified = false;
+    std::vector< SCH_LINE* >     lines;
+    std::vector< SCH_JUNCTION* > junctions;
+
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    {
+        if( item->Type() == SCH_LINE_T )
+            lines.push_back( (SCH_LINE*) item );
+        else if( item->Type() == SCH_JUNCTION_T )
+            junctions.push_back( (SCH_JUNCTION*) item );
+    }
+
+    // Two segments can only be merged when they share an end point, so the segments to try
+    // are the ones listed under the end points of the current segment.  Entries left behind
+    // by a merge are filtered out when the candidates are gathered.  The indices follow the
+    // draw list order, which decides the segment kept by a merge.
+    std::unordered_map< unsigned long long, std::vector< unsigned > > lineEnds;
+    std::vector< unsigned > candidates;
 
-    for( SCH_ITEM* item = m_drawList.begin() ; item; item = item->Next() )
+    auto addLineEnds = [&]( unsigned aIndex )
     {
-        if( ( item->Type() != SCH_LINE_T ) && ( item->Type() != SCH_JUNCTION_T ) )
+        wxPoint start = lines[aIndex]->GetStartPoint();
+        wxPoint end = lines[aIndex]->GetEndPoint();
+
+        lineEnds[ pointKey( start.x, start.y ) ].push_back( aIndex );
+
+        if( end != start )
+            lineEnds[ pointKey( end.x, end.y ) ].push_back( aIndex );
+    };
+
+    for( unsigned i = 0; i < lines.size(); i++ )
+        addLineEnds( i );
+
+    for( unsigned i = 0; i < lines.size(); i++ )
+    {
+        SCH_LINE* line = lines[i];
+
+        if( !line )
             continue;
 
-        bool restart;
+        // Only the following segments are tried until a first merge, then all of them.
+        unsigned first = i + 1;
+        bool     merged = true;
 
-        for( SCH_ITEM* testItem = item->Next(); testItem; testItem = restart ? m_drawList.begin() : testItem->Next() )
+        while( merged )
         {
-            restart = false;
+            merged = false;
+            candidates.clear();
 
-            if( ( item->Type() == SCH_LINE_T ) && ( testItem->Type() == SCH_LINE_T ) )
+            wxPoint points[2] = { line->GetStartPoint(), line->GetEndPoint() };
+
+            for( const wxPoint& pt : points )
             {
-                SCH_LINE* line = (SCH_LINE*) item;
+                auto it = lineEnds.find( pointKey( pt.x, pt.y ) );
+
+                if( it == lineEnds.end() )
+                    continue;
 
-                if( line->MergeOverlap( (SCH_LINE*) testItem ) )
+                for( unsigned j : it->second )
                 {
-                    // Keep the current flags, because the deleted segment can be flagged.
-                    item->SetFlags( testItem->GetFlags() );
-                    DeleteItem( testItem );
-                    restart = true;
-                    modified = true;
+                    if( j >= first && j != i && lines[j]
+                      && ( line->IsEndPoint( lines[j]->GetStartPoint() )
+                        || line->IsEndPoint( lines[j]->GetEndPoint() ) ) )
+                        candidates.push_back( j );
                 }
             }
-            else if ( ( ( item->Type() == SCH_JUNCTION_T )
-                      && ( testItem->Type() == SCH_JUNCTION_T ) ) && ( testItem != item ) )
+
+            std::sort( candidates.begin(), candidates.end() );
+            candidates.erase( std::unique( candidates.begin(), candidates.end() ),
+                              candidates.end() );
+
+            for( unsigned j : candidates )
             {
-                if ( testItem->HitTest( item->GetPosition() ) )
+                if( line->MergeOverlap( lines[j] ) )
                 {
                     // Keep the current flags, because the deleted segment can be flagged.
-                    item->SetFlags( testItem->GetFlags() );
-                    DeleteItem( testItem );
-                    restart = true;
+                    line->SetFlags( lines[j]->GetFlags() );
+                    DeleteItem( lines[j] );
+                    lines[j] = NULL;
+                    addLineEnds( i );
+                    first = 0;
+                    merged = true;
                     modified = true;
+                    break;
                 }
             }
         }
     }
 
+    // A junction swallows every other junction whose symbol covers its position, provided
+    // one of the junctions following it does.
+    CONNECTION_HASH< unsigned > junctionHash;
+
+    for( unsigned i = 0; i < junctions.size(); i++ )
+    {
+        EDA_RECT box = junctions[i]->GetBoundingBox();
+
+        box.Normalize();
+        junctionHash.Add( box.GetOrigin(), box.GetEnd(), i );
+    }
+
+    for( unsigned i = 0; i < junctions.size(); i++ )
+    {
+        if( !junctions[i] )
+            continue;
+
+        wxPoint pos = junctions[i]->GetPosition();
+
+        candidates.clear();
+        junctionHash.Query( pos, candidates );
+        std::sort( candidates.begin(), candidates.end() );
+
+        auto hit = [&]( unsigned j ) -> bool
+        {
+            return j != i && junctions[j] && junctions[j]->HitTest( pos );
+        };
+
+        if( std::find_if( std::upper_bound( candidates.begin(), candidates.end(), i ),
+                          candidates.end(), hit ) == candidates.end() )
+            continue;
+
+        for( unsigned j : candidates )
+        {
+            if( !hit( j ) )
+                continue;
+
+            // Keep the current flags, because the deleted segment can be flagged.
+            junctions[i]->SetFlags( junctions[j]->GetFlags() );
+            DeleteItem( junctions[j] );
+            junctions[j] = NULL;
+            modified = true;
+        }
+    }
+
     TestDanglingEnds();
 
     return modified;
@@ -917,16 +1165,74 @@ int SCH_SCREEN::UpdatePickList()
 
 bool SCH_SCREEN::TestDanglingEnds()
 {
-    SCH_ITEM* item;
     std::vector< DANGLING_END_ITEM > endPoints;
+    std::vector< SCH_ITEM* >         items;
+    std::vector< size_t >            firstEnd;
     bool hasStateChanged = false;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    {
+        items.push_back( item );
+        firstEnd.push_back( endPoints.size() );
         item->GetEndPoints( endPoints );
+    }
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    firstEnd.push_back( endPoints.size() );
+
+    // An item can only be connected to the items whose end points come near its own ones,
+    // so each item is tested against the end points of the items whose end point boxes
+    // intersect its own box.  The end points of an item are kept together and in order
+    // because wires and buses are tested as start/end pairs.
+    std::vector< wxPoint >     boxMin( items.size() );
+    std::vector< wxPoint >     boxMax( items.size() );
+    CONNECTION_HASH< unsigned > hash;
+
+    for( unsigned i = 0; i < items.size(); i++ )
     {
-        if( item->IsDanglingStateChanged( endPoints ) )
+        if( firstEnd[i] == firstEnd[i + 1] )
+            continue;
+
+        boxMin[i] = boxMax[i] = endPoints[ firstEnd[i] ].GetPosition();
+
+        for( size_t ii = firstEnd[i] + 1; ii < firstEnd[i + 1]; ii++ )
+        {
+            wxPoint pos = endPoints[ii].GetPosition();
+
+            boxMin[i].x = std::min( boxMin[i].x, pos.x );
+            boxMin[i].y = std::min( boxMin[i].y, pos.y );
+            boxMax[i].x = std::max( boxMax[i].x, pos.x );
+            boxMax[i].y = std::max( boxMax[i].y, pos.y );
+        }
+
+        hash.Add( boxMin[i], boxMax[i], i );
+    }
+
+    std::vector< unsigned >          nearby;
+    std::vector< DANGLING_END_ITEM > nearEndPoints;
+
+    for( unsigned i = 0; i < items.size(); i++ )
+    {
+        nearby.clear();
+        nearEndPoints.clear();
+
+        if( firstEnd[i] != firstEnd[i + 1] )
+        {
+            hash.Query( boxMin[i], boxMax[i], nearby );
+            std::sort( nearby.begin(), nearby.end() );
+            nearby.erase( std::unique( nearby.begin(), nearby.end() ), nearby.end() );
+        }
+
+        for( unsigned j : nearby )
+        {
+            if( boxMax[j].x < boxMin[i].x || boxMin[j].x > boxMax[i].x
+              || boxMax[j].y < boxMin[i].y || boxMin[j].y > boxMax[i].y )
+                continue;
+
+            nearEndPoints.insert( nearEndPoints.end(), endPoints.begin() + firstEnd[j],
+                                  endPoints.begin() + firstEnd[j + 1] );
+        }
+
+        if( items[i]->IsDanglingStateChanged( nearEndPoints ) )
             hasStateChanged = true;
     }
 
@@ -937,7 +1243,6 @@ bool SCH_SCREEN::TestDanglingEnds()
 bool SCH_SCREEN::BreakSegment( const wxPoint& aPoint )
 {
     SCH_LINE* segment;
-    SCH_LINE* newSegment;
     bool brokenSegments = false;
 
     for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
@@ -951,11 +1256,7 @@ bool SCH_SCREEN::BreakSegment( const wxPoint& aPoint )
             continue;
 
         // Break the segment at aPoint and create a new segment.
-        newSegment = new SCH_LINE( *segment );
-        newSegment->SetStartPoint( aPoint );
-        segment->SetEndPoint( aPoint );
-        m_drawList.Insert( newSegment, segment->Next() );
-        item = newSegment;
+        item = splitSegment( m_drawList, segment, aPoint );
         brokenSegments = true;
     }
 
@@ -967,13 +1268,51 @@ bool SCH_SCREEN::BreakSegmentsOnJunctions()
 {
     bool brokenSegments = false;
 
+    // Wires and buses by bounding box, so each break point only tests the segments under it.
+    CONNECTION_HASH< SCH_LINE* > hash;
+    std::vector< SCH_LINE* >     nearby;
+
+    auto addSegment = [&]( SCH_LINE* aSegment )
+    {
+        wxPoint start = aSegment->GetStartPoint();
+        wxPoint end = aSegment->GetEndPoint();
+
+        hash.Add( wxPoint( std::min( start.x, end.x ), std::min( start.y, end.y ) ),
+                  wxPoint( std::max( start.x, end.x ), std::max( start.y, end.y ) ), aSegment );
+    };
+
+    auto breakSegments = [&]( const wxPoint& aPoint ) -> bool
+    {
+        bool broken = false;
+
+        nearby.clear();
+        hash.Query( aPoint, nearby );
+
+        for( SCH_LINE* segment : nearby )
+        {
+            if( !segment->HitTest( aPoint, 0 ) || segment->IsEndPoint( aPoint ) )
+                continue;
+
+            addSegment( splitSegment( m_drawList, segment, aPoint ) );
+            broken = true;
+        }
+
+        return broken;
+    };
+
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    {
+        if( item->Type() == SCH_LINE_T && item->GetLayer() != LAYER_NOTES )
+            addSegment( (SCH_LINE*) item );
+    }
+
     for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
     {
         if( item->Type() == SCH_JUNCTION_T )
         {
             SCH_JUNCTION* junction = ( SCH_JUNCTION* ) item;
 
-            if( BreakSegment( junction->GetPosition() ) )
+            if( breakSegments( junction->GetPosition() ) )
                 brokenSegments = true;
         }
         else
@@ -981,8 +1320,8 @@ bool SCH_SCREEN::BreakSegmentsOnJunctions()
             SCH_BUS_ENTRY_BASE* busEntry = dynamic_cast<SCH_BUS_ENTRY_BASE*>( item );
             if( busEntry )
             {
-                if( BreakSegment( busEntry->GetPosition() )
-                 || BreakSegment( busEntry->m_End() ) )
+                if( breakSegments( busEntry->GetPosition() )
+                 || breakSegments( busEntry->m_End() ) )
                     brokenSegments = true;
             }
         }
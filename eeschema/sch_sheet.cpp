@@ -1109,13 +1109,10 @@ wxPoint SCH_SHEET::GetResizePosition() const
 void SCH_SHEET::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
                                 SCH_SHEET_PATH*      aSheetPath )
 {
-    SCH_SHEET_PATH sheetPath = *aSheetPath;
-    sheetPath.push_back( this );
-
     for( size_t i = 0;  i < m_pins.size();  i++ )
     {
-        NETLIST_OBJECT* item = new NETLIST_OBJECT();
-        item->m_SheetPathInclude = sheetPath;
+        NETLIST_OBJECT* item = aNetListItems.NewItem();
+        item->m_IncludedSheet = this;
         item->m_SheetPath = *aSheetPath;
         item->m_Comp = &m_pins[i];
         item->m_Link = this;
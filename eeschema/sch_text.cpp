@@ -617,9 +617,8 @@ void SCH_TEXT::GetNetListItem( NETLIST_OBJECT_LIST& aNetListItems,
     if( GetLayer() == LAYER_NOTES || GetLayer() == LAYER_SHEETLABEL )
         return;
 
-    NETLIST_OBJECT* item = new NETLIST_OBJECT();
+    NETLIST_OBJECT* item = aNetListItems.NewItem();
     item->m_SheetPath = *aSheetPath;
-    item->m_SheetPathInclude = *aSheetPath;
     item->m_Comp = (SCH_ITEM*) this;
     item->m_Type = NET_LABEL;
 
@@ -40,6 +40,7 @@
 #include <general.h>
 #include <eeschema_id.h>
 #include <netlist.h>
+#include <class_netlist_object.h>
 #include <lib_pin.h>
 #include <class_library.h>
 #include <schframe.h>
@@ -355,6 +356,7 @@ SCH_EDIT_FRAME::SCH_EDIT_FRAME( KIWAY* aKiway, wxWindow* aParent ):
     m_dlgFindReplace = NULL;
     m_findReplaceData = new wxFindReplaceData( wxFR_DOWN );
     m_undoItem = NULL;
+    m_connectivityCache = new SHEET_CONNECTIVITY_CACHE;
     m_hasAutoSave = true;
 
     SetForceHVLines( true );
@@ -444,11 +446,13 @@ SCH_EDIT_FRAME::~SCH_EDIT_FRAME()
     delete m_undoItem;
     delete g_RootSheet;
     delete m_findReplaceData;
+    delete m_connectivityCache;
 
     m_CurrentSheet = NULL;
     m_undoItem = NULL;
     g_RootSheet = NULL;
     m_findReplaceData = NULL;
+    m_connectivityCache = NULL;
 }
 
 
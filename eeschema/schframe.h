@@ -64,6 +64,7 @@ class DIALOG_SCH_FIND;
 class wxFindDialogEvent;
 class wxFindReplaceData;
 class SCHLIB_FILTER;
+class SHEET_CONNECTIVITY_CACHE;
 
 
 /// enum used in RotationMiroir()
@@ -141,6 +142,8 @@ private:
     SCH_COLLECTOR           m_collectedItems;     ///< List of collected items.
     SCH_FIND_COLLECTOR      m_foundItems;         ///< List of find/replace items.
     SCH_ITEM*               m_undoItem;           ///< Copy of the current item being edited.
+    SHEET_CONNECTIVITY_CACHE* m_connectivityCache;  ///< Connections inside the sheets,
+                                                    ///< kept between net list builds.
     wxString                m_simulatorCommand;   ///< Command line used to call the circuit
                                                   ///< simulator (gnucap, spice, ...)
     wxString                m_netListerCommand;   ///< Command line to call a custom net list
@@ -490,6 +493,7 @@ public:
      * netlist generation:
      * Creates a flat list which stores all connected objects, and mainly
      * pins and labels.
+     * The connections inside the sheets not changed since the previous call are reused.
      * @return NETLIST_OBJECT_LIST* - caller owns the object.
      */
     NETLIST_OBJECT_LIST* BuildNetListBase();
@@ -180,6 +180,7 @@ void GBR_LAYOUT::Draw( EDA_DRAW_PANEL* aPanel, wxDC* aDC, GR_DRAWMODE aDrawMode,
     bool doBlit = false; // this flag requests an image transfer to actual screen when true.
 
     bool end = false;
+    std::vector<GERBER_DRAW_ITEM*> drawItems;   // items of the current layer to draw
 
     // Draw graphic layers from bottom to top, and the active layer is on the top of others.
     // In non transparent modes, the last layer drawn masks others layers
@@ -285,10 +286,24 @@ void GBR_LAYOUT::Draw( EDA_DRAW_PANEL* aPanel, wxDC* aDC, GR_DRAWMODE aDrawMode,
         if( aDrawMode == GR_OR && !gerber->HasNegativeItems() )
             layerdrawMode = GR_OR;
 
+        // Collect items to draw: only items inside the visible area are drawn,
+        // in list order (the clip box is not relevant when printing)
+        if( aDisplayOptions->m_IsPrinting )
+        {
+            drawItems.clear();
+
+            for( GERBER_DRAW_ITEM* item = gerber->GetItemsList(); item; item = item->Next() )
+                drawItems.push_back( item );
+        }
+        else
+            gerber->GetItemIndex().Query( drawBox, drawItems );
+
         // Now we can draw the current layer to the bitmap buffer
         // When needed, the previous bitmap is already copied to the screen buffer.
-        for( GERBER_DRAW_ITEM* item = gerber->GetItemsList(); item; item = item->Next() )
+        for( unsigned ii = 0; ii < drawItems.size(); ii++ )
         {
+            GERBER_DRAW_ITEM* item = drawItems[ii];
+
             if( item->GetLayer() != layer )
                 continue;
 
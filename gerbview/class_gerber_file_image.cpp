@@ -163,6 +163,7 @@ APERTURE_MACRO* GERBER_FILE_IMAGE::FindApertureMacro( const APERTURE_MACRO& aLoo
 void GERBER_FILE_IMAGE::ResetDefaultValues()
 {
     m_InUse         = false;
+    InvalidateItemIndex();
     m_GBRLayerParams.ResetDefaultValues();
     m_FileName.Empty();
     m_ImageName     = wxT( "no name" );             // Image name from the IN command
@@ -31,6 +31,7 @@
 #include <dcode.h>
 #include <class_gerber_draw_item.h>
 #include <class_aperture_macro.h>
+#include <class_gerber_item_index.h>
 #include <gbr_netlist_metadata.h>
 
 // An useful macro used when reading gerber files;
@@ -178,6 +179,7 @@ private:
                                                                 // -1 = negative items are
                                                                 // 0 = no negative items found
                                                                 // 1 = have negative items found
+    GERBER_ITEM_INDEX  m_itemIndex;                             // spatial index of m_Drawings items
 
 public:
     GERBER_FILE_IMAGE( int layer );
@@ -211,6 +213,29 @@ public:
      */
     GERBER_DRAW_ITEM * GetItemsList();
 
+    /**
+     * Function GetItemIndex
+     * @return the spatial index of items, used to find items to draw in the visible area
+     * or items under the cursor. The index is built if it is not up to date.
+     */
+    GERBER_ITEM_INDEX& GetItemIndex()
+    {
+        if( !m_itemIndex.IsBuilt() )
+            m_itemIndex.Build( GetItemsList() );
+
+        return m_itemIndex;
+    }
+
+    /**
+     * Function InvalidateItemIndex
+     * must be called when items are added to, moved or deleted from the items list:
+     * the spatial index will be rebuilt on next use.
+     */
+    void InvalidateItemIndex()
+    {
+        m_itemIndex.Clear();
+    }
+
     /**
      * Function GetLayerParams
      * @return the current layers params
@@ -34,8 +34,17 @@
 #include <class_gerber_file_image.h>
 #include <class_gerber_file_image_list.h>
 #include <class_X2_gerber_attributes.h>
+#include <class_excellon.h>
 
 #include <map>
+#include <atomic>
+
+#include <wx/filename.h>
+#include <wx/progdlg.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
 
 
 // The global image list:
@@ -99,6 +108,66 @@ int GERBER_FILE_IMAGE_LIST::AddGbrImage( GERBER_FILE_IMAGE* aGbrImage, int aIdx
 }
 
 
+void GERBER_FILE_IMAGE_LIST::ReadImages( const wxArrayString& aFileSet,
+                                         const std::vector<bool>& aIsDrill,
+                                         std::vector<GERBER_FILE_IMAGE*>& aImages,
+                                         wxProgressDialog* aProgress )
+{
+    int count = aFileSet.GetCount();
+
+    if( count == 0 )
+        return;
+
+    // Images are created here, in the calling thread.
+    // The actual graphic layer is set by the caller, when storing the image
+    aImages.resize( count );
+
+    for( int ii = 0; ii < count; ++ii )
+    {
+        if( aIsDrill[ii] )
+            aImages[ii] = new EXCELLON_IMAGE( 0 );
+        else
+            aImages[ii] = new GERBER_FILE_IMAGE( 0 );
+    }
+
+    if( aProgress )
+        aProgress->Update( 0, wxFileName( aFileSet[0] ).GetFullName() );
+
+    // Switch to the C locale once for all the readers: LOCALE_IO is not thread safe
+    // when the first instance is created or deleted, but it is when nested.
+    LOCALE_IO toggleIo;
+
+    std::atomic<int> readCount( 0 );
+
+    #pragma omp parallel for schedule(dynamic)
+    for( int ii = 0; ii < count; ++ii )
+    {
+        if( aIsDrill[ii] )
+            static_cast<EXCELLON_IMAGE*>( aImages[ii] )->LoadFile( aFileSet[ii] );
+        else
+            aImages[ii]->LoadGerberFile( aFileSet[ii] );
+
+        // Build the spatial index of items here, while other files are read
+        aImages[ii]->GetItemIndex();
+
+        int done = ++readCount;
+
+        // The progress dialog can be updated only from the main thread
+#ifdef USE_OPENMP
+        if( aProgress && omp_get_thread_num() == 0 )
+#else
+        if( aProgress )
+#endif
+        {
+            aProgress->Update( done, wxFileName( aFileSet[ii] ).GetFullName() );
+        }
+    }
+
+    if( aProgress )
+        aProgress->Update( count );
+}
+
+
 void GERBER_FILE_IMAGE_LIST::DeleteAllImages()
 {
     for( unsigned idx = 0; idx < m_GERBER_List.size(); ++idx )
@@ -53,6 +53,7 @@
  */
 
 class GERBER_FILE_IMAGE;
+class wxProgressDialog;
 
 /**
  * @brief GERBER_FILE_IMAGE_LIST is a helper class to handle a list of GERBER_FILE_IMAGE files
@@ -84,6 +85,22 @@ public:
     int AddGbrImage( GERBER_FILE_IMAGE* aGbrImage, int aIdx );
 
 
+    /**
+     * Read a set of gerber and/or Excellon drill files, each file in a new image.
+     * Each image is independent from the others, so files are read concurrently
+     * (when OpenMP is available).
+     * The new images are not stored in the list: the caller must set their graphic layer
+     * and add them with AddGbrImage(), or delete them.
+     * A file was successfully read if the m_InUse member of its image is true.
+     * @param aFileSet = the full filenames of files to read
+     * @param aIsDrill = for each file, true for an Excellon drill file, false for a gerber file
+     * @param aImages = receives the new images, in aFileSet order
+     * @param aProgress = a progress dialog to update each time a file is read, or NULL
+     */
+    void ReadImages( const wxArrayString& aFileSet, const std::vector<bool>& aIsDrill,
+                     std::vector<GERBER_FILE_IMAGE*>& aImages,
+                     wxProgressDialog* aProgress = NULL );
+
     /**
      * remove all loaded data in list, and delete all images. Memory is freed
      */
@@ -0,0 +1,227 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 1992-2016 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file class_gerber_item_index.cpp
+ */
+
+#include <fctsys.h>
+#include <common.h>
+#include <trigo.h>
+
+#include <class_gerber_draw_item.h>
+#include <class_gerber_item_index.h>
+
+#include <algorithm>
+
+
+// Helper visitor for R-tree searches: collects ranks of items found
+struct ITEM_RANK_COLLECTOR
+{
+    std::vector<int>& m_ranks;
+
+    ITEM_RANK_COLLECTOR( std::vector<int>& aRanks ) :
+        m_ranks( aRanks )
+    {
+    }
+
+    bool operator()( int aRank )
+    {
+        m_ranks.push_back( aRank );
+        return true;    // continue search
+    }
+};
+
+
+GERBER_ITEM_INDEX::GERBER_ITEM_INDEX()
+{
+    m_built = false;
+}
+
+
+void GERBER_ITEM_INDEX::Clear()
+{
+    m_tree.RemoveAll();
+    m_items.clear();
+    m_unboundedItems.clear();
+    m_buffer.clear();
+    m_built = false;
+}
+
+
+void GERBER_ITEM_INDEX::Build( GERBER_DRAW_ITEM* aFirstItem )
+{
+    Clear();
+
+    for( GERBER_DRAW_ITEM* item = aFirstItem; item; item = item->Next() )
+    {
+        int rank = m_items.size();
+        EDA_RECT bbox;
+
+        m_items.push_back( item );
+
+        if( !itemBoundingBox( item, bbox ) )
+        {
+            m_unboundedItems.push_back( rank );
+            continue;
+        }
+
+        const int mmin[2] = { bbox.GetX(), bbox.GetY() };
+        const int mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+        m_tree.Insert( mmin, mmax, rank );
+    }
+
+    m_built = true;
+}
+
+
+bool GERBER_ITEM_INDEX::itemBoundingBox( GERBER_DRAW_ITEM* aItem, EDA_RECT& aBBox )
+{
+    // The actual size of a shape defined by an aperture macro is not known
+    // without building the shape
+    if( aItem->m_Flashed && aItem->m_Shape == GBR_SPOT_MACRO )
+        return false;
+
+    // Calculate the bounding box in X,Y (gerber file) coordinates.
+    // Lines and arcs are hit tested like segments from m_Start to m_End,
+    // so m_End is always in box.
+    wxPoint pmin = aItem->m_Start;
+    wxPoint pmax = aItem->m_Start;
+
+    if( !aItem->m_Flashed )
+    {
+        pmin.x = std::min( pmin.x, aItem->m_End.x );
+        pmin.y = std::min( pmin.y, aItem->m_End.y );
+        pmax.x = std::max( pmax.x, aItem->m_End.x );
+        pmax.y = std::max( pmax.y, aItem->m_End.y );
+    }
+
+    wxPoint center;
+    int     radius = 0;
+
+    if( aItem->m_Shape == GBR_ARC )
+    {
+        center = aItem->m_ArcCentre;
+        radius = KiROUND( GetLineLength( aItem->m_Start, center ) ) + 1;
+    }
+    else if( aItem->m_Shape == GBR_CIRCLE )
+    {
+        center = aItem->m_Start;
+        radius = KiROUND( GetLineLength( aItem->m_Start, aItem->m_End ) ) + 1;
+    }
+
+    if( radius )
+    {
+        pmin.x = std::min( pmin.x, center.x - radius );
+        pmin.y = std::min( pmin.y, center.y - radius );
+        pmax.x = std::max( pmax.x, center.x + radius );
+        pmax.y = std::max( pmax.y, center.y + radius );
+    }
+
+    for( unsigned ii = 0; ii < aItem->m_PolyCorners.size(); ii++ )
+    {
+        const wxPoint& corner = aItem->m_PolyCorners[ii];
+
+        pmin.x = std::min( pmin.x, corner.x );
+        pmin.y = std::min( pmin.y, corner.y );
+        pmax.x = std::max( pmax.x, corner.x );
+        pmax.y = std::max( pmax.y, corner.y );
+    }
+
+    // Add the pen width, or the flashed shape size.
+    // (x + y)/2 is never less than the half diagonal of a rectangular aperture.
+    int margin = ( std::abs( aItem->m_Size.x ) + std::abs( aItem->m_Size.y ) ) / 2 + 1;
+
+    pmin.x -= margin;
+    pmin.y -= margin;
+    pmax.x += margin;
+    pmax.y += margin;
+
+    // Now transform the 4 corners to A,B (draw) coordinates: the image can be rotated
+    // by any angle, so the A,B bounding box must contain all of them.
+    wxPoint corners[4] =
+    {
+        aItem->GetABPosition( pmin ),
+        aItem->GetABPosition( wxPoint( pmax.x, pmin.y ) ),
+        aItem->GetABPosition( pmax ),
+        aItem->GetABPosition( wxPoint( pmin.x, pmax.y ) )
+    };
+
+    aBBox = EDA_RECT( corners[0], wxSize( 0, 0 ) );
+
+    for( int ii = 1; ii < 4; ii++ )
+        aBBox.Merge( corners[ii] );
+
+    // Rounding in GetABPosition
+    aBBox.Inflate( 1 );
+
+    return true;
+}
+
+
+void GERBER_ITEM_INDEX::query( const EDA_RECT& aArea )
+{
+    EDA_RECT area = aArea;
+    area.Normalize();
+
+    const int mmin[2] = { area.GetX(), area.GetY() };
+    const int mmax[2] = { area.GetRight(), area.GetBottom() };
+
+    ITEM_RANK_COLLECTOR collector( m_buffer );
+
+    m_buffer.clear();
+    m_tree.Search( mmin, mmax, collector );
+    m_buffer.insert( m_buffer.end(), m_unboundedItems.begin(), m_unboundedItems.end() );
+
+    // Restore the list order
+    std::sort( m_buffer.begin(), m_buffer.end() );
+}
+
+
+void GERBER_ITEM_INDEX::Query( const EDA_RECT& aArea, std::vector<GERBER_DRAW_ITEM*>& aItems )
+{
+    query( aArea );
+
+    aItems.clear();
+    aItems.reserve( m_buffer.size() );
+
+    for( unsigned ii = 0; ii < m_buffer.size(); ii++ )
+        aItems.push_back( m_items[ m_buffer[ii] ] );
+}
+
+
+GERBER_DRAW_ITEM* GERBER_ITEM_INDEX::HitTest( const wxPoint& aRefPos )
+{
+    query( EDA_RECT( aRefPos, wxSize( 0, 0 ) ) );
+
+    for( unsigned ii = 0; ii < m_buffer.size(); ii++ )
+    {
+        GERBER_DRAW_ITEM* item = m_items[ m_buffer[ii] ];
+
+        if( item->HitTest( aRefPos ) )
+            return item;
+    }
+
+    return NULL;
+}
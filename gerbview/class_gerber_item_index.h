@@ -0,0 +1,115 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 1992-2016 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file class_gerber_item_index.h
+ */
+
+#ifndef CLASS_GERBER_ITEM_INDEX_H
+#define CLASS_GERBER_ITEM_INDEX_H
+
+#include <vector>
+
+#include <base_struct.h>
+#include <geometry/rtree.h>
+
+class GERBER_DRAW_ITEM;
+
+
+/**
+ * Class GERBER_ITEM_INDEX
+ * is a spatial index (a R-tree) of the items of a GERBER_FILE_IMAGE, used to
+ * find items inside the visible area when drawing, and items under the cursor.
+ *
+ * The index keeps an array of item pointers in list (i.e. draw) order, and the R-tree
+ * stores only the rank of each item in this array, with the bounding box of its shape
+ * in A,B (draw) coordinates.  The items themselves stay in the GERBER_FILE_IMAGE list:
+ * the index adds to their memory, it is not a compact storage of them.
+ * Queries always return items in list order, so drawing only the items found
+ * gives the same result as drawing the full list, negative items included.
+ *
+ * The index does not own items. It must be rebuilt when items are added, moved
+ * or deleted (see GERBER_FILE_IMAGE::InvalidateItemIndex()).
+ */
+class GERBER_ITEM_INDEX
+{
+public:
+    GERBER_ITEM_INDEX();
+
+    /**
+     * Function Build
+     * clears the index, and adds all items of the list starting at aFirstItem
+     */
+    void Build( GERBER_DRAW_ITEM* aFirstItem );
+
+    /**
+     * Function Clear
+     * removes all items from the index
+     */
+    void Clear();
+
+    bool IsBuilt() const { return m_built; }
+
+    /**
+     * Function Query
+     * finds items which can have a part of their shape inside aArea
+     * @param aArea = the area to search, in A,B (draw) coordinates
+     * @param aItems = a buffer which receives the items found, in list order
+     */
+    void Query( const EDA_RECT& aArea, std::vector<GERBER_DRAW_ITEM*>& aItems );
+
+    /**
+     * Function HitTest
+     * @return the first item (in list order) which is hit by aRefPos,
+     * or NULL if no item is found. This is the item found by testing each item
+     * of the list with GERBER_DRAW_ITEM::HitTest( aRefPos ).
+     * @param aRefPos = the reference position, in A,B (draw) coordinates
+     */
+    GERBER_DRAW_ITEM* HitTest( const wxPoint& aRefPos );
+
+private:
+    /**
+     * Function itemBoundingBox
+     * calculates a bounding box, in A,B coordinates, of all areas where an item
+     * can be drawn or hit.
+     * @return false if no bounding box can be calculated (shapes defined by an
+     * aperture macro): these items are always selected by queries
+     */
+    static bool itemBoundingBox( GERBER_DRAW_ITEM* aItem, EDA_RECT& aBBox );
+
+    /**
+     * Function query
+     * stores in m_buffer the ranks of items found in aArea, sorted in list order
+     */
+    void query( const EDA_RECT& aArea );
+
+    typedef RTree<int, int, 2, double> ITEM_RTREE;
+
+    ITEM_RTREE                      m_tree;             // ranks of items, by bounding box
+    std::vector<GERBER_DRAW_ITEM*>  m_items;            // all items, in list order
+    std::vector<int>                m_unboundedItems;   // ranks of items without bounding box
+    std::vector<int>                m_buffer;           // query results
+    bool                            m_built;
+};
+
+#endif  // CLASS_GERBER_ITEM_INDEX_H
@@ -76,7 +76,6 @@
 
 #include <cmath>
 
-#include <html_messagebox.h>
 
 // Default format for dimensions: they are the default values, not the actual values
 // number of digits in mantissa:
@@ -159,7 +158,6 @@ static EXCELLON_CMD excellon_G_CmdList[] =
 
 bool GERBVIEW_FRAME::Read_EXCELLON_File( const wxString& aFullFileName )
 {
-    wxString msg;
     int layerId = getActiveLayer();      // current layer used in GerbView
     GERBER_FILE_IMAGE_LIST* images = GetGerberLayout()->GetImagesList();
     EXCELLON_IMAGE* drill_Layer = (EXCELLON_IMAGE*) images->GetGbrImage( layerId );
@@ -177,23 +175,9 @@ bool GERBVIEW_FRAME::Read_EXCELLON_File( const wxString& aFullFileName )
     }
 
     // Read the Excellon drill file:
-    bool success = drill_Layer->LoadFile( aFullFileName );
+    drill_Layer->LoadFile( aFullFileName );
 
-    if( !success )
-    {
-        msg.Printf( _( "File %s not found" ), GetChars( aFullFileName ) );
-        DisplayError( this, msg );
-        return false;
-    }
-
-    // Display errors list
-    if( drill_Layer->GetMessages().size() > 0 )
-    {
-        HTML_MESSAGE_BOX dlg( this, _( "Error reading EXCELLON drill file" ) );
-        dlg.ListSet( drill_Layer->GetMessages() );
-        dlg.ShowModal();
-    }
-    return success;
+    return reportImageLoad( drill_Layer, aFullFileName, true );
 }
 
 /*
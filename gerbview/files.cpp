@@ -28,13 +28,19 @@
 
 #include <fctsys.h>
 #include <common.h>
+#include <confirm.h>
 #include <class_drawpanel.h>
+#include <html_messagebox.h>
 
 #include <gerbview_frame.h>
 #include <gerbview_id.h>
+#include <class_gerber_file_image.h>
+#include <class_gerber_file_image_list.h>
 #include <class_gerbview_layer_widget.h>
 #include <wildcards_and_files_ext.h>
 
+#include <wx/progdlg.h>
+
 
 void GERBVIEW_FRAME::OnGbrFileHistory( wxCommandEvent& event )
 {
@@ -175,8 +181,6 @@ bool GERBVIEW_FRAME::LoadGerberFiles( const wxString& aFullFileName )
     }
 
     // Read gerber files: each file is loaded on a new GerbView layer
-    int layer = getActiveLayer();
-
     for( unsigned ii = 0; ii < filenamesList.GetCount(); ii++ )
     {
         filename = filenamesList[ii];
@@ -184,28 +188,11 @@ bool GERBVIEW_FRAME::LoadGerberFiles( const wxString& aFullFileName )
         if( !filename.IsAbsolute() )
             filename.SetPath( currentPath );
 
-        m_lastFileName = filename.GetFullPath();
-
-        setActiveLayer( layer, false );
-
-        if( Read_GERBER_File( filename.GetFullPath() ) )
-        {
-            UpdateFileHistory( m_lastFileName );
-
-            layer = getNextAvailableLayer( layer );
-
-            if( layer == NO_AVAILABLE_LAYERS )
-            {
-                wxString msg = wxT( "No more empty available layers.\n"
-                                    "The remaining gerber files will not be loaded." );
-                wxMessageBox( msg );
-                break;
-            }
-
-            setActiveLayer( layer, false );
-        }
+        filenamesList[ii] = filename.GetFullPath();
     }
 
+    loadFileSet( filenamesList, std::vector<bool>( filenamesList.GetCount(), false ), false );
+
     Zoom_Automatique( false );
 
     // Synchronize layers tools with actual active layer:
@@ -258,9 +245,7 @@ bool GERBVIEW_FRAME::LoadExcellonFiles( const wxString& aFullFileName )
         m_mruPath = currentPath;
     }
 
-    // Read gerber files: each file is loaded on a new GerbView layer
-    int layer = getActiveLayer();
-
+    // Read drill files: each file is loaded on a new GerbView layer
     for( unsigned ii = 0; ii < filenamesList.GetCount(); ii++ )
     {
         filename = filenamesList[ii];
@@ -268,36 +253,160 @@ bool GERBVIEW_FRAME::LoadExcellonFiles( const wxString& aFullFileName )
         if( !filename.IsAbsolute() )
             filename.SetPath( currentPath );
 
-        m_lastFileName = filename.GetFullPath();
+        filenamesList[ii] = filename.GetFullPath();
+    }
+
+    loadFileSet( filenamesList, std::vector<bool>( filenamesList.GetCount(), true ), false );
+
+    Zoom_Automatique( false );
+
+    // Synchronize layers tools with actual active layer:
+    ReFillLayerWidget();
+    setActiveLayer( getActiveLayer() );
+    m_LayersManager->UpdateLayerIcons();
+    syncLayerBox();
+
+    return true;
+}
+
+
+bool GERBVIEW_FRAME::loadFileSet( const wxArrayString& aFileSet,
+                                  const std::vector<bool>& aIsDrill,
+                                  bool aOneLayerPerFile )
+{
+    GERBER_FILE_IMAGE_LIST* images = GetImagesList();
+    std::vector<GERBER_FILE_IMAGE*> newImages;
+    wxProgressDialog* progressDialog = NULL;
+    bool loaded = false;
+
+    if( aFileSet.GetCount() > 1 )
+        progressDialog = new wxProgressDialog( _( "Loading Files" ), wxEmptyString,
+                                               aFileSet.GetCount(), this,
+                                               wxPD_AUTO_HIDE | wxPD_APP_MODAL |
+                                               wxPD_ELAPSED_TIME );
+
+    // Files are independent: read all of them (concurrently) before storing
+    // the images in graphic layers.
+    images->ReadImages( aFileSet, aIsDrill, newImages, progressDialog );
+
+    delete progressDialog;
+
+    // Now store images in file order, exactly like Read_GERBER_File() or
+    // Read_EXCELLON_File() do when files are read one at a time.
+    // When a file cannot be read, its (empty) image is stored, and replaced by
+    // the image of the next file.
+    GERBER_FILE_IMAGE* notLoadedImage = NULL;
+    int layer = getActiveLayer();
+
+    for( unsigned ii = 0; ii < aFileSet.GetCount(); ii++ )
+    {
+        if( aOneLayerPerFile )
+            layer = ii;
+
+        m_lastFileName = aFileSet[ii];
 
         setActiveLayer( layer, false );
 
-        if( Read_EXCELLON_File( filename.GetFullPath() ) )
+        GERBER_FILE_IMAGE* current = GetGbrImage( layer );
+        bool success;
+
+        if( current && current != notLoadedImage )
+        {
+            // This layer already contains an image: reread the file in this image,
+            // as usual
+            delete newImages[ii];
+
+            if( aIsDrill[ii] )
+                success = Read_EXCELLON_File( aFileSet[ii] );
+            else
+                success = Read_GERBER_File( aFileSet[ii] );
+        }
+        else
+        {
+            images->DeleteImage( layer );
+            newImages[ii]->m_GraphicLayer = layer;
+            images->AddGbrImage( newImages[ii], layer );
+            success = reportImageLoad( newImages[ii], aFileSet[ii], aIsDrill[ii] );
+            notLoadedImage = success ? NULL : newImages[ii];
+        }
+
+        newImages[ii] = NULL;
+
+        if( !success )
+            continue;
+
+        loaded = true;
+
+        if( aIsDrill[ii] )
+            UpdateFileHistory( aFileSet[ii], &m_drillFileHistory );
+        else
+            UpdateFileHistory( aFileSet[ii] );
+
+        layer = getNextAvailableLayer( layer );
+
+        if( layer == NO_AVAILABLE_LAYERS )
         {
-            // Update the list of recent drill files.
-            UpdateFileHistory( filename.GetFullPath(),  &m_drillFileHistory );
+            wxString msg = wxT( "No more empty available layers.\n"
+                                "The remaining gerber files will not be loaded." );
+            wxMessageBox( msg );
+
+            if( aOneLayerPerFile )
+                continue;
 
-            layer = getNextAvailableLayer( layer );
+            break;
+        }
+
+        setActiveLayer( layer, false );
+    }
+
+    // Delete images of files which were not stored (no more room)
+    for( unsigned ii = 0; ii < newImages.size(); ii++ )
+        delete newImages[ii];
+
+    return loaded;
+}
 
-            if( layer == NO_AVAILABLE_LAYERS )
-            {
-                wxString msg = wxT( "No more empty available layers.\n"
-                                    "The remaining gerber files will not be loaded." );
-                wxMessageBox( msg );
-                break;
-            }
 
-            setActiveLayer( layer, false );
+bool GERBVIEW_FRAME::reportImageLoad( GERBER_FILE_IMAGE* aImage, const wxString& aFullFileName,
+                                      bool aIsDrill )
+{
+    wxString msg;
+
+    if( !aImage->m_InUse )
+    {
+        if( aIsDrill )
+        {
+            msg.Printf( _( "File %s not found" ), GetChars( aFullFileName ) );
+            DisplayError( this, msg );
         }
+        else
+        {
+            msg.Printf( _( "File <%s> not found" ), GetChars( aFullFileName ) );
+            DisplayError( this, msg, 10 );
+        }
+
+        return false;
     }
 
-    Zoom_Automatique( false );
+    // Display errors list
+    if( aImage->GetMessages().size() > 0 )
+    {
+        HTML_MESSAGE_BOX dlg( this, aIsDrill ? _( "Error reading EXCELLON drill file" )
+                                             : _( "Errors" ) );
+        dlg.ListSet( aImage->GetMessages() );
+        dlg.ShowModal();
+    }
 
-    // Synchronize layers tools with actual active layer:
-    ReFillLayerWidget();
-    setActiveLayer( getActiveLayer() );
-    m_LayersManager->UpdateLayerIcons();
-    syncLayerBox();
+    /* if the gerber file is only a RS274D file
+     * (i.e. without any aperture information), wran the user:
+     */
+    if( !aIsDrill && !aImage->m_Has_DCode )
+    {
+        msg = _("Warning: this file has no D-Code definition\n"
+                "It is perhaps an old RS274D file\n"
+                "Therefore the size of items is undefined");
+        wxMessageBox( msg );
+    }
 
     return true;
 }
@@ -218,22 +218,29 @@ bool GERBVIEW_FRAME::OpenProjectFiles( const std::vector<wxString>& aFileSet, in
         const unsigned limit = std::min( unsigned( aFileSet.size() ),
                                          unsigned( GERBER_DRAWLAYERS_COUNT ) );
 
-        int layer = 0;
+        wxArrayString filenamesList;
+        std::vector<bool> isDrill;
 
-        for( unsigned i=0;  i<limit;  ++i, ++layer )
+        for( unsigned i=0;  i<limit;  ++i )
         {
-            setActiveLayer( layer );
-
             // Try to guess the type of file by its ext
             // if it is .drl (Kicad files), it is a drill file
             wxFileName fn( aFileSet[i] );
             wxString ext = fn.GetExt();
 
-            if( ext == "drl" )
-                LoadExcellonFiles( aFileSet[i] );
-            else
-                LoadGerberFiles( aFileSet[i] );
+            filenamesList.Add( fn.GetFullPath() );
+            isDrill.push_back( ext == "drl" );
+            m_mruPath = fn.GetPath();
         }
+
+        // Files of the set are loaded on layers 0 ... limit-1
+        loadFileSet( filenamesList, isDrill, true );
+
+        // Synchronize layers tools with actual active layer:
+        ReFillLayerWidget();
+        setActiveLayer( getActiveLayer() );
+        m_LayersManager->UpdateLayerIcons();
+        syncLayerBox();
     }
 
     Zoom_Automatique( true );        // Zoom fit in frame
@@ -612,6 +612,36 @@ public:
     bool                LoadExcellonFiles( const wxString& aFileName );
     bool                Read_EXCELLON_File( const wxString& aFullFileName );
 
+private:
+    /**
+     * Function loadFileSet
+     * loads a list of gerber and/or drill files, each file on a new graphic layer.
+     * Files are read concurrently, then images are stored in list order, using the
+     * same graphic layers, and displaying the same messages, as when files are loaded
+     * one at a time by Read_GERBER_File() or Read_EXCELLON_File()
+     * @param aFileSet = the full filenames of files to load
+     * @param aIsDrill = for each file, true for an Excellon drill file, false for a gerber file
+     * @param aOneLayerPerFile = true to load the file n on graphic layer n,
+     *                           false to load files from the active layer
+     * @return true if at least one file was loaded
+     */
+    bool                loadFileSet( const wxArrayString& aFileSet,
+                                     const std::vector<bool>& aIsDrill,
+                                     bool aOneLayerPerFile );
+
+    /**
+     * Function reportImageLoad
+     * displays the errors and warnings found when reading a file in an image
+     * @param aImage = the image in which the file was read
+     * @param aFullFileName = the full filename of the file
+     * @param aIsDrill = true for an Excellon drill file, false for a gerber file
+     * @return true if the file was successfully read
+     */
+    bool                reportImageLoad( GERBER_FILE_IMAGE* aImage,
+                                         const wxString& aFullFileName, bool aIsDrill );
+
+public:
+
     bool                GeneralControl( wxDC* aDC, const wxPoint& aPosition, EDA_KEY aHotKey = 0 );
 
     /**
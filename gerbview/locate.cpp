@@ -58,14 +58,8 @@ GERBER_DRAW_ITEM* GERBVIEW_FRAME::Locate( const wxPoint& aPosition, int aTypeloc
     // A not used graphic layer can be selected. So gerber can be NULL
     if( gerber && IsLayerVisible( layer ) )
     {
-        for( gerb_item = gerber->GetItemsList(); gerb_item; gerb_item = gerb_item->Next() )
-        {
-            if( gerb_item->HitTest( ref ) )
-            {
-                found = true;
-                break;
-            }
-        }
+        gerb_item = gerber->GetItemIndex().HitTest( ref );
+        found = gerb_item != NULL;
     }
 
     if( !found ) // Search on all layers
@@ -80,17 +74,13 @@ GERBER_DRAW_ITEM* GERBVIEW_FRAME::Locate( const wxPoint& aPosition, int aTypeloc
             if( !IsLayerVisible( layer ) )
                 continue;
 
-            for( gerb_item = gerber->GetItemsList(); gerb_item; gerb_item = gerb_item->Next() )
-            {
-                if( gerb_item->HitTest( ref ) )
-                {
-                    found = true;
-                    break;
-                }
-            }
+            gerb_item = gerber->GetItemIndex().HitTest( ref );
 
-            if( found )
+            if( gerb_item )
+            {
+                found = true;
                 break;
+            }
         }
     }
 
@@ -31,15 +31,12 @@
 #include <class_gerber_file_image.h>
 #include <class_gerber_file_image_list.h>
 
-#include <html_messagebox.h>
 #include <macros.h>
 
 /* Read a gerber file, RS274D, RS274X or RS274X2 format.
  */
 bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
 {
-    wxString msg;
-
     int layer = getActiveLayer();
     GERBER_FILE_IMAGE_LIST* images = GetImagesList();
     GERBER_FILE_IMAGE* gerber = GetGbrImage( layer );
@@ -51,35 +48,9 @@ bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
     }
 
     /* Read the gerber file */
-    bool success = gerber->LoadGerberFile( GERBER_FullFileName );
-
-    if( !success )
-    {
-        msg.Printf( _( "File <%s> not found" ), GetChars( GERBER_FullFileName ) );
-        DisplayError( this, msg, 10 );
-        return false;
-    }
+    gerber->LoadGerberFile( GERBER_FullFileName );
 
-    // Display errors list
-    if( gerber->GetMessages().size() > 0 )
-    {
-        HTML_MESSAGE_BOX dlg( this, _("Errors") );
-        dlg.ListSet(gerber->GetMessages());
-        dlg.ShowModal();
-    }
-
-    /* if the gerber file is only a RS274D file
-     * (i.e. without any aperture information), wran the user:
-     */
-    if( !gerber->m_Has_DCode )
-    {
-        msg = _("Warning: this file has no D-Code definition\n"
-                "It is perhaps an old RS274D file\n"
-                "Therefore the size of items is undefined");
-        wxMessageBox( msg );
-    }
-
-    return true;
+    return reportImageLoad( gerber, GERBER_FullFileName, false );
 }
 
 
@@ -101,12 +72,9 @@ bool GERBER_FILE_IMAGE::LoadGerberFile( const wxString& aFullFileName )
 
     m_FileName = aFullFileName;
 
-    wxString path = wxPathOnly( aFullFileName );
-
-    // This change is needed to load included files, if exists:
-    if( path != wxEmptyString )
-        wxSetWorkingDirectory( path );
-
+    // Note: the working directory is not changed to load included files, because
+    // files can be read concurrently. Included files are searched from the
+    // path of aFullFileName (see INCLUDE_FILE command).
     LOCALE_IO toggleIo;
 
     wxString msg;
@@ -35,6 +35,8 @@
 #include <class_gerber_file_image.h>
 #include <class_X2_gerber_attributes.h>
 
+#include <wx/filename.h>
+
 extern int ReadInt( char*& text, bool aSkipSeparator = true );
 extern double ReadDouble( char*& text, bool aSkipSeparator = true );
 extern bool GetEndOfBlock( char* buff, char*& text, FILE* gerber_file );
@@ -714,7 +716,16 @@ bool GERBER_FILE_IMAGE::ExecuteRS274XCommand( int command, char* buff, char*& te
         strtok( line, "*%%\n\r" );
         m_FilesList[m_FilesPtr] = m_Current_File;
 
-        m_Current_File = fopen( line, "rt" );
+        {
+            // A relative include file name is relative to the path of the main file
+            wxFileName includeFile( FROM_UTF8( line ) );
+
+            if( includeFile.IsRelative() )
+                includeFile.MakeAbsolute( wxPathOnly( m_FileName ) );
+
+            m_Current_File = wxFopen( includeFile.GetFullPath(), wxT( "rt" ) );
+        }
+
         if( m_Current_File == 0 )
         {
             msg.Printf( wxT( "include file <%s> not found." ), line );
@@ -26,6 +26,7 @@
 #define BASIC_GAL_H
 
 #include <plot_common.h>
+#include <ki_mutex.h>
 
 #include <gal/stroke_font.h>
 #include <gal/graphics_abstraction_layer.h>
@@ -70,6 +71,7 @@ public:
         m_Color = RED;
         m_plotter = NULL;
         m_callback = NULL;
+        m_strokes = NULL;
         m_isClipped = false;
     }
 
@@ -83,6 +85,13 @@ public:
         m_callback = aCallback;
     }
 
+    /// Set a list which receives the drawn polylines, when there is no wxDC, plotter
+    /// or callback.  If NULL, nothing is stored
+    void SetStrokeList( std::vector< std::vector<wxPoint> >* aStrokes )
+    {
+        m_strokes = aStrokes;
+    }
+
     /// Set a clip box for drawings
     /// If NULL, no clip will be made
     void SetClipBox( EDA_RECT* aClipBox )
@@ -152,6 +161,10 @@ private:
     // coordinates of each segment:
     void (* m_callback)( int x0, int y0, int xf, int yf );
 
+    // When calling the draw functions to cache the shape of a text, each polyline is
+    // stored in this list:
+    std::vector< std::vector<wxPoint> >* m_strokes;
+
     // When calling the draw functions for plot, the plotter acts as a wxDC
     // to plot basic items
     PLOTTER* m_plotter;
@@ -160,4 +173,8 @@ private:
 
 extern BASIC_GAL basic_gal;
 
+// basic_gal is shared by all the texts, and the plot threads draw texts concurrently:
+// hold this lock while using it
+extern MUTEX basic_galLock;
+
 #endif      // define BASIC_GAL_H
@@ -31,6 +31,9 @@
 #ifndef __INCLUDE__DRAWTXT_H__
 #define __INCLUDE__DRAWTXT_H__ 1
 
+#include <memory>
+#include <vector>
+
 #include <base_struct.h>
 #include <eda_text.h>               // EDA_TEXT_HJUSTIFY_T and EDA_TEXT_VJUSTIFY_T
 
@@ -51,6 +54,9 @@
 class EDA_DRAW_PANEL;
 class PLOTTER;
 
+/// The polylines of a graphic text, as drawn by DrawGraphicText
+typedef std::vector< std::vector<wxPoint> > TEXT_STROKES;
+
 /**
  * Function  Clamp_Text_PenSize
  *As a rule, pen width should not be >1/4em, otherwise the character
@@ -117,6 +123,24 @@ void DrawGraphicText( EDA_RECT* aClipBox,
                       void (*aCallback)( int x0, int y0, int xf, int yf ) = NULL,
                       PLOTTER * aPlotter = NULL );
 
+/**
+ * Function GetGraphicTextStrokes
+ * returns the polylines DrawGraphicText sends to a plotter or a callback for a text.
+ * See DrawGraphicText for the parameters.
+ * The strokes are cached, so a text which did not change is not run through the stroke
+ * font again by the next zone fill, plot or 3D view reload.
+ * @return the polylines of the text, shared with the cache.
+ */
+std::shared_ptr<const TEXT_STROKES> GetGraphicTextStrokes( const wxPoint& aPos,
+                                                           const wxString& aText,
+                                                           double aOrient,
+                                                           const wxSize& aSize,
+                                                           enum EDA_TEXT_HJUSTIFY_T aH_justify,
+                                                           enum EDA_TEXT_VJUSTIFY_T aV_justify,
+                                                           int aWidth,
+                                                           bool aItalic,
+                                                           bool aBold );
+
 
 /**
  * Draw graphic text with a border, so that it can be read on different
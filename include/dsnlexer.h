@@ -389,6 +389,22 @@ public:
      */
     wxArrayString* ReadCommentLines() throw( IO_ERROR );
 
+    /**
+     * Function ReadRawList
+     * copies the text of the list whose opening DSN_LEFT and first token were
+     * the last tokens read, up to and including its closing DSN_RIGHT, without
+     * tokenizing it.  Only parentheses, quoted strings and comment lines are
+     * recognized, so this is much faster than parsing the list.  Upon return
+     * the closing DSN_RIGHT is CurTok().  The text keeps its line structure and
+     * the column of the opening parenthesis, so a lexer reading it can report
+     * errors at the proper place.  Not available in specctraMode.
+     *
+     * @param aText receives the text of the list.
+     * @return int - the line number of the first line of \a aText.
+     * @throw IO_ERROR if the end of the input is reached within the list.
+     */
+    int ReadRawList( std::string& aText ) throw( IO_ERROR );
+
     /**
      * Function IsSymbol
      * tests a token to see if it is a symbol.  This means it cannot be a
@@ -333,6 +333,12 @@ class SHAPE_POLY_SET : public SHAPE
         ///> checks all polygons in the set
         bool Contains( const VECTOR2I& aP, int aSubpolyIndex = -1 ) const;
 
+        ///> Returns true if the subpolygon aSubpolyIndex contains at least one of the points
+        ///> aSortedPoints, which must be sorted by increasing y coordinate. Gives the same result
+        ///> as calling Contains( point, aSubpolyIndex ) for each point, but tests all the points
+        ///> in a single sweep over the outline edges.
+        bool ContainsAny( const std::vector<VECTOR2I>& aSortedPoints, int aSubpolyIndex ) const;
+
         ///> Returns true if the set is empty (no polygons at all)
         bool IsEmpty() const
         {
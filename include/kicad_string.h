@@ -85,6 +85,21 @@ char* GetLine( FILE* aFile, char* Line, int* LineNum = NULL, int SizeLine = 255
  */
 char* StrPurge( char* text );
 
+/**
+ * Function FixedPointToStr
+ * writes \a aValue / 10^\a aDecimals to \a aBuf in plain decimal notation, without
+ * trailing zeros and without a trailing decimal point, e.g. 1500000 with 6 decimals
+ * gives "1.5".  This is the text printf( "%.*g" ) gives for the same value when it
+ * has no more significant digits than the precision, but no floating point number
+ * is involved.
+ *
+ * @param aBuf must hold at least 24 bytes.
+ * @param aValue is the value, scaled by 10^\a aDecimals.
+ * @param aDecimals is the number of decimals of the scaled value, at most 19.
+ * @return int - the length of the nul terminated text in \a aBuf.
+ */
+int FixedPointToStr( char* aBuf, long long aValue, int aDecimals );
+
 /**
  * Function DateAndTime
  * @return a string giving the current date and time.
@@ -32,6 +32,9 @@
 #ifndef PLOT_COMMON_H_
 #define PLOT_COMMON_H_
 
+#include <deque>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <math/box2.h>
 #include <drawtxt.h>
@@ -704,6 +707,7 @@ protected:
                                       bool aItalic, bool aBold,
                                       std::vector<int> *pos_pairs );
     void fputsPostscriptString(FILE *fout, const wxString& txt);
+    void appendPostscriptString( std::string& aOut, const wxString& txt );
 
     /// Virtual primitive for emitting the setrgbcolor operator
     virtual void emitSetRGBColor( double r, double g, double b ) = 0;
@@ -783,7 +787,7 @@ protected:
 class PDF_PLOTTER : public PSLIKE_PLOTTER
 {
 public:
-    PDF_PLOTTER() : pageStreamHandle( 0 ), workFile( NULL )
+    PDF_PLOTTER() : pageStreamHandle( 0 ), workStream( NULL ), pendingBytes( 0 )
     {
         // Avoid non initialized variables:
         pageStreamHandle = streamLengthHandle = fontResDictHandle = 0;
@@ -859,13 +863,29 @@ protected:
     void closePdfObject();
     int startPdfStream(int handle = -1);
     void closePdfStream();
+    void flushPdfPages();
+    void workPrintf( const char* aFormat, ... );
+    void workCoord( double x, double y, const char* aOperator );
+
+    /// A page content stream, kept in memory until it is compressed and written
+    struct PDF_PAGE_STREAM
+    {
+        int         streamHandle;   ///< Handle of the content stream object
+        int         lengthHandle;   ///< Handle of the deferred stream length
+        int         pageHandle;     ///< Handle of the page object
+        wxSize      mediaBox;       ///< Page size in 1/72 inch
+        std::string content;        ///< The uncompressed content stream
+        std::string deflated;       ///< The zlib compressed content stream
+    };
+
     int pageTreeHandle;		 /// Handle to the root of the page tree object
     int fontResDictHandle;	 /// Font resource dictionary
     std::vector<int> pageHandles;/// Handles to the page objects
     int pageStreamHandle;	 /// Handle of the page content object
     int streamLengthHandle;      /// Handle to the deferred stream length
-    wxString workFilename;
-    FILE* workFile;  	         /// Temporary file to costruct the stream before zipping
+    std::string* workStream;     /// Content stream of the open page, NULL outside of a page
+    std::deque<PDF_PAGE_STREAM> pendingPages; /// Closed pages not yet written
+    size_t pendingBytes;         /// Size of the uncompressed pending pages
     std::vector<long> xrefTable; /// The PDF xref offset table
 };
 
@@ -961,18 +981,28 @@ class APERTURE
 {
 public:
     enum APERTURE_TYPE {
-        Circle   = 1,
-        Rect     = 2,
-        Plotting = 3,
-        Oval     = 4
+        Circle    = 1,
+        Rect      = 2,
+        Plotting  = 3,
+        Oval      = 4,
+        Outline4P = 5,      // 4 corners polygon (aperture macro)
+        RoundRect = 6       // rectangle with rounded corners (aperture macro)
     };
 
+    APERTURE() : m_Type( Circle ), m_DCode( 0 ), m_ApertureAttribute( 0 ), m_Radius( 0 ) {}
+
     wxSize        m_Size;     // horiz and Vert size
     APERTURE_TYPE m_Type;     // Type ( Line, rect , circulaire , ovale .. )
     int           m_DCode;    // code number ( >= 10 );
     int           m_ApertureAttribute;  // the attribute attached to this aperture
                                         // Only one attribute is allowed by aperture
                                         // 0 = no specific aperture attribute
+
+    // Macro apertures only: the 4 corners (of the polygon, or of the rectangle
+    // joining the centers of the rounded corners) relative to the flash position,
+    // already rotated, in IUs along the device axis
+    std::vector<wxPoint> m_Corners;
+    int           m_Radius;   // corner radius of a RoundRect
 };
 
 
@@ -1105,6 +1135,26 @@ public:
     void UseX2Attributes( bool aEnable ) { m_useX2Attributes = aEnable; }
     void UseX2NetAttributes( bool aEnable ) { m_useNetAttributes = aEnable; }
 
+    /**
+     * Compact output: rotated rectangles, rounded rectangles and trapezoids
+     * are flashed with aperture macros (identical pads share a D code)
+     * instead of being plotted as polygons, and PlotRegions writes all the
+     * polygons of a zone in a single region statement.
+     */
+    void UseCompactOutput( bool aEnable ) { m_compactOutput = aEnable; }
+    bool GetCompactOutput() const { return m_compactOutput; }
+
+    /**
+     * Plot filled polygons, like PlotPoly( FILLED_SHAPE ) called for each
+     * outline of aPolygons, but in compact mode as a single region (G36/G37)
+     * with one contour per outline, followed by the outlines when aWidth > 0.
+     * @param aPolygons = the polygons to plot (holes are ignored, the
+     * polygons are expected to be fractured)
+     * @param aWidth = the outline thickness, 0 to fill only
+     * @param aData = a GBR_METADATA, as for PlotPoly
+     */
+    void PlotRegions( const SHAPE_POLY_SET& aPolygons, int aWidth, void* aData );
+
     /**
      * calling this function allows to define the beginning of a group
      * of drawing items (used in X2 format with netlist attributes)
@@ -1128,6 +1178,15 @@ protected:
      */
     void selectAperture( const wxSize& aSize, APERTURE::APERTURE_TYPE aType,
                          int aApertureAttribute );
+    void selectAperture( const APERTURE& aAperture );
+
+    /**
+     * Flash a macro aperture (Outline4P or RoundRect) at aPadPos
+     * @param aCorners = the 4 corners, relative to aPadPos and already rotated
+     * @param aRadius = the corner radius (RoundRect only)
+     */
+    void flashMacroAperture( const wxPoint& aPadPos, APERTURE::APERTURE_TYPE aType,
+                             const wxPoint* aCorners, int aRadius, void* aData );
 
     /**
      * Emit a D-Code record, using proper conversions
@@ -1161,6 +1220,7 @@ protected:
      */
     std::vector<APERTURE>::iterator getAperture( const wxSize& aSize,
                     APERTURE::APERTURE_TYPE aType, int aApertureAttribute );
+    std::vector<APERTURE>::iterator getAperture( const APERTURE& aAperture );
 
     // the attributes dictionnary created/modifed by %TO, attached the objects, when they are created
     // by D01, D03 G36/G37 commands
@@ -1186,6 +1246,10 @@ protected:
     std::vector<APERTURE>           apertures;
     std::vector<APERTURE>::iterator currentAperture;
 
+    /// Index in apertures of each aperture, by a key built from its shape
+    /// and attribute, to avoid a linear search for each flash
+    std::unordered_map<std::string, int> m_apertureIndex;
+
     bool     m_gerberUnitInch;  // true if the gerber units are inches, false for mm
     int      m_gerberUnitFmt;   // number of digits in mantissa.
                                 // usually 6 in Inches and 5 or 6  in mm
@@ -1194,6 +1258,7 @@ protected:
     bool    m_useNetAttributes; // In recent gerber files, netlist info can be added.
                                 // It will be added if this parm is true
                                 // (imply m_useX2Attributes == true)
+    bool    m_compactOutput;    // Use aperture macros and merged regions
 };
 
 
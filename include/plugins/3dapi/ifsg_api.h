@@ -84,6 +84,33 @@ namespace S3D
     SGLIB_API SGNODE* ReadCache( const char* aFileName, void* aPluginMgr,
         bool (*aTagCheck)( const char*, void* ) );
 
+    /**
+     * Function WriteModelCache
+     * writes an S3DMODEL to a binary model cache file; the vertex, normal,
+     * color and index arrays of each mesh are stored as flat, aligned blocks
+     * so the file can be mapped in memory and read back without parsing
+     *
+     * @param aFileName is the name of the file to write
+     * @param aModel is the model to be written
+     * @param aPluginInfo is the PluginName:Version string of the plugin
+     * which created the model
+     * @return true on success
+     */
+    SGLIB_API bool WriteModelCache( const char* aFileName, const S3DMODEL* aModel,
+        const char* aPluginInfo );
+
+    /**
+     * Function ReadModelCache
+     * reads a binary model cache file written by WriteModelCache() and
+     * creates an S3DMODEL; no SCENEGRAPH is built
+     *
+     * @param aFileName is the name of the model cache file to be read
+     * @return NULL on failure, on success a pointer to a new S3DMODEL which
+     * may be freed via Destroy3DModel()
+     */
+    SGLIB_API S3DMODEL* ReadModelCache( const char* aFileName, void* aPluginMgr,
+        bool (*aTagCheck)( const char*, void* ) );
+
     /**
      * Function WriteVRML
      * writes out the given node and its subnodes to a VRML2 file
@@ -307,6 +307,7 @@ public:
 
 
 #define OUTPUTFMTBUFZ    500        ///< default buffer size for any OUTPUT_FORMATTER
+#define FILE_OUTPUTFMTBUFZ  ( 256 * 1024 )  ///< file buffer size of a FILE_OUTPUTFORMATTER
 
 /**
  * Class OUTPUTFORMATTER
@@ -516,6 +517,7 @@ protected:
 
     FILE*       m_fp;               ///< takes ownership
     wxString    m_filename;
+    std::vector<char> m_buffer;     ///< stdio buffer of m_fp, must outlive it
 };
 
 
@@ -53,6 +53,7 @@ class DIMENSION;
 class EDGE_MODULE;
 class DRC;
 class ZONE_CONTAINER;
+class ZONE_ANCHOR_POINTS;
 class DRAWSEGMENT;
 class GENERAL_COLLECTOR;
 class GENERAL_COLLECTORS_GUIDE;
@@ -1357,9 +1358,11 @@ public:
      *  The filling starts from starting points like pads, tracks.
      * If exists the old filling is removed
      * @param aZone = zone to fill
+     * @param aAnchors = the board anchor points used to remove insulated islands,
+     *                   when shared by several fills (NULL to build them for this zone)
      * @return error level (0 = no error)
      */
-    int Fill_Zone( ZONE_CONTAINER* aZone );
+    int Fill_Zone( ZONE_CONTAINER* aZone, const ZONE_ANCHOR_POINTS* aAnchors = NULL );
 
     /**
      * Function Fill_All_Zones
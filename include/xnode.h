@@ -95,6 +95,16 @@ public:
      */
     virtual void FormatContents( OUTPUTFORMATTER* out, int nestLevel ) throw( IO_ERROR );
 
+    /**
+     * Function FormatXml
+     * writes this object as UTF8 out to an OUTPUTFORMATTER as XML, exactly as
+     * wxXmlDocument::Save() writes it with an indentation step of 2.
+     * @param out The formatter to write to.
+     * @param aIndent The number of spaces the element is indented with; the
+     *  caller writes the indentation before the element itself.
+     * @throw IO_ERROR if a system error writing the output, such as a full disk.
+     */
+    void FormatXml( OUTPUTFORMATTER* out, int aIndent ) throw( IO_ERROR );
 };
 
 #endif  // XNODE_H_
@@ -31,6 +31,7 @@
  * Used to fill zones areas and in 3D viewer
  */
 #include <vector>
+#include <unordered_map>
 
 #include <fctsys.h>
 #include <drawtxt.h>
@@ -46,20 +47,122 @@
 #include <class_module.h>
 #include <class_edge_mod.h>
 #include <convert_basic_shapes_to_polygon.h>
+#include <ki_mutex.h>
 
-// These variables are parameters used in addTextSegmToPoly.
-// But addTextSegmToPoly is a call-back function,
-// so we cannot send them as arguments.
-static int s_textWidth;
-static int s_textCircle2SegmentCount;
-static SHAPE_POLY_SET* s_cornerBuffer;
 
-// This is a call back function, used by DrawGraphicText to draw the 3D text shape:
-static void addTextSegmToPoly( int x0, int y0, int xf, int yf )
+/* The text outlines are cached until they hold this many corners (32 MB), then the cache
+ * is emptied and filled again.
+ */
+#define TEXT_OUTLINES_CACHE_MAX_CORNERS 4000000
+
+
+/**
+ * Struct TEXT_OUTLINES_KEY
+ * identifies the outlines of the strokes of a text inflated to a given width.
+ * The strokes are the ones cached by GetGraphicTextStrokes.
+ */
+struct TEXT_OUTLINES_KEY
 {
-    TransformRoundedEndsSegmentToPolygon( *s_cornerBuffer,
-                                           wxPoint( x0, y0), wxPoint( xf, yf ),
-                                           s_textCircle2SegmentCount, s_textWidth );
+    const TEXT_STROKES* m_strokes;
+    int                 m_width;
+    int                 m_circleToSegmentsCount;
+
+    bool operator==( const TEXT_OUTLINES_KEY& aOther ) const
+    {
+        return m_strokes == aOther.m_strokes && m_width == aOther.m_width
+            && m_circleToSegmentsCount == aOther.m_circleToSegmentsCount;
+    }
+};
+
+
+struct TEXT_OUTLINES_KEY_HASH
+{
+    std::size_t operator()( const TEXT_OUTLINES_KEY& aKey ) const
+    {
+        return std::hash<const TEXT_STROKES*>()( aKey.m_strokes )
+               ^ ( std::hash<int>()( aKey.m_width ) * 31 )
+               ^ ( std::hash<int>()( aKey.m_circleToSegmentsCount ) * 131 );
+    }
+};
+
+
+struct TEXT_OUTLINES
+{
+    std::shared_ptr<const TEXT_STROKES> m_strokes;      // Keeps the key address in use
+    SHAPE_POLY_SET                      m_outlines;
+};
+
+
+typedef std::unordered_map< TEXT_OUTLINES_KEY, TEXT_OUTLINES,
+                            TEXT_OUTLINES_KEY_HASH > TEXT_OUTLINES_CACHE;
+
+static TEXT_OUTLINES_CACHE s_textOutlinesCache;
+static size_t              s_textOutlinesCorners = 0;
+static MUTEX               s_textOutlinesLock;
+
+
+/**
+ * Function addTextToPolygonSet
+ * appends to \a aCornerBuffer the outlines of the strokes of a text, each stroke
+ * inflated to \a aOutlineWidth with rounded ends.
+ * The outlines are cached, so a text which did not change is not converted again by the
+ * next zone fill, plot or 3D view reload.
+ */
+static void addTextToPolygonSet( SHAPE_POLY_SET& aCornerBuffer,
+                                 const wxPoint& aPos, const wxString& aText,
+                                 double aOrient, const wxSize& aSize,
+                                 EDA_TEXT_HJUSTIFY_T aH_justify,
+                                 EDA_TEXT_VJUSTIFY_T aV_justify,
+                                 int aThickness, bool aItalic,
+                                 int aOutlineWidth, int aCircleToSegmentsCount )
+{
+    TEXT_OUTLINES entry;
+
+    entry.m_strokes = GetGraphicTextStrokes( aPos, aText, aOrient, aSize,
+                                             aH_justify, aV_justify,
+                                             aThickness, aItalic, true );
+
+    TEXT_OUTLINES_KEY key;
+    key.m_strokes = entry.m_strokes.get();
+    key.m_width = aOutlineWidth;
+    key.m_circleToSegmentsCount = aCircleToSegmentsCount;
+
+    {
+        MUTLOCK lock( s_textOutlinesLock );
+
+        TEXT_OUTLINES_CACHE::const_iterator it = s_textOutlinesCache.find( key );
+
+        if( it != s_textOutlinesCache.end() )
+        {
+            aCornerBuffer.Append( it->second.m_outlines );
+            return;
+        }
+    }
+
+    const TEXT_STROKES& strokes = *entry.m_strokes;
+
+    for( unsigned ii = 0; ii < strokes.size(); ii++ )
+    {
+        for( unsigned jj = 1; jj < strokes[ii].size(); jj++ )
+            TransformRoundedEndsSegmentToPolygon( entry.m_outlines,
+                                                  strokes[ii][jj-1], strokes[ii][jj],
+                                                  aCircleToSegmentsCount, aOutlineWidth );
+    }
+
+    aCornerBuffer.Append( entry.m_outlines );
+
+    size_t corners = entry.m_outlines.TotalVertices();
+
+    MUTLOCK lock( s_textOutlinesLock );
+
+    if( s_textOutlinesCorners + corners > TEXT_OUTLINES_CACHE_MAX_CORNERS )
+    {
+        s_textOutlinesCache.clear();
+        s_textOutlinesCorners = 0;
+    }
+
+    if( s_textOutlinesCache.insert( std::make_pair( key, entry ) ).second )
+        s_textOutlinesCorners += corners;
 }
 
 
@@ -247,28 +350,26 @@ void MODULE::TransformGraphicShapesWithClearanceToPolygonSet(
     if( Value().GetLayer() == aLayer && Value().IsVisible() )
         texts.push_back( &Value() );
 
-    s_cornerBuffer = &aCornerBuffer;
-
     // To allow optimization of circles approximated by segments,
     // aCircleToSegmentsCountForTexts, when not 0, is used.
     // if 0 (default value) the aCircleToSegmentsCount is used
-    s_textCircle2SegmentCount = aCircleToSegmentsCountForTexts ?
-                                aCircleToSegmentsCountForTexts : aCircleToSegmentsCount;
+    int textCircle2SegmentCount = aCircleToSegmentsCountForTexts ?
+                                  aCircleToSegmentsCountForTexts : aCircleToSegmentsCount;
 
     for( unsigned ii = 0; ii < texts.size(); ii++ )
     {
         TEXTE_MODULE *textmod = texts[ii];
-        s_textWidth  = textmod->GetThickness() + ( 2 * aInflateValue );
+        int textWidth = textmod->GetThickness() + ( 2 * aInflateValue );
         wxSize size = textmod->GetSize();
 
         if( textmod->IsMirrored() )
             size.x = -size.x;
 
-        DrawGraphicText( NULL, NULL, textmod->GetTextPosition(), BLACK,
-                         textmod->GetShownText(), textmod->GetDrawRotation(), size,
-                         textmod->GetHorizJustify(), textmod->GetVertJustify(),
-                         textmod->GetThickness(), textmod->IsItalic(),
-                         true, addTextSegmToPoly );
+        addTextToPolygonSet( aCornerBuffer, textmod->GetTextPosition(),
+                             textmod->GetShownText(), textmod->GetDrawRotation(), size,
+                             textmod->GetHorizJustify(), textmod->GetVertJustify(),
+                             textmod->GetThickness(), textmod->IsItalic(),
+                             textWidth, textCircle2SegmentCount );
     }
 
 }
@@ -316,28 +417,26 @@ void MODULE::TransformGraphicTextWithClearanceToPolygonSet(
     if( Value().GetLayer() == aLayer && Value().IsVisible() )
         texts.push_back( &Value() );
 
-    s_cornerBuffer = &aCornerBuffer;
-
     // To allow optimization of circles approximated by segments,
     // aCircleToSegmentsCountForTexts, when not 0, is used.
     // if 0 (default value) the aCircleToSegmentsCount is used
-    s_textCircle2SegmentCount = aCircleToSegmentsCountForTexts ?
-                                aCircleToSegmentsCountForTexts : aCircleToSegmentsCount;
+    int textCircle2SegmentCount = aCircleToSegmentsCountForTexts ?
+                                  aCircleToSegmentsCountForTexts : aCircleToSegmentsCount;
 
     for( unsigned ii = 0; ii < texts.size(); ii++ )
     {
         TEXTE_MODULE *textmod = texts[ii];
-        s_textWidth  = textmod->GetThickness() + ( 2 * aInflateValue );
+        int textWidth = textmod->GetThickness() + ( 2 * aInflateValue );
         wxSize size = textmod->GetSize();
 
         if( textmod->IsMirrored() )
             size.x = -size.x;
 
-        DrawGraphicText( NULL, NULL, textmod->GetTextPosition(), BLACK,
-                         textmod->GetShownText(), textmod->GetDrawRotation(), size,
-                         textmod->GetHorizJustify(), textmod->GetVertJustify(),
-                         textmod->GetThickness(), textmod->IsItalic(),
-                         true, addTextSegmToPoly );
+        addTextToPolygonSet( aCornerBuffer, textmod->GetTextPosition(),
+                             textmod->GetShownText(), textmod->GetDrawRotation(), size,
+                             textmod->GetHorizJustify(), textmod->GetVertJustify(),
+                             textmod->GetThickness(), textmod->IsItalic(),
+                             textWidth, textCircle2SegmentCount );
     }
 
 }
@@ -442,10 +541,7 @@ void TEXTE_PCB::TransformShapeWithClearanceToPolygonSet(
     if( IsMirrored() )
         size.x = -size.x;
 
-    s_cornerBuffer = &aCornerBuffer;
-    s_textWidth  = GetThickness() + ( 2 * aClearanceValue );
-    s_textCircle2SegmentCount = aCircleToSegmentsCount;
-    EDA_COLOR_T color = BLACK;  // not actually used, but needed by DrawGraphicText
+    int textWidth = GetThickness() + ( 2 * aClearanceValue );
 
     if( IsMultilineAllowed() )
     {
@@ -458,20 +554,19 @@ void TEXTE_PCB::TransformShapeWithClearanceToPolygonSet(
         for( unsigned ii = 0; ii < strings_list.Count(); ii++ )
         {
             wxString txt = strings_list.Item( ii );
-            DrawGraphicText( NULL, NULL, positions[ii], color,
-                             txt, GetOrientation(), size,
-                             GetHorizJustify(), GetVertJustify(),
-                             GetThickness(), IsItalic(),
-                             true, addTextSegmToPoly );
+            addTextToPolygonSet( aCornerBuffer, positions[ii], txt, GetOrientation(), size,
+                                 GetHorizJustify(), GetVertJustify(),
+                                 GetThickness(), IsItalic(),
+                                 textWidth, aCircleToSegmentsCount );
         }
     }
     else
     {
-        DrawGraphicText( NULL, NULL, GetTextPosition(), color,
-                         GetShownText(), GetOrientation(), size,
-                         GetHorizJustify(), GetVertJustify(),
-                         GetThickness(), IsItalic(),
-                         true, addTextSegmToPoly );
+        addTextToPolygonSet( aCornerBuffer, GetTextPosition(), GetShownText(),
+                             GetOrientation(), size,
+                             GetHorizJustify(), GetVertJustify(),
+                             GetThickness(), IsItalic(),
+                             textWidth, aCircleToSegmentsCount );
     }
 }
 
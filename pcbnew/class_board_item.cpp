@@ -34,6 +34,8 @@
 
 #include <class_board.h>
 #include <string>
+#include <cmath>
+#include <kicad_string.h>
 
 wxString BOARD_ITEM::ShowShape( STROKE_T aShape )
 {
@@ -90,6 +92,20 @@ std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 {
 #if 1
 
+    // aValue is in nanometers, so the value in millimeters is aValue with six
+    // decimals.  An int has at most 10 digits, so this is exactly the text the
+    // general purpose algorithm below gives, without the cost of sprintf.
+    static_assert( IU_PER_MM == 1e6, "FormatInternalUnits() expects nanometers" );
+
+    char    buf[50];
+    int     len = FixedPointToStr( buf, aValue, 6 );
+
+    return std::string( buf, len );
+
+#else
+
+    // The general purpose algorithm, which can be used to verify the one above.
+
     char    buf[50];
     int     len;
     double  mm = aValue / IU_PER_MM;
@@ -113,56 +129,6 @@ std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 
     return std::string( buf, len );
 
-#else
-
-    // Assume aValue is in nanometers, and that we want the result in millimeters,
-    // and that int is 32 bits wide.  Then perform an alternative algorithm.
-    // Can be used to verify that the above algorithm is correctly generating text.
-    // Convert aValue into an integer string, then insert a decimal point manually.
-    // Results are the same as above general purpose algorithm.
-
-    wxASSERT( sizeof(int) == 4 );
-
-    if( aValue == 0 )
-        return std::string( 1, '0' );
-    else
-    {
-        char    buf[50];
-        int     len = sprintf( buf, aValue > 0 ? "%06d" : "%07d", aValue );     // optionally pad w/leading zeros
-
-        std::string ret( buf, len );
-
-        std::string::iterator it = ret.end() - 1;           // last byte
-
-        // insert '.' at 6 positions from end, dividing by 10e6 (a million), nm => mm
-        std::string::iterator decpoint = ret.end() - 6;
-
-        // truncate trailing zeros, up to decimal point position
-        for(  ; *it=='0' && it >= decpoint;  --it )
-            ret.erase( it );    // does not invalidate iterators it or decpoint
-
-        if( it >= decpoint )
-        {
-            ret.insert( decpoint, '.' );
-
-            // decpoint is invalidated here, after insert()
-
-#if 1       // want a leading zero when decimal point is in first position?
-            if( ret[0] == '.' )
-            {
-                // insert leading zero ahead of decimal point.
-                ret.insert( ret.begin(), '0' );
-            }
-            else if( ret[0]=='-' && ret[1]=='.' )
-            {
-                ret.insert( ret.begin() + 1, '0' );
-            }
-#endif
-        }
-
-        return ret;
-    }
-
 #endif
 }
 
@@ -170,8 +136,19 @@ std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 std::string BOARD_ITEM::FormatAngle( double aAngle )
 {
     char temp[50];
+    int  len;
 
-    int len = snprintf( temp, sizeof(temp), "%.10g", aAngle / 10.0 );
+    if( fabs( aAngle ) < 1e9 && aAngle == (double) (long long) aAngle
+        && !( aAngle == 0.0 && std::signbit( aAngle ) ) )
+    {
+        // Angles are nearly always whole tenths of degrees, which have less
+        // significant digits than %.10g prints, so the text is exact
+        len = FixedPointToStr( temp, (long long) aAngle, 1 );
+    }
+    else
+    {
+        len = snprintf( temp, sizeof(temp), "%.10g", aAngle / 10.0 );
+    }
 
     return std::string( temp, len );
 }
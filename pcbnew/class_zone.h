@@ -33,6 +33,7 @@
 
 
 #include <vector>
+#include <map>
 #include <gr_basic.h>
 #include <class_board_item.h>
 #include <class_board_connected_item.h>
@@ -69,6 +70,32 @@ struct SEGMENT
 };
 
 
+/**
+ * Class ZONE_ANCHOR_POINTS
+ * is an index of the points which connect a zone filled area to its net: pad positions,
+ * track ends and via positions, grouped by net and copper layer and sorted by y coordinate.
+ * It is built once from the board, and can be shared by all the zones filled in a batch,
+ * as long as the pads and tracks are not modified.
+ */
+class ZONE_ANCHOR_POINTS
+{
+public:
+    ZONE_ANCHOR_POINTS( BOARD* aPcb );
+
+    /**
+     * Function GetPoints
+     * @return the anchor points of net aNetCode on layer aLayer, sorted by y coordinate,
+     * or NULL if there are none.
+     */
+    const std::vector<VECTOR2I>* GetPoints( int aNetCode, LAYER_ID aLayer ) const;
+
+private:
+    typedef std::pair<int, LAYER_ID> KEY;
+
+    std::map< KEY, std::vector<VECTOR2I> > m_points;
+};
+
+
 /**
  * Class ZONE_CONTAINER
  * handles a list of polygons defining a copper zone.
@@ -156,8 +183,11 @@ public:
      * Function TestForCopperIslandAndRemoveInsulatedIslands
      * Remove insulated copper islands found in m_FilledPolysList.
      * @param aPcb = the board to analyze
+     * @param aAnchors = the anchor points of the board, if already built (NULL to build them
+     *                   here)
      */
-    void TestForCopperIslandAndRemoveInsulatedIslands( BOARD* aPcb );
+    void TestForCopperIslandAndRemoveInsulatedIslands( BOARD* aPcb,
+                                                       const ZONE_ANCHOR_POINTS* aAnchors = NULL );
 
     /**
      * Function IsOnCopperLayer
@@ -276,8 +306,11 @@ public:
      * When aOutlineBuffer is not null, his function calls
      * AddClearanceAreasPolygonsToPolysList() to add holes for pads and tracks
      * and other items not in net.
+     * @param aAnchors: the anchor points used to remove insulated islands, or NULL
+     * to build them from aPcb
      */
-    bool BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer = NULL );
+    bool BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer = NULL,
+                                        const ZONE_ANCHOR_POINTS* aAnchors = NULL );
 
     /**
      * Function AddClearanceAreasPolygonsToPolysList
@@ -292,7 +325,8 @@ public:
      * _NG version uses SHAPE_POLY_SET instead of Boost.Polygon
      */
     void AddClearanceAreasPolygonsToPolysList( BOARD* aPcb );
-    void AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb );
+    void AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb,
+                                                  const ZONE_ANCHOR_POINTS* aAnchors = NULL );
 
 
      /**
@@ -170,6 +170,10 @@ void DIALOG_PLOT::Init_Dialog()
     m_plotOpts.SetIncludeGerberNetlistInfo( false );
     m_useGerberNetAttributes->SetValue( false );
 #endif
+
+    // Option for aperture macros and merged regions in Gerber output
+    m_useGerberCompactOutput->SetValue( m_plotOpts.GetUseGerberCompactOutput() );
+
     // Gerber precision for coordinates
     m_rbGerberFormat->SetSelection( m_plotOpts.GetGerberPrecision() == 5 ? 0 : 1 );
 
@@ -637,6 +641,7 @@ void DIALOG_PLOT::applyPlotSettings()
     tempOptions.SetUseGerberProtelExtensions( m_useGerberExtensions->GetValue() );
     tempOptions.SetUseGerberAttributes( m_useGerberX2Attributes->GetValue() );
     tempOptions.SetIncludeGerberNetlistInfo( m_useGerberNetAttributes->GetValue() );
+    tempOptions.SetUseGerberCompactOutput( m_useGerberCompactOutput->GetValue() );
     tempOptions.SetGerberPrecision( m_rbGerberFormat->GetSelection() == 0 ? 5 : 6 );
 
     LSET selectedLayers;
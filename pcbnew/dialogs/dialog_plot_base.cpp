@@ -243,6 +243,11 @@ DIALOG_PLOT_BASE::DIALOG_PLOT_BASE( wxWindow* parent, wxWindowID id, const wxStr
 	
 	bSizerGbrOpt->Add( m_subtractMaskFromSilk, 0, wxALL, 2 );
 	
+	m_useGerberCompactOutput = new wxCheckBox( m_GerberOptionsSizer->GetStaticBox(), wxID_ANY, _("Use compact output"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_useGerberCompactOutput->SetToolTip( _("Use aperture macros for rounded pads and merge track regions to reduce file size") );
+	
+	bSizerGbrOpt->Add( m_useGerberCompactOutput, 0, wxALL, 2 );
+	
 	
 	m_GerberOptionsSizer->Add( bSizerGbrOpt, 0, wxALIGN_CENTER_VERTICAL, 5 );
 	
@@ -95,6 +95,7 @@ class DIALOG_PLOT_BASE : public DIALOG_SHIM
 		wxCheckBox* m_useGerberX2Attributes;
 		wxCheckBox* m_useGerberNetAttributes;
 		wxCheckBox* m_subtractMaskFromSilk;
+		wxCheckBox* m_useGerberCompactOutput;
 		wxRadioBox* m_rbGerberFormat;
 		wxStaticBoxSizer* m_HPGLOptionsSizer;
 		wxStaticText* m_textPenSize;
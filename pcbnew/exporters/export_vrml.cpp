@@ -29,6 +29,7 @@
 #include <fstream>
 #include <iomanip>
 #include <vector>
+#include <memory>
 #include <wx/dir.h>
 
 #include "3d_cache/3d_cache.h"
@@ -969,6 +970,7 @@ static void export_vrml_tracks( MODEL_VRML& aModel, BOARD* pcb )
 
 static void export_vrml_zones( MODEL_VRML& aModel, BOARD* aPcb )
 {
+    std::unique_ptr<ZONE_ANCHOR_POINTS> anchors;
 
     for( int ii = 0; ii < aPcb->GetAreaCount(); ii++ )
     {
@@ -982,7 +984,11 @@ static void export_vrml_zones( MODEL_VRML& aModel, BOARD* aPcb )
         if( !zone->IsFilled() )
         {
             zone->SetFillMode( 0 ); // use filled polygons
-            zone->BuildFilledSolidAreasPolygons( aPcb );
+
+            if( !anchors )
+                anchors.reset( new ZONE_ANCHOR_POINTS( aPcb ) );
+
+            zone->BuildFilledSolidAreasPolygons( aPcb, NULL, anchors.get() );
         }
 
         const SHAPE_POLY_SET& poly = zone->GetFilledPolysList();
@@ -28,6 +28,13 @@
  */
 
 #include <errno.h>
+#include <algorithm>
+#include <exception>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
 #include <common.h>
 #include <confirm.h>
 #include <macros.h>
@@ -53,6 +60,22 @@
 using namespace PCB_KEYS_T;
 
 
+/**
+ * Class SECTION_LINE_READER
+ * reads the text of a deferred board section and numbers its lines as they are
+ * numbered in the board file, so errors are reported at the right place.
+ */
+class SECTION_LINE_READER : public STRING_LINE_READER
+{
+public:
+    SECTION_LINE_READER( const std::string& aText, const wxString& aSource, int aFirstLine ) :
+        STRING_LINE_READER( aText, aSource )
+    {
+        lineNum = aFirstLine - 1;
+    }
+};
+
+
 void PCB_PARSER::init()
 {
     m_tooRecent = false;
@@ -463,6 +486,7 @@ BOARD* PCB_PARSER::parseBOARD() throw( IO_ERROR, PARSE_ERROR, FUTURE_FORMAT_ERRO
 BOARD* PCB_PARSER::parseBOARD_unchecked() throw( IO_ERROR, PARSE_ERROR )
 {
     T token;
+    std::vector<DEFERRED_SECTION> deferred;
 
     parseHeader();
 
@@ -473,6 +497,19 @@ BOARD* PCB_PARSER::parseBOARD_unchecked() throw( IO_ERROR, PARSE_ERROR )
 
         token = NextTok();
 
+        // Modules, segments and vias make up most of a board and only depend on the
+        // layers and nets defined before them, so runs of them are only copied here
+        // and parsed in parallel before the next section of another kind.
+        if( token == T_module || token == T_segment || token == T_via )
+        {
+            deferred.push_back( DEFERRED_SECTION() );
+            deferred.back().token = token;
+            deferred.back().line  = ReadRawList( deferred.back().text );
+            continue;
+        }
+
+        parseDeferredSections( deferred );
+
         switch( token )
         {
         case T_general:
@@ -519,18 +556,6 @@ BOARD* PCB_PARSER::parseBOARD_unchecked() throw( IO_ERROR, PARSE_ERROR )
             m_board->Add( parseDIMENSION(), ADD_APPEND );
             break;
 
-        case T_module:
-            m_board->Add( parseMODULE(), ADD_APPEND );
-            break;
-
-        case T_segment:
-            m_board->Add( parseTRACK(), ADD_APPEND );
-            break;
-
-        case T_via:
-            m_board->Add( parseVIA(), ADD_APPEND );
-            break;
-
         case T_zone:
             m_board->Add( parseZONE_CONTAINER(), ADD_APPEND );
             break;
@@ -546,10 +571,122 @@ BOARD* PCB_PARSER::parseBOARD_unchecked() throw( IO_ERROR, PARSE_ERROR )
         }
     }
 
+    parseDeferredSections( deferred );
+
     return m_board;
 }
 
 
+bool PCB_PARSER::setNetCode( BOARD_CONNECTED_ITEM* aItem, int aNetCode )
+{
+    bool ok;
+
+#ifdef USE_OPENMP
+    #pragma omp critical( pcbParserNetCode )
+#endif
+    ok = aItem->SetNetCode( aNetCode, /* aNoAssert */ true );
+
+    return ok;
+}
+
+
+void PCB_PARSER::parseDeferredSections( std::vector<DEFERRED_SECTION>& aSections )
+    throw( IO_ERROR, PARSE_ERROR, FUTURE_FORMAT_ERROR )
+{
+    if( aSections.empty() )
+        return;
+
+    const int                       count = aSections.size();
+    const wxString                  source = CurSource();
+    std::vector<BOARD_ITEM*>        items( count, (BOARD_ITEM*) NULL );
+    std::vector<std::exception_ptr> errors( count );
+    int                             requiredVersion = m_requiredVersion;
+
+#ifdef USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        PCB_PARSER parser;
+
+        parser.m_board           = m_board;
+        parser.m_layerIndices    = m_layerIndices;
+        parser.m_layerMasks      = m_layerMasks;
+        parser.m_netCodes        = m_netCodes;
+        parser.m_requiredVersion = m_requiredVersion;
+        parser.m_tooRecent       = m_tooRecent;
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for( int i = 0; i < count; ++i )
+        {
+            try
+            {
+                items[i] = parser.parseDeferredSection( aSections[i], source );
+            }
+            catch( ... )
+            {
+                errors[i] = std::current_exception();
+            }
+        }
+
+#ifdef USE_OPENMP
+        #pragma omp critical( pcbParserVersion )
+#endif
+        requiredVersion = std::max( requiredVersion, parser.m_requiredVersion );
+    }
+
+    m_requiredVersion = requiredVersion;
+    m_tooRecent = ( m_requiredVersion > SEXPR_BOARD_FILE_VERSION );
+
+    for( int i = 0; i < count; ++i )
+    {
+        if( errors[i] )
+        {
+            for( int j = 0; j < count; ++j )
+                delete items[j];
+
+            aSections.clear();
+            std::rethrow_exception( errors[i] );
+        }
+    }
+
+    for( int i = 0; i < count; ++i )
+        m_board->Add( items[i], ADD_APPEND );
+
+    aSections.clear();
+}
+
+
+BOARD_ITEM* PCB_PARSER::parseDeferredSection( const DEFERRED_SECTION& aSection,
+                                              const wxString& aSource )
+    throw( IO_ERROR, PARSE_ERROR, FUTURE_FORMAT_ERROR )
+{
+    SECTION_LINE_READER reader( aSection.text, aSource, aSection.line );
+
+    SetLineReader( &reader );
+
+    NeedLEFT();
+
+    T token = NextTok();
+
+    if( token != aSection.token )
+        Expecting( aSection.token );
+
+    switch( token )
+    {
+    case T_module:
+        return parseMODULE();
+
+    case T_segment:
+        return parseTRACK();
+
+    default:
+        return parseVIA();
+    }
+}
+
+
 void PCB_PARSER::parseHeader() throw( IO_ERROR, PARSE_ERROR )
 {
     wxCHECK_RET( CurTok() == T_kicad_pcb,
@@ -2421,7 +2558,7 @@ D_PAD* PCB_PARSER::parseD_PAD( MODULE* aParent ) throw( IO_ERROR, PARSE_ERROR )
             break;
 
         case T_net:
-            if( ! pad->SetNetCode( getNetCode( parseInt( "net number" ) ), /* aNoAssert */ true ) )
+            if( !setNetCode( pad, getNetCode( parseInt( "net number" ) ) ) )
                 THROW_IO_ERROR(
                     wxString::Format( _( "invalid net ID in\nfile: <%s>\nline: %d\noffset: %d" ),
                                       GetChars( CurSource() ), CurLineNumber(), CurOffset() )
@@ -2532,7 +2669,7 @@ TRACK* PCB_PARSER::parseTRACK() throw( IO_ERROR, PARSE_ERROR )
             break;
 
         case T_net:
-            if( ! track->SetNetCode( getNetCode( parseInt( "net number" ) ), /* aNoAssert */ true ) )
+            if( !setNetCode( track, getNetCode( parseInt( "net number" ) ) ) )
                 THROW_IO_ERROR(
                     wxString::Format( _( "invalid net ID in\nfile: <%s>\nline: %d\noffset: %d" ),
                                       GetChars( CurSource() ), CurLineNumber(), CurOffset() )
@@ -2614,7 +2751,7 @@ VIA* PCB_PARSER::parseVIA() throw( IO_ERROR, PARSE_ERROR )
             break;
 
         case T_net:
-            if(! via->SetNetCode( getNetCode( parseInt( "net number" ) ), /* aNoAssert */ true))
+            if( !setNetCode( via, getNetCode( parseInt( "net number" ) ) ) )
                 THROW_IO_ERROR(
                     wxString::Format( _( "invalid net ID in\nfile: <%s>\nline: %d\noffset: %d" ),
                                       GetChars( CurSource() ), CurLineNumber(), CurOffset() )
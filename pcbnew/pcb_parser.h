@@ -40,9 +40,13 @@
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 
+#include <string>
+#include <vector>
+
 
 class BOARD;
 class BOARD_ITEM;
+class BOARD_CONNECTED_ITEM;
 class D_PAD;
 class DIMENSION;
 class DRAWSEGMENT;
@@ -68,6 +72,19 @@ class PCB_PARSER : public PCB_LEXER
     typedef boost::unordered_map< std::string, LAYER_ID >   LAYER_ID_MAP;
     typedef boost::unordered_map< std::string, LSET >       LSET_MAP;
 
+    /**
+     * Struct DEFERRED_SECTION
+     * is the raw text of a module, segment or via section of a board file.  These
+     * sections are independent of each other, so parseBOARD_unchecked() only
+     * copies them and parseDeferredSections() parses runs of them concurrently.
+     */
+    struct DEFERRED_SECTION
+    {
+        PCB_KEYS_T::T   token;      ///< T_module, T_segment or T_via
+        int             line;       ///< line number of the section in the board file
+        std::string     text;       ///< the section, from its '(' to its ')'
+    };
+
     BOARD*              m_board;
     LAYER_ID_MAP        m_layerIndices;     ///< map layer name to it's index
     LSET_MAP            m_layerMasks;       ///< map layer names to their masks
@@ -102,6 +119,35 @@ class PCB_PARSER : public PCB_LEXER
      */
     void init();
 
+    /**
+     * Function setNetCode
+     * sets the net of a parsed item.  BOARD_CONNECTED_ITEM::SetNetCode() also
+     * updates the ratsnest of the board, so the calls are serialized between the
+     * threads of parseDeferredSections().
+     */
+    bool setNetCode( BOARD_CONNECTED_ITEM* aItem, int aNetCode );
+
+    /**
+     * Function parseDeferredSections
+     * parses \a aSections, concurrently when OpenMP is available, adds the
+     * resulting items to the board in file order and clears \a aSections.
+     * Each thread uses its own PCB_PARSER, set up with the layer maps and the
+     * net code mapping of this one, so the sections must not depend on anything
+     * which comes between them in the file.
+     *
+     * @throw the error of the first section, in file order, which failed to parse.
+     */
+    void parseDeferredSections( std::vector<DEFERRED_SECTION>& aSections )
+        throw( IO_ERROR, PARSE_ERROR, FUTURE_FORMAT_ERROR );
+
+    /**
+     * Function parseDeferredSection
+     * parses a single deferred section using this parser.
+     * @param aSource is the name of the board file, for error messages.
+     */
+    BOARD_ITEM* parseDeferredSection( const DEFERRED_SECTION& aSection, const wxString& aSource )
+        throw( IO_ERROR, PARSE_ERROR, FUTURE_FORMAT_ERROR );
+
     void parseHeader() throw( IO_ERROR, PARSE_ERROR );
     void parseGeneralSection() throw( IO_ERROR, PARSE_ERROR );
     void parsePAGE_INFO() throw( IO_ERROR, PARSE_ERROR );
@@ -83,6 +83,7 @@ PCB_PLOT_PARAMS::PCB_PLOT_PARAMS()
     m_useGerberAttributes        = false;
     m_includeGerberNetlistInfo   = false;
     m_gerberPrecision            = gbrDefaultPrecision;
+    m_useGerberCompactOutput     = false;
     m_excludeEdgeLayer           = true;
     m_lineWidth                  = g_DrawDefaultLineThickness;
     m_plotFrameRef               = false;
@@ -161,6 +162,11 @@ void PCB_PLOT_PARAMS::Format( OUTPUTFORMATTER* aFormatter,
         aFormatter->Print( aNestLevel+1, "(%s %d)\n",
                            getTokenName( T_gerberprecision ), m_gerberPrecision );
 
+    if( m_useGerberCompactOutput )  // save this option only if active,
+                                    // to avoid incompatibility with older Pcbnew version
+        aFormatter->Print( aNestLevel+1, "(%s %s)\n",
+                           getTokenName( T_usegerbercompactoutput ), trueStr );
+
     aFormatter->Print( aNestLevel+1, "(%s %s)\n", getTokenName( T_excludeedgelayer ),
                        m_excludeEdgeLayer ? trueStr : falseStr );
     aFormatter->Print( aNestLevel+1, "(%s %f)\n", getTokenName( T_linewidth ),
@@ -232,6 +238,8 @@ bool PCB_PLOT_PARAMS::operator==( const PCB_PLOT_PARAMS &aPcbPlotParams ) const
         return false;
     if( m_gerberPrecision != aPcbPlotParams.m_gerberPrecision )
         return false;
+    if( m_useGerberCompactOutput != aPcbPlotParams.m_useGerberCompactOutput )
+        return false;
     if( m_excludeEdgeLayer != aPcbPlotParams.m_excludeEdgeLayer )
         return false;
     if( m_lineWidth != aPcbPlotParams.m_lineWidth )
@@ -401,6 +409,10 @@ void PCB_PLOT_PARAMS_PARSER::Parse( PCB_PLOT_PARAMS* aPcbPlotParams )
                 parseInt( gbrDefaultPrecision-1, gbrDefaultPrecision);
             break;
 
+        case T_usegerbercompactoutput:
+            aPcbPlotParams->m_useGerberCompactOutput = parseBool();
+            break;
+
         case T_psa4output:
             aPcbPlotParams->m_A4Output = parseBool();
             break;
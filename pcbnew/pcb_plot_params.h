@@ -106,6 +106,10 @@ private:
     /// 5 is the minimal value for professional boards.
     int         m_gerberPrecision;
 
+    /// Write compact Gerber files: flash rotated, rounded and trapezoidal pads
+    /// with aperture macros, and plot each zone as a single region
+    bool        m_useGerberCompactOutput;
+
     /// Plot gerbers using auxiliary (drill) origin instead of page coordinates
     bool        m_useAuxOrigin;
 
@@ -240,6 +244,9 @@ public:
     void        SetUseGerberProtelExtensions( bool aUse ) { m_useGerberProtelExtensions = aUse; }
     bool        GetUseGerberProtelExtensions() const { return m_useGerberProtelExtensions; }
 
+    void        SetUseGerberCompactOutput( bool aUse ) { m_useGerberCompactOutput = aUse; }
+    bool        GetUseGerberCompactOutput() const { return m_useGerberCompactOutput; }
+
     void        SetGerberPrecision( int aPrecision );
     int         GetGerberPrecision() const { return m_gerberPrecision; }
 
@@ -44,6 +44,8 @@
 #include <macros.h>
 #include <build_version.h>
 
+#include <algorithm>
+
 
 const wxString GetGerberProtelExtension( LAYER_NUM aLayer )
 {
@@ -422,31 +424,41 @@ bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
 
     // Now compute the full filename for the output and start the plot
     // (after ensuring the output directory is OK)
+    if( buildPlotFileName( aSuffix, aFormat, GetLayer() ) )
+    {
+        m_plotter = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( GetLayer() ),
+                                    m_plotFile.GetFullPath(), aSheetDesc );
+    }
+
+    return( m_plotter != NULL );
+}
+
+
+bool PLOT_CONTROLLER::buildPlotFileName( const wxString& aSuffix, PlotFormat aFormat,
+                                         LAYER_NUM aLayer )
+{
     wxString outputDirName = GetPlotOptions().GetOutputDirectory() ;
     wxFileName outputDir = wxFileName::DirName( outputDirName );
     wxString boardFilename = m_board->GetFileName();
 
-    if( EnsureFileDirectoryExists( &outputDir, boardFilename ) )
-    {
-        // outputDir contains now the full path of plot files
-        m_plotFile = boardFilename;
-        m_plotFile.SetPath( outputDir.GetPath() );
-        wxString fileExt = GetDefaultPlotExtension( aFormat );
+    if( !EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+        return false;
 
-        // Gerber format can use specific file ext, depending on layers
-        // (now not a good practice, because the official file ext is .gbr)
-        if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
-            GetPlotOptions().GetUseGerberProtelExtensions() )
-            fileExt = GetGerberProtelExtension( GetLayer() );
+    // outputDir contains now the full path of plot files
+    m_plotFile = boardFilename;
+    m_plotFile.SetPath( outputDir.GetPath() );
+    wxString fileExt = GetDefaultPlotExtension( aFormat );
 
-        // Build plot filenames from the board name and layer names:
-        BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
+    // Gerber format can use specific file ext, depending on layers
+    // (now not a good practice, because the official file ext is .gbr)
+    if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
+        GetPlotOptions().GetUseGerberProtelExtensions() )
+        fileExt = GetGerberProtelExtension( aLayer );
 
-        m_plotter = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( GetLayer() ),
-                                    m_plotFile.GetFullPath(), aSheetDesc );
-    }
+    // Build plot filenames from the board name and layer names:
+    BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
 
-    return( m_plotter != NULL );
+    return true;
 }
 
 
@@ -465,6 +477,54 @@ bool PLOT_CONTROLLER::PlotLayer()
 }
 
 
+bool PLOT_CONTROLLER::PlotLayers( const std::vector<int>& aLayers,
+                                  const wxArrayString&    aSuffixes,
+                                  PlotFormat              aFormat,
+                                  const wxString&         aSheetDesc )
+{
+    wxASSERT( aLayers.size() == aSuffixes.GetCount() );
+
+    LOCALE_IO toggle;
+
+    GetPlotOptions().SetFormat( aFormat );
+
+    // Ensure that the previous plot is closed
+    ClosePlot();
+
+    const int count = std::min( aLayers.size(), aSuffixes.GetCount() );
+    std::vector<PLOTTER*> plotters( count, (PLOTTER*) NULL );
+    bool success = true;
+
+    // Opening the plot files is cheap, and it updates the board (its
+    // bounding box is cached), so it is done before going parallel
+    for( int ii = 0; ii < count; ++ii )
+    {
+        if( buildPlotFileName( aSuffixes[ii], aFormat, aLayers[ii] ) )
+            plotters[ii] = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( aLayers[ii] ),
+                                           m_plotFile.GetFullPath(), aSheetDesc );
+
+        if( !plotters[ii] )
+            success = false;
+    }
+
+    // Each layer has its own plotter and file, and only reads the board.
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for( int ii = 0; ii < count; ++ii )
+    {
+        if( !plotters[ii] )
+            continue;
+
+        PlotOneBoardLayer( m_board, plotters[ii], ToLAYER_ID( aLayers[ii] ), GetPlotOptions() );
+        plotters[ii]->EndPlot();
+        delete plotters[ii];
+    }
+
+    return success;
+}
+
+
 void PLOT_CONTROLLER::SetColorMode( bool aColorMode )
 {
     if( !m_plotter )
@@ -37,6 +37,7 @@
 #include <trigo.h>
 #include <wxBasePcbFrame.h>
 #include <macros.h>
+#include <memory>
 
 #include <class_board.h>
 #include <class_module.h>
@@ -376,16 +377,25 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             if( pad->GetLayerSet()[F_Cu] )
                 color = ColorFromInt( color | aBoard->GetVisibleElementColor( PAD_FR_VISIBLE ) );
 
-            // Temporary set the pad size to the required plot size:
-            wxSize tmppadsize = pad->GetSize();
-            pad->SetSize( padPlotsSize );
-            switch( pad->GetShape() )
+            // Plot a copy of the pad at the required plot size: the board
+            // is not modified, so several layers can be plotted at once
+            D_PAD* plotPad = pad;
+            std::unique_ptr<D_PAD> resizedPad;
+
+            if( padPlotsSize != pad->GetSize() )
+            {
+                resizedPad.reset( new D_PAD( *pad ) );
+                resizedPad->SetSize( padPlotsSize );
+                plotPad = resizedPad.get();
+            }
+
+            switch( plotPad->GetShape() )
             {
             case PAD_SHAPE_CIRCLE:
             case PAD_SHAPE_OVAL:
                 if( aPlotOpt.GetSkipPlotNPTH_Pads() &&
-                    (pad->GetSize() == pad->GetDrillSize()) &&
-                    (pad->GetAttribute() == PAD_ATTRIB_HOLE_NOT_PLATED) )
+                    (plotPad->GetSize() == plotPad->GetDrillSize()) &&
+                    (plotPad->GetAttribute() == PAD_ATTRIB_HOLE_NOT_PLATED) )
                     break;
 
                 // Fall through:
@@ -393,11 +403,9 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             case PAD_SHAPE_RECT:
             case PAD_SHAPE_ROUNDRECT:
             default:
-                itemplotter.PlotPad( pad, color, plotMode );
+                itemplotter.PlotPad( plotPad, color, plotMode );
                 break;
             }
-
-            pad->SetSize( tmppadsize );     // Restore the pad size
         }
 
         aPlotter->EndBlock( NULL );
@@ -1031,6 +1039,9 @@ PLOTTER* StartPlotBoard( BOARD *aBoard, PCB_PLOT_PARAMS *aPlotOpts,
             else
                 plotter->AddLineToHeader( GetGerberFileFunctionAttribute(
                                                 aBoard, aLayer, true ) );
+
+            static_cast<GERBER_PLOTTER*>( plotter )->UseCompactOutput(
+                                                plotOpts.GetUseGerberCompactOutput() );
         }
 
         plotter->StartPlot();
@@ -634,12 +634,21 @@ void BRDITEMS_PLOTTER::PlotFilledAreas( ZONE_CONTAINER* aZone )
         }
     }
 
-    // We need a buffer to store corners coordinates:
-    static std::vector< wxPoint > cornerList;
-    cornerList.clear();
-
     m_plotter->SetColor( getColor( aZone->GetLayer() ) );
 
+    // Compact Gerber output: all the filled areas of the zone in a single region
+    if( GetPlotMode() == FILLED && aZone->GetFillMode() == 0
+        && m_plotter->GetPlotterType() == PLOT_FORMAT_GERBER
+        && static_cast<GERBER_PLOTTER*>( m_plotter )->GetCompactOutput() )
+    {
+        static_cast<GERBER_PLOTTER*>( m_plotter )->PlotRegions( polysList,
+                                                aZone->GetMinThickness(), &gbr_metadata );
+        return;
+    }
+
+    // We need a buffer to store corners coordinates:
+    std::vector< wxPoint > cornerList;
+
     /* Plot all filled areas: filled areas have a filled area and a thick
      * outline we must plot the filled area itself ( as a filled polygon
      * OR a set of segments ) and plot the thick outline itself
@@ -30,6 +30,7 @@
 #ifndef PLOTCONTROLLER_H_
 #define PLOTCONTROLLER_H_
 
+#include <vector>
 #include <pcb_plot_params.h>
 #include <layers_id_colors_and_visibility.h>
 
@@ -84,6 +85,21 @@ public:
      */
     bool PlotLayer();
 
+    /** Plot a list of layers, each one in its own plotfile, as OpenPlotfile
+     * and PlotLayer would do for each of them, but concurrently. The layers
+     * only read the board, so a full set of fabrication files takes about
+     * the time of its slowest layer.
+     * The current plot is closed first, and the plot files are closed on
+     * return; GetPlotFileName() then returns the last one.
+     * @param aLayers is the list of layers to plot
+     * @param aSuffixes is the string added to the base filename of each layer
+     * @param aFormat is the plot file format identifier
+     * @param aSheetDesc is the sheet description of the frame reference
+     * @return true if every layer was plotted
+     */
+    bool PlotLayers( const std::vector<int>& aLayers, const wxArrayString& aSuffixes,
+                     PlotFormat aFormat, const wxString& aSheetDesc );
+
     /**
      * @return the current plot full filename, set by OpenPlotfile
      */
@@ -108,6 +124,12 @@ public:
     bool GetColorMode();
 
 private:
+    /** Build the full filename of the plot of aLayer in m_plotFile, after
+     * ensuring the output directory exists
+     * @return false if the output directory cannot be created
+     */
+    bool buildPlotFileName( const wxString& aSuffix, PlotFormat aFormat, LAYER_NUM aLayer );
+
     /// the layer to plot
     LAYER_NUM m_plotLayer;
 
@@ -38,6 +38,9 @@
 #include <io_mgr.h>
 #include <macros.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <wx/image.h>
+#include <3d_rendering/3d_render_raytracing/c3d_render_raytracing.h>
 
 static PCB_EDIT_FRAME* PcbEditFrame = NULL;
 
@@ -107,3 +110,62 @@ bool SaveBoard( wxString& aFileName, BOARD* aBoard,
 #endif
     return true;
 }
+
+
+wxString RenderBoardRaytracing( BOARD* aBoard, wxString& aFileName,
+                                int aWidth, int aHeight, int aPasses )
+{
+    CINFO3D_VISU settings;
+
+    settings.SetBoard( aBoard );
+    settings.RenderEngineSet( RENDER_ENGINE_RAYTRACING );
+
+    // Use the default options of the 3D viewer
+    settings.SetFlag( FL_RENDER_SHOW_HOLES_IN_ZONES, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_SHADOWS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_BACKFLOOR, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_REFRACTIONS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_REFLECTIONS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING, true );
+
+    C3D_RENDER_RAYTRACING renderer( settings );
+    renderer.ReloadRequest();
+
+    wxImage  image;
+    wxString report;
+
+    for( int pass = 0; pass < std::max( aPasses, 1 ); ++pass )
+    {
+        RT_RENDER_STATS stats;
+
+        renderer.RenderOffscreen( wxSize( aWidth, aHeight ), image, &stats );
+
+        if( pass == 0 )
+        {
+            report += wxString::Format( wxT( "Scene build: %.3f ms\n" ),
+                                        stats.m_reloadTime / 1000.0 );
+            report += wxString::Format( wxT( "Accelerator construction: %.3f ms\n" ),
+                                        stats.m_acceleratorTime / 1000.0 );
+        }
+
+        const double tracingTime = stats.m_tracingTime / 1e6;
+        const double nrPrimaryRays = (double) image.GetWidth() * image.GetHeight();
+
+        report += wxString::Format( wxT( "Pass %d: tracing %.3f ms (%.3f Mrays/s primary), "
+                                         "post processing %.3f ms + %.3f ms\n" ),
+                                    pass + 1,
+                                    stats.m_tracingTime / 1000.0,
+                                    tracingTime > 0.0 ? nrPrimaryRays / tracingTime / 1e6 : 0.0,
+                                    stats.m_postProcessShadeTime / 1000.0,
+                                    stats.m_postProcessBlurTime / 1000.0 );
+    }
+
+    if( !wxImage::FindHandler( wxBITMAP_TYPE_PNG ) )
+        wxImage::AddHandler( new wxPNGHandler );
+
+    if( !image.SaveFile( aFileName, wxBITMAP_TYPE_PNG ) )
+        return wxEmptyString;
+
+    return report;
+}
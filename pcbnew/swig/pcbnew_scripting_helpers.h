@@ -43,5 +43,21 @@ BOARD*  LoadBoard( wxString& aFileName );
 bool    SaveBoard( wxString& aFileName, BOARD* aBoard, IO_MGR::PCB_FILE_T aFormat );
 bool    SaveBoard( wxString& aFileName, BOARD* aBoard );
 
+/**
+ * Function RenderBoardRaytracing
+ * renders a board with the raytracing engine of the 3D viewer, without any
+ * window or OpenGL context, and saves the image as a PNG file.
+ * The 3D models of the footprints are not rendered.
+ * @param aBoard = the board to render
+ * @param aFileName = the PNG file to create
+ * @param aWidth = the width of the render window
+ * @param aHeight = the height of the render window
+ * @param aPasses = the number of times the image is rendered, to measure the trace time
+ * @return the scene build and render times, one per line, or an empty string
+ * if the image cannot be saved
+ */
+wxString RenderBoardRaytracing( BOARD* aBoard, wxString& aFileName,
+                                int aWidth, int aHeight, int aPasses = 1 );
+
 
 #endif
@@ -488,12 +488,15 @@ int PCB_EDITOR_CONTROL::ZoneFill( const TOOL_EVENT& aEvent )
     const SELECTION& selection = selTool->GetSelection();
     RN_DATA* ratsnest = getModel<BOARD>()->GetRatsnest();
 
+    // The anchor points used to find insulated islands are shared by all the zones
+    ZONE_ANCHOR_POINTS anchors( getModel<BOARD>() );
+
     for( int i = 0; i < selection.Size(); ++i )
     {
         assert( selection.Item<BOARD_ITEM>( i )->Type() == PCB_ZONE_AREA_T );
 
         ZONE_CONTAINER* zone = selection.Item<ZONE_CONTAINER>( i );
-        m_frame->Fill_Zone( zone );
+        m_frame->Fill_Zone( zone, &anchors );
         zone->SetIsFilled( true );
         ratsnest->Update( zone );
         zone->ViewUpdate();
@@ -510,10 +513,13 @@ int PCB_EDITOR_CONTROL::ZoneFillAll( const TOOL_EVENT& aEvent )
     BOARD* board = getModel<BOARD>();
     RN_DATA* ratsnest = board->GetRatsnest();
 
+    // The anchor points used to find insulated islands are shared by all the zones
+    ZONE_ANCHOR_POINTS anchors( board );
+
     for( int i = 0; i < board->GetAreaCount(); ++i )
     {
         ZONE_CONTAINER* zone = board->GetArea( i );
-        m_frame->Fill_Zone( zone );
+        m_frame->Fill_Zone( zone, &anchors );
         zone->SetIsFilled( true );
         ratsnest->Update( zone );
         zone->ViewUpdate();
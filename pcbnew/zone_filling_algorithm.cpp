@@ -55,7 +55,8 @@
  * to add holes for pads and tracks and other items not in net.
  */
 
-bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer )
+bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer,
+                                                    const ZONE_ANCHOR_POINTS* aAnchors )
 {
     /* convert outlines + holes to outlines without holes (adding extra segments if necessary)
      * m_Poly data is expected normalized, i.e. NormalizeAreaOutlines was used after building
@@ -106,7 +107,7 @@ bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET*
 
         if( IsOnCopperLayer() )
         {
-            AddClearanceAreasPolygonsToPolysList_NG( aPcb );
+            AddClearanceAreasPolygonsToPolysList_NG( aPcb, aAnchors );
 
             if( m_FillMode )   // if fill mode uses segments, create them:
             {
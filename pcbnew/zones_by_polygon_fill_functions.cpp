@@ -87,7 +87,7 @@ void PCB_EDIT_FRAME::Delete_OldZone_Fill( SEGZONE* aZone, time_t aTimestamp )
 }
 
 
-int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
+int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone, const ZONE_ANCHOR_POINTS* aAnchors )
 {
     aZone->ClearFilledPolysList();
     aZone->UnFill();
@@ -114,7 +114,7 @@ int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
 
     wxBusyCursor dummy;     // Shows an hourglass cursor (removed by its destructor)
 
-    aZone->BuildFilledSolidAreasPolygons( GetBoard() );
+    aZone->BuildFilledSolidAreasPolygons( GetBoard(), NULL, aAnchors );
     aZone->ViewUpdate( KIGFX::VIEW_ITEM::ALL );
     GetBoard()->GetRatsnest()->Update( aZone );
 
@@ -148,6 +148,10 @@ int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
     // Remove segment zones
     GetBoard()->m_Zone.DeleteAll();
 
+    // Pads and tracks are not modified while filling: the anchor points
+    // used to find insulated islands are shared by all the zones
+    ZONE_ANCHOR_POINTS anchors( GetBoard() );
+
     int ii;
 
     for( ii = 0; ii < areaCount; ii++ )
@@ -164,7 +168,7 @@ int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
                 break;  // Aborted by user
         }
 
-        errorLevel = Fill_Zone( zoneContainer );
+        errorLevel = Fill_Zone( zoneContainer, &anchors );
 
         if( errorLevel && !aVerbose )
             break;
@@ -406,7 +406,8 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
  *     Remove new insulated copper islands
  */
 
-void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
+void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb,
+                                                              const ZONE_ANCHOR_POINTS* aAnchors )
 {
     int segsPerCircle;
     double correctionFactor;
@@ -470,7 +471,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
 
     // Remove insulated islands:
     if( GetNetCode() > 0 )
-        TestForCopperIslandAndRemoveInsulatedIslands( aPcb );
+        TestForCopperIslandAndRemoveInsulatedIslands( aPcb, aAnchors );
 
     SHAPE_POLY_SET thermalHoles;
 
@@ -500,7 +501,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
         m_FilledPolysList = th_fractured;
 
         if( GetNetCode() > 0 )
-            TestForCopperIslandAndRemoveInsulatedIslands( aPcb );
+            TestForCopperIslandAndRemoveInsulatedIslands( aPcb, aAnchors );
     }
 
     if(g_DumpZonesWhenFilling)
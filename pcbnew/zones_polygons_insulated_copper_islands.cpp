@@ -37,61 +37,98 @@
 #include <zones.h>
 #include <polygon_test_point_inside.h>
 
+#include <algorithm>
+#include <memory>
 
-void ZONE_CONTAINER::TestForCopperIslandAndRemoveInsulatedIslands( BOARD* aPcb )
+
+static bool sortByY( const VECTOR2I& aA, const VECTOR2I& aB )
 {
-    if( m_FilledPolysList.IsEmpty() )
-        return;
+    return aA.y < aB.y;
+}
 
-    // Build a list of points connected to the net:
-    // list of coordinates of pads and vias on this layer and on this net.
-    std::vector <wxPoint> listPointsCandidates;
 
+ZONE_ANCHOR_POINTS::ZONE_ANCHOR_POINTS( BOARD* aPcb )
+{
+    // Pads are anchors on each copper layer they are on
     for( MODULE* module = aPcb->m_Modules; module; module = module->Next() )
     {
         for( D_PAD* pad = module->Pads(); pad != NULL; pad = pad->Next() )
         {
-            if( !pad->IsOnLayer( GetLayer() ) )
-                continue;
+            const wxPoint& pos = pad->GetPosition();
+            LSET layers = pad->GetLayerSet() & LSET::AllCuMask();
 
-            if( pad->GetNetCode() != GetNetCode() )
-                continue;
-
-            listPointsCandidates.push_back( pad->GetPosition() );
+            for( LSEQ seq = layers.Seq();  seq;  ++seq )
+                m_points[KEY( pad->GetNetCode(), *seq )].push_back( VECTOR2I( pos.x, pos.y ) );
         }
     }
 
+    // Tracks are anchors by both ends, vias by their position on each layer they connect
     for( TRACK* track = aPcb->m_Track; track; track = track->Next() )
     {
-        if( !track->IsOnLayer( GetLayer() ) )
-            continue;
+        const wxPoint& start = track->GetStart();
 
-        if( track->GetNetCode() != GetNetCode() )
-            continue;
+        if( track->Type() == PCB_VIA_T )
+        {
+            for( LSEQ seq = LSET::AllCuMask().Seq();  seq;  ++seq )
+            {
+                if( track->IsOnLayer( *seq ) )
+                    m_points[KEY( track->GetNetCode(), *seq )].push_back(
+                            VECTOR2I( start.x, start.y ) );
+            }
+        }
+        else
+        {
+            std::vector<VECTOR2I>& points = m_points[KEY( track->GetNetCode(),
+                                                          track->GetLayer() )];
+            const wxPoint& end = track->GetEnd();
 
-        listPointsCandidates.push_back( track->GetStart() );
+            points.push_back( VECTOR2I( start.x, start.y ) );
+            points.push_back( VECTOR2I( end.x, end.y ) );
+        }
+    }
 
-        if( track->Type() != PCB_VIA_T )
-            listPointsCandidates.push_back( track->GetEnd() );
+    for( std::map< KEY, std::vector<VECTOR2I> >::iterator it = m_points.begin();
+         it != m_points.end(); ++it )
+    {
+        std::sort( it->second.begin(), it->second.end(), sortByY );
     }
+}
 
-    // test if a point is inside
 
-    for( int outline = 0; outline < m_FilledPolysList.OutlineCount(); outline++ )
+const std::vector<VECTOR2I>* ZONE_ANCHOR_POINTS::GetPoints( int aNetCode, LAYER_ID aLayer ) const
+{
+    std::map< KEY, std::vector<VECTOR2I> >::const_iterator it =
+            m_points.find( KEY( aNetCode, aLayer ) );
+
+    if( it == m_points.end() )
+        return NULL;
+
+    return &it->second;
+}
+
+
+void ZONE_CONTAINER::TestForCopperIslandAndRemoveInsulatedIslands( BOARD* aPcb,
+                                                                   const ZONE_ANCHOR_POINTS* aAnchors )
+{
+    if( m_FilledPolysList.IsEmpty() )
+        return;
+
+    // Build the list of points connected to the net, if not given by the caller:
+    // coordinates of pads, track ends and vias on this layer and on this net.
+    std::unique_ptr<ZONE_ANCHOR_POINTS> localAnchors;
+
+    if( !aAnchors )
     {
-        bool connected = false;
+        localAnchors.reset( new ZONE_ANCHOR_POINTS( aPcb ) );
+        aAnchors = localAnchors.get();
+    }
 
-        for( unsigned ic = 0; ic < listPointsCandidates.size(); ic++ )
-        {
-            // test if this area is connected to a board item:
-            wxPoint pos = listPointsCandidates[ic];
+    const std::vector<VECTOR2I>* candidates = aAnchors->GetPoints( GetNetCode(), GetLayer() );
 
-            if( m_FilledPolysList.Contains( VECTOR2I( pos.x, pos.y ), outline ) )
-            {
-                connected = true;
-                break;
-            }
-        }
+    // test if an outline contains at least one of these points
+    for( int outline = 0; outline < m_FilledPolysList.OutlineCount(); outline++ )
+    {
+        bool connected = candidates && m_FilledPolysList.ContainsAny( *candidates, outline );
 
         if( !connected )                 // this polygon is connected: analyse next polygon
         {
@@ -43,6 +43,8 @@
 #include <drc_stuff.h>
 #include <math_for_graphics.h>
 
+#include <memory>
+
 #define STRAIGHT 0      // To be remove after math_for_graphics code cleanup
 
 
@@ -64,9 +66,21 @@ bool BOARD::OnAreaPolygonModified( PICKED_ITEMS_LIST* aModifiedZonesList,
 
     if( !IsCopperLayer( layer ) )       // Refill non copper zones on this layer
     {
+        // The anchor points are shared by the zones, and only built if a zone needs them
+        std::unique_ptr<ZONE_ANCHOR_POINTS> anchors;
+
         for( unsigned ia = 0; ia < m_ZoneDescriptorList.size(); ia++ )
-            if( m_ZoneDescriptorList[ia]->GetLayer() == layer )
-                m_ZoneDescriptorList[ia]->BuildFilledSolidAreasPolygons( this );
+        {
+            ZONE_CONTAINER* zone = m_ZoneDescriptorList[ia];
+
+            if( zone->GetLayer() != layer )
+                continue;
+
+            if( !anchors && zone->IsOnCopperLayer() )
+                anchors.reset( new ZONE_ANCHOR_POINTS( this ) );
+
+            zone->BuildFilledSolidAreasPolygons( this, NULL, anchors.get() );
+        }
     }
 
     // Test for bad areas: all zones must have more than 2 corners:
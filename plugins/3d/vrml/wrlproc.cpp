@@ -23,6 +23,10 @@
 
 #include <iostream>
 #include <sstream>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <wx/filename.h>
 #include <wx/string.h>
 #include <wx/log.h>
@@ -45,6 +49,164 @@
         m_buf.clear(); \
     } } while( 0 )
 
+// size of the stack buffer used to hand a number to strtof(); longer
+// numbers (only seen in pathological files) fall back to a std::string
+#define NUMBUF_SIZE 64
+
+
+/*
+ * The numeric scanners below convert a glob directly from the line buffer
+ * and reproduce the results of the former std::istringstream conversion
+ * bit for bit:
+ *
+ *  - the characters accepted are those std::num_get accepts in the "C" locale;
+ *    the accepted text is converted with strtof() like std::num_get does
+ *  - an empty glob leaves the value unchanged: the stream sentry failed
+ *    before any conversion
+ *  - a failed extraction yields 0 and is not an error, since the former code
+ *    never looked at the stream state; out of range values are clamped
+ *  - the glob is invalid when characters remain after a successful extraction
+ *
+ * The return value is false only in the last case.
+ */
+static bool convertFloat( const char* aStart, const char* aEnd, float& aValue )
+{
+    if( aStart == aEnd )
+        return true;
+
+    const char* cp = aStart;
+
+    if( cp < aEnd && ( '+' == *cp || '-' == *cp ) )
+        ++cp;
+
+    bool found_mantissa = false;
+    bool found_dec = false;
+    bool found_sci = false;
+
+    while( cp < aEnd )
+    {
+        if( *cp >= '0' && *cp <= '9' )
+        {
+            found_mantissa = true;
+        }
+        else if( '.' == *cp && !found_dec && !found_sci )
+        {
+            found_dec = true;
+        }
+        else if( ( 'e' == *cp || 'E' == *cp ) && !found_sci && found_mantissa )
+        {
+            found_sci = true;
+
+            if( cp + 1 < aEnd && ( '+' == cp[1] || '-' == cp[1] ) )
+                ++cp;
+        }
+        else
+        {
+            break;
+        }
+
+        ++cp;
+    }
+
+    size_t nchars = cp - aStart;
+    char numbuf[NUMBUF_SIZE];
+    std::string longnum;
+    const char* num;
+
+    if( nchars < NUMBUF_SIZE )
+    {
+        memcpy( numbuf, aStart, nchars );
+        numbuf[nchars] = 0;
+        num = numbuf;
+    }
+    else
+    {
+        longnum.assign( aStart, nchars );
+        num = longnum.c_str();
+    }
+
+    char* numend;
+    aValue = strtof( num, &numend );
+
+    if( numend == num || *numend != 0 )
+    {
+        aValue = 0.0;
+        return true;
+    }
+
+    if( aValue == std::numeric_limits<float>::infinity() )
+    {
+        aValue = std::numeric_limits<float>::max();
+        return true;
+    }
+
+    if( aValue == -std::numeric_limits<float>::infinity() )
+    {
+        aValue = -std::numeric_limits<float>::max();
+        return true;
+    }
+
+    return cp == aEnd;
+}
+
+
+static bool convertInt( const char* aStart, const char* aEnd, int& aValue )
+{
+    if( aStart == aEnd )
+        return true;
+
+    const char* cp = aStart;
+    bool negative = false;
+
+    if( cp < aEnd && ( '+' == *cp || '-' == *cp ) )
+    {
+        negative = ( '-' == *cp );
+        ++cp;
+    }
+
+    // the magnitude saturates just above the int range
+    const unsigned long long limit = (unsigned long long) INT_MAX + 2;
+    unsigned long long magnitude = 0;
+    const char* digits = cp;
+
+    while( cp < aEnd && *cp >= '0' && *cp <= '9' )
+    {
+        if( magnitude < limit )
+            magnitude = magnitude * 10 + ( *cp - '0' );
+
+        ++cp;
+    }
+
+    if( cp == digits )
+    {
+        aValue = 0;
+        return true;
+    }
+
+    if( negative )
+    {
+        if( magnitude > (unsigned long long) INT_MAX + 1 )
+        {
+            aValue = INT_MIN;
+            return true;
+        }
+
+        aValue = (int) -(long long) magnitude;
+    }
+    else
+    {
+        if( magnitude > (unsigned long long) INT_MAX )
+        {
+            aValue = INT_MAX;
+            return true;
+        }
+
+        aValue = (int) magnitude;
+    }
+
+    return cp == aEnd;
+}
+
 
 WRLPROC::WRLPROC( LINE_READER* aLineReader )
 {
@@ -237,6 +399,22 @@ bool WRLPROC::ReadGlob( std::string& aGlob )
 {
     aGlob.clear();
 
+    size_t start;
+    size_t end;
+
+    if( !getGlob( start, end ) )
+        return false;
+
+    aGlob.assign( m_buf, start, end - start );
+    return true;
+}
+
+
+bool WRLPROC::getGlob( size_t& aStart, size_t& aEnd )
+{
+    aStart = 0;
+    aEnd = 0;
+
     if( !m_file )
     {
         m_error = "no open file";
@@ -256,23 +434,25 @@ bool WRLPROC::ReadGlob( std::string& aGlob )
     }
 
     size_t ssize = m_buf.size();
+    aStart = m_bufpos;
 
     while( m_bufpos < ssize && m_buf[m_bufpos] > 0x20 )
     {
         if( ',' == m_buf[m_bufpos] )
         {
             // the comma is a special instance of blank space
-            ++m_bufpos;
+            aEnd = m_bufpos++;
             return true;
         }
 
         if( '{' == m_buf[m_bufpos] || '}' == m_buf[m_bufpos]
             || '[' == m_buf[m_bufpos] || ']' == m_buf[m_bufpos] )
-            return true;
+            break;
 
-        aGlob.append( 1, m_buf[m_bufpos++] );
+        ++m_bufpos;
     }
 
+    aEnd = m_bufpos;
     return true;
 }
 
@@ -811,9 +991,10 @@ bool WRLPROC::ReadSFFloat( float& aSFFloat )
             break;
     }
 
-    std::string tmp;
+    size_t gstart;
+    size_t gend;
 
-    if( !ReadGlob( tmp ) )
+    if( !getGlob( gstart, gend ) )
     {
         std::ostringstream ostr;
         ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -826,14 +1007,9 @@ bool WRLPROC::ReadSFFloat( float& aSFFloat )
         return false;
     }
 
-    std::istringstream istr;
-    istr.str( tmp );
+    const char* gp = m_buf.c_str();
 
-    istr >> aSFFloat;
-    tmp.clear();
-    istr >> tmp;
-
-    if( !tmp.empty() )
+    if( !convertFloat( gp + gstart, gp + gend, aSFFloat ) )
     {
         std::ostringstream ostr;
         ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -874,9 +1050,10 @@ bool WRLPROC::ReadSFInt( int& aSFInt32 )
             break;
     }
 
-    std::string tmp;
+    size_t gstart;
+    size_t gend;
 
-    if( !ReadGlob( tmp ) )
+    if( !getGlob( gstart, gend ) )
     {
         std::ostringstream ostr;
         ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -889,24 +1066,22 @@ bool WRLPROC::ReadSFInt( int& aSFInt32 )
         return false;
     }
 
-    if( std::string::npos != tmp.find( "0x" ) )
+    const char* gp = m_buf.c_str();
+
+    for( size_t i = gstart; i + 1 < gend; ++i )
     {
-        // Rules: "0x" + "0-9, A-F" - VRML is case sensitive but in
-        // this instance we do no enforce case.
-        std::stringstream sstr;
-        sstr << std::hex << tmp;
-        sstr >> aSFInt32;
-        return true;
+        if( '0' == gp[i] && 'x' == gp[i + 1] )
+        {
+            // Rules: "0x" + "0-9, A-F" - VRML is case sensitive but in
+            // this instance we do no enforce case.
+            std::stringstream sstr;
+            sstr << std::hex << m_buf.substr( gstart, gend - gstart );
+            sstr >> aSFInt32;
+            return true;
+        }
     }
 
-    std::istringstream istr;
-    istr.str( tmp );
-
-    istr >> aSFInt32;
-    tmp.clear();
-    istr >> tmp;
-
-    if( !tmp.empty() )
+    if( !convertInt( gp + gstart, gp + gend, aSFInt32 ) )
     {
         std::ostringstream ostr;
         ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -951,12 +1126,13 @@ bool WRLPROC::ReadSFRotation( WRLROTATION& aSFRotation )
             break;
     }
 
-    std::string tmp;
+    size_t gstart;
+    size_t gend;
     float trot[4];
 
     for( int i = 0; i < 4; ++i )
     {
-        if( !ReadGlob( tmp ) )
+        if( !getGlob( gstart, gend ) )
         {
             std::ostringstream ostr;
             ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -969,14 +1145,9 @@ bool WRLPROC::ReadSFRotation( WRLROTATION& aSFRotation )
             return false;
         }
 
-        std::istringstream istr;
-        istr.str( tmp );
-
-        istr >> trot[i];
-        tmp.clear();
-        istr >> tmp;
+        const char* gp = m_buf.c_str();
 
-        if( !tmp.empty() )
+        if( !convertFloat( gp + gstart, gp + gend, trot[i] ) )
         {
             std::ostringstream ostr;
             ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -1026,13 +1197,14 @@ bool WRLPROC::ReadSFVec2f( WRLVEC2F& aSFVec2f )
             break;
     }
 
-    std::string tmp;
+    size_t gstart;
+    size_t gend;
 
     float tcol[2];
 
     for( int i = 0; i < 2; ++i )
     {
-        if( !ReadGlob( tmp ) )
+        if( !getGlob( gstart, gend ) )
         {
             std::ostringstream ostr;
             ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -1045,14 +1217,9 @@ bool WRLPROC::ReadSFVec2f( WRLVEC2F& aSFVec2f )
             return false;
         }
 
-        std::istringstream istr;
-        istr.str( tmp );
-
-        istr >> tcol[i];
-        tmp.clear();
-        istr >> tmp;
+        const char* gp = m_buf.c_str();
 
-        if( !tmp.empty() )
+        if( !convertFloat( gp + gstart, gp + gend, tcol[i] ) )
         {
             std::ostringstream ostr;
             ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -1101,13 +1268,14 @@ bool WRLPROC::ReadSFVec3f( WRLVEC3F& aSFVec3f )
             break;
     }
 
-    std::string tmp;
+    size_t gstart;
+    size_t gend;
 
     float tcol[3];
 
     for( int i = 0; i < 3; ++i )
     {
-        if( !ReadGlob( tmp ) )
+        if( !getGlob( gstart, gend ) )
         {
             std::ostringstream ostr;
             ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
@@ -1120,6 +1288,10 @@ bool WRLPROC::ReadSFVec3f( WRLVEC3F& aSFVec3f )
             return false;
         }
 
+        // convert the glob now since EatSpace() may replace the line buffer
+        const char* gp = m_buf.c_str();
+        bool valid = convertFloat( gp + gstart, gp + gend, tcol[i] );
+
         // ignore any commas
         if( !EatSpace() )
             return false;
@@ -1127,14 +1299,7 @@ bool WRLPROC::ReadSFVec3f( WRLVEC3F& aSFVec3f )
         if( ',' == m_buf[m_bufpos] )
             Pop();
 
-        std::istringstream istr;
-        istr.str( tmp );
-
-        istr >> tcol[i];
-        tmp.clear();
-        istr >> tmp;
-
-        if( !tmp.empty() )
+        if( !valid )
         {
             std::ostringstream ostr;
             ostr << __FILE__ << ":" << __FUNCTION__ << ":" << __LINE__ << "\n";
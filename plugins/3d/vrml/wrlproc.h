@@ -58,6 +58,11 @@ private:
     // parameters are updated as appropriate.
     bool getRawLine( void );
 
+    // getGlob locates the next glob within m_buf without copying it; the
+    // glob is m_buf[aStart .. aEnd) and remains valid until the next line
+    // is read. The rules are those of ReadGlob.
+    bool getGlob( size_t& aStart, size_t& aEnd );
+
 public:
     WRLPROC( LINE_READER* aLineReader );
     ~WRLPROC();
@@ -0,0 +1,129 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file cimage_filter_bench.cpp
+ * @brief Measures the CIMAGE filters and copy operations used by the 3D viewer
+ * post processing, at usual viewport sizes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <profile.h>
+#include <cimage.h>
+
+
+#define BENCH_ITERATIONS    20
+
+static const int viewportSizes[][2] =
+{
+    {  640,  480 },
+    { 1280,  720 },
+    { 1920, 1080 },
+    { 2560, 1440 },
+};
+
+static const char* filterNames[] =
+{
+    "HIPASS", "GAUSSIAN_BLUR", "GAUSSIAN_BLUR2", "INVERT_BLUR", "CARTOON", "EMBOSS",
+    "SHARPEN", "MELT", "SOBEL_GX", "SOBEL_GY", "BLUR_3X3"
+};
+
+static const char* copyOpNames[] =
+{
+    "RAW", "ADD", "SUB", "DIF", "MUL", "AND", "OR", "XOR", "BLEND50", "MIN", "MAX"
+};
+
+
+static void fillImage( CIMAGE& aImage, unsigned int aSeed )
+{
+    srand( aSeed );
+
+    // A mix of noise and sharp edges, like the SSAO and the selection buffers
+    for( unsigned int y = 0; y < aImage.GetHeight(); y++ )
+        for( unsigned int x = 0; x < aImage.GetWidth(); x++ )
+        {
+            unsigned char v = ( ( x / 16 + y / 16 ) & 1 ) ? ( rand() & 0xFF ) : 0xFF;
+
+            aImage.Setpixel( x, y, v );
+        }
+}
+
+
+int main()
+{
+    printf( "%-12s %-16s %10s %10s\n", "size", "operation", "ms", "Mpixel/s" );
+
+    for( unsigned int s = 0; s < sizeof( viewportSizes ) / sizeof( viewportSizes[0] ); s++ )
+    {
+        const int w = viewportSizes[s][0];
+        const int h = viewportSizes[s][1];
+
+        CIMAGE imgA( w, h );
+        CIMAGE imgB( w, h );
+        CIMAGE imgOut( w, h );
+
+        fillImage( imgA, 1 );
+        fillImage( imgB, 2 );
+
+        char sizeName[32];
+        sprintf( sizeName, "%dx%d", w, h );
+
+        for( int f = FILTER_HIPASS; f <= FILTER_BLUR_3X3; f++ )
+        {
+            prof_counter cnt;
+
+            prof_start( &cnt );
+
+            for( int i = 0; i < BENCH_ITERATIONS; i++ )
+                imgOut.EfxFilter( &imgA, (E_FILTER) f );
+
+            prof_end( &cnt );
+
+            const double ms = cnt.msecs() / BENCH_ITERATIONS;
+
+            printf( "%-12s %-16s %10.3f %10.1f\n", sizeName, filterNames[f], ms,
+                    ( (double) w * h ) / ( ms * 1000.0 ) );
+        }
+
+        for( int op = COPY_RAW; op <= COPY_MAX; op++ )
+        {
+            prof_counter cnt;
+
+            prof_start( &cnt );
+
+            for( int i = 0; i < BENCH_ITERATIONS; i++ )
+                imgOut.CopyFull( &imgA, &imgB, (E_IMAGE_OP) op );
+
+            prof_end( &cnt );
+
+            const double ms = cnt.msecs() / BENCH_ITERATIONS;
+
+            printf( "%-12s COPY_%-11s %10.3f %10.1f\n", sizeName, copyOpNames[op], ms,
+                    ( (double) w * h ) / ( ms * 1000.0 ) );
+        }
+    }
+
+    return 0;
+}
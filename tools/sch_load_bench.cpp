@@ -0,0 +1,343 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sch_load_bench.cpp
+ * @brief Measures the token parsers of the legacy schematic and symbol library plugin.
+ *
+ * Usage: sch_load_bench [file.sch|file.lib ...]
+ *
+ * Every line of the files is read with FILE_LINE_READER and split with the
+ * sch_legacy_tokenizer.h functions used by SCH_LEGACY_PLUGIN: integers with parseInt,
+ * quoted strings with parseQuotedString and the other tokens with parseToken.
+ * The sub-sheets of a schematic are read too, so the whole hierarchy is measured.
+ * Without arguments a synthetic hierarchy of SYNTH_SHEETS sheets and a library of
+ * SYNTH_PARTS symbols are generated and used.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <wx/filename.h>
+
+#include <profile.h>
+#include <richio.h>
+#include <sch_legacy_tokenizer.h>
+
+
+#define BENCH_ITERATIONS    3
+#define SYNTH_SHEETS        200
+#define SYNTH_COMPONENTS    400     // per sheet
+#define SYNTH_PARTS         5000
+
+
+struct SCAN_STATS
+{
+    double  m_MB;
+    long    m_lines;
+    long    m_ints;
+    long    m_strings;
+    long    m_tokens;
+};
+
+
+static bool writeSyntheticSheet( const wxString& aFileName, const wxString& aSheetPrefix,
+                                 int aSubSheets )
+{
+    FILE* fp = wxFopen( aFileName, "w" );
+
+    if( !fp )
+        return false;
+
+    fprintf( fp, "EESchema Schematic File Version 2\nLIBS:bench\nEELAYER 25 0\nEELAYER END\n" );
+    fprintf( fp, "$Descr A4 11693 8268\nencoding utf-8\nSheet 1 1\nTitle \"bench\"\n"
+                 "Date \"\"\nRev \"\"\nComp \"\"\n$EndDescr\n" );
+
+    for( int i = 0; i < aSubSheets; ++i )
+    {
+        fprintf( fp, "$Sheet\nS %d 500 1000 1000\nU %08X\n", 500 + i * 1200, 0x58000000 + i );
+        fprintf( fp, "F0 \"Sheet %d\" 60\nF1 \"%s%d.sch\" 60\n", i,
+                 (const char*) aSheetPrefix.ToUTF8(), i );
+        fprintf( fp, "F2 \"DATA[0..7]\" B L %d 600 60 \n$EndSheet\n", 500 + i * 1200 );
+    }
+
+    for( int i = 0; i < SYNTH_COMPONENTS; ++i )
+    {
+        int x = 1000 + ( i % 20 ) * 400;
+        int y = 1000 + ( i / 20 ) * 300;
+
+        fprintf( fp, "$Comp\nL R R%d\nU 1 1 %08X\nP %d %d\n", i + 1, 0x59000000 + i, x, y );
+        fprintf( fp, "F 0 \"R%d\" V %d %d 50  0000 C CNN\n", i + 1, x + 80, y );
+        fprintf( fp, "F 1 \"%dk\" V %d %d 50  0000 C CNN\n", i % 100 + 1, x, y );
+        fprintf( fp, "F 2 \"Resistors:R_0805\" V %d %d 50  0001 C CNN\n", x - 70, y );
+        fprintf( fp, "F 3 \"\" H %d %d 50  0000 C CNN\n", x, y );
+        fprintf( fp, "\t1    %d %d\n\t1    0    0    -1  \n$EndComp\n", x, y );
+        fprintf( fp, "Wire Wire Line\n\t%d %d %d %d\n", x, y + 150, x, y + 300 );
+        fprintf( fp, "Connection ~ %d %d\n", x, y + 300 );
+        fprintf( fp, "Text Label %d %d 0    60   ~ 0\nNET%d\n", x, y + 300, i / 4 );
+    }
+
+    fprintf( fp, "$EndSCHEMATC\n" );
+    fclose( fp );
+
+    return true;
+}
+
+
+static bool writeSyntheticLibrary( const wxString& aFileName )
+{
+    FILE* fp = wxFopen( aFileName, "w" );
+
+    if( !fp )
+        return false;
+
+    fprintf( fp, "EESchema-LIBRARY Version 2.3\n#encoding utf-8\n" );
+
+    for( int i = 0; i < SYNTH_PARTS; ++i )
+    {
+        fprintf( fp, "#\n# PART%d\n#\nDEF PART%d U 0 40 Y Y 1 F N\n", i, i );
+        fprintf( fp, "F0 \"U\" -300 650 50 H V C CNN\nF1 \"PART%d\" 0 650 50 H V C CNN\n", i );
+        fprintf( fp, "F2 \"\" 0 0 50 H I C CNN\nF3 \"\" 0 0 50 H I C CNN\n" );
+        fprintf( fp, "DRAW\nS -300 600 300 -600 0 1 10 f\n" );
+
+        for( int pin = 0; pin < 24; ++pin )
+        {
+            fprintf( fp, "X IO%d %d %d %d 200 %c 50 50 1 1 B\n", pin, pin + 1,
+                     pin < 12 ? -500 : 500, 550 - ( pin % 12 ) * 100, pin < 12 ? 'R' : 'L' );
+        }
+
+        fprintf( fp, "ENDDRAW\nENDDEF\n" );
+    }
+
+    fprintf( fp, "#\n#End Library\n" );
+    fclose( fp );
+
+    return true;
+}
+
+
+// true if aLine starts a quoted string closed on the same line
+static bool isQuotedString( const char* aLine )
+{
+    if( *aLine != '"' )
+        return false;
+
+    for( const char* tmp = aLine + 1; *tmp; ++tmp )
+    {
+        if( *tmp == '\\' && tmp[1] )
+            ++tmp;
+        else if( *tmp == '"' )
+            return true;
+    }
+
+    return false;
+}
+
+
+// splits every line of aFileName into tokens and appends the sub-sheet file names
+// of a schematic to aSheetFiles
+static void scanFile( const wxString& aFileName, SCAN_STATS& aStats,
+                      std::vector< wxString >* aSheetFiles )
+{
+    FILE_LINE_READER reader( aFileName );
+    wxString text;
+    bool inSheet = false;
+
+    while( const char* line = reader.ReadLine() )
+    {
+        aStats.m_lines++;
+
+        if( aSheetFiles )
+        {
+            if( strCompare( "$Sheet", line ) )
+                inSheet = true;
+            else if( strCompare( "$EndSheet", line ) )
+                inSheet = false;
+            else if( inSheet && strCompare( "F1", line, &line ) )
+            {
+                parseQuotedString( text, reader, line, &line );
+                aSheetFiles->push_back( text );
+                aStats.m_strings++;
+            }
+        }
+
+        while( *line && isspace( *line ) )
+            line++;
+
+        while( *line )
+        {
+            if( isdigit( *line ) || ( *line == '-' && isdigit( line[1] ) ) )
+            {
+                const char* prev = line;
+
+                parseInt( reader, line, &line );
+                aStats.m_ints++;
+
+                if( line != prev )
+                    continue;
+            }
+
+            if( isQuotedString( line ) )
+            {
+                parseQuotedString( text, reader, line, &line, true );
+                aStats.m_strings++;
+            }
+            else
+            {
+                const char* token;
+
+                if( !parseToken( reader, line, &token, &line, true ) )
+                    break;
+
+                aStats.m_tokens++;
+            }
+        }
+    }
+
+    aStats.m_MB += wxFileName( aFileName ).GetSize().ToDouble() / ( 1024.0 * 1024.0 );
+}
+
+
+// scans aFileName and, for a schematic, its sub-sheets (each file once)
+static void scanHierarchy( const wxString& aFileName, SCAN_STATS& aStats )
+{
+    wxFileName fn( aFileName );
+    bool isSchematic = fn.GetExt() == "sch";
+    std::vector< wxString > files( 1, fn.GetFullPath() );
+    std::set< wxString > done;
+
+    while( !files.empty() )
+    {
+        wxFileName sheet( files.back() );
+        std::vector< wxString > subSheets;
+
+        files.pop_back();
+
+        if( !sheet.IsAbsolute() )
+            sheet.MakeAbsolute( fn.GetPath() );
+
+        if( !done.insert( sheet.GetFullPath() ).second )
+            continue;
+
+        scanFile( sheet.GetFullPath(), aStats, isSchematic ? &subSheets : NULL );
+        files.insert( files.end(), subSheets.begin(), subSheets.end() );
+    }
+}
+
+
+int main( int argc, char** argv )
+{
+    std::vector< wxString > files;
+    std::vector< wxString > synth;
+
+    for( int i = 1; i < argc; ++i )
+        files.push_back( wxString::FromUTF8( argv[i] ) );
+
+    if( files.empty() )
+    {
+        wxFileName base( wxFileName::CreateTempFileName( "schbench" ) );
+        wxString   prefix = base.GetName() + "_sheet";
+
+        synth.push_back( base.GetFullPath() );      // created by CreateTempFileName()
+
+        base.SetExt( "sch" );
+        synth.push_back( base.GetFullPath() );
+        bool ok = writeSyntheticSheet( base.GetFullPath(), prefix, SYNTH_SHEETS );
+
+        for( int i = 0; i < SYNTH_SHEETS && ok; ++i )
+        {
+            wxFileName sheet( base.GetPath(), wxString::Format( "%s%d.sch", prefix, i ) );
+
+            synth.push_back( sheet.GetFullPath() );
+            ok = writeSyntheticSheet( sheet.GetFullPath(), prefix, 0 );
+        }
+
+        base.SetExt( "lib" );
+        synth.push_back( base.GetFullPath() );
+        ok = ok && writeSyntheticLibrary( base.GetFullPath() );
+
+        if( !ok )
+        {
+            fprintf( stderr, "cannot write the synthetic files\n" );
+
+            for( unsigned int i = 0; i < synth.size(); ++i )
+                wxRemoveFile( synth[i] );
+
+            return 1;
+        }
+
+        files.push_back( synth[1] );
+        files.push_back( base.GetFullPath() );
+    }
+
+    printf( "%-40s %10s %10s %10s %10s %10s %10s %10s\n", "file", "MB", "lines", "ints",
+            "strings", "tokens", "ms", "MB/s" );
+
+    for( unsigned int f = 0; f < files.size(); ++f )
+    {
+        wxFileName fn( files[f] );
+        SCAN_STATS stats;
+        bool ok = true;
+        prof_counter cnt;
+
+        prof_start( &cnt );
+
+        for( int i = 0; i < BENCH_ITERATIONS && ok; ++i )
+        {
+            memset( &stats, 0, sizeof( stats ) );
+
+            try
+            {
+                scanHierarchy( fn.GetFullPath(), stats );
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                fprintf( stderr, "%s\n", (const char*) ioe.What().ToUTF8() );
+                ok = false;
+            }
+        }
+
+        prof_end( &cnt );
+
+        if( !ok )
+        {
+            printf( "%-40s failed\n", fn.GetFullName().ToUTF8().data() );
+            continue;
+        }
+
+        const double ms = cnt.msecs() / BENCH_ITERATIONS;
+
+        printf( "%-40s %10.1f %10ld %10ld %10ld %10ld %10.1f %10.2f\n",
+                fn.GetFullName().ToUTF8().data(), stats.m_MB, stats.m_lines, stats.m_ints,
+                stats.m_strings, stats.m_tokens, ms, stats.m_MB / ( ms / 1000.0 ) );
+    }
+
+    for( unsigned int i = 0; i < synth.size(); ++i )
+        wxRemoveFile( synth[i] );
+
+    return 0;
+}
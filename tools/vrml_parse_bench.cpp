@@ -0,0 +1,215 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file vrml_parse_bench.cpp
+ * @brief Measures the WRLPROC numeric field readers used by the VRML plugin.
+ *
+ * Usage: vrml_parse_bench [file.wrl ...]
+ *
+ * Every file is scanned field by field; coordinate, normal and color lists
+ * are read with ReadMFVec3f and index lists with ReadMFInt, which is where
+ * the plugin spends its time on large vendor models. Without arguments a
+ * synthetic VRML2 model with one million vertices is generated and used.
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <wx/filename.h>
+
+#include <profile.h>
+#include <richio.h>
+#include <wrlproc.h>
+
+
+#define BENCH_ITERATIONS    3
+#define SYNTH_VERTICES      1000000
+
+
+static bool writeSyntheticModel( const char* aFileName )
+{
+    FILE* fp = fopen( aFileName, "w" );
+
+    if( !fp )
+        return false;
+
+    srand( 1 );
+
+    fprintf( fp, "#VRML V2.0 utf8\n" );
+    fprintf( fp, "Shape { geometry IndexedFaceSet {\n" );
+    fprintf( fp, "coord Coordinate { point [\n" );
+
+    for( int i = 0; i < SYNTH_VERTICES; ++i )
+        fprintf( fp, "%.6f %.6f %.6f,\n", rand() / (double) RAND_MAX - 0.5,
+                 rand() / (double) RAND_MAX - 0.5, rand() / (double) RAND_MAX * 1e-3 );
+
+    fprintf( fp, "] }\ncoordIndex [\n" );
+
+    for( int i = 0; i + 2 < SYNTH_VERTICES; i += 3 )
+        fprintf( fp, "%d,%d,%d,-1,\n", i, i + 1, i + 2 );
+
+    fprintf( fp, "] } }\n" );
+    fclose( fp );
+
+    return true;
+}
+
+
+// walks the file and reads every numeric list; returns the number of values read
+static long scanModel( WRLPROC& aProc, bool& aOk )
+{
+    std::string glob;
+    std::vector< WRLVEC3F > vec3;
+    std::vector< int > ints;
+    long nValues = 0;
+
+    aOk = true;
+
+    while( true )
+    {
+        char c = aProc.Peek();
+
+        if( 0 == c )
+            break;
+
+        if( '{' == c || '}' == c || '[' == c || ']' == c )
+        {
+            aProc.Pop();
+            continue;
+        }
+
+        if( !aProc.ReadGlob( glob ) )
+            break;
+
+        if( '[' != aProc.Peek() )
+            continue;
+
+        if( glob == "point" || glob == "vector" || glob == "color" )
+        {
+            if( !aProc.ReadMFVec3f( vec3 ) )
+            {
+                aOk = false;
+                break;
+            }
+
+            nValues += 3 * vec3.size();
+        }
+        else if( glob == "coordIndex" || glob == "normalIndex" || glob == "colorIndex" )
+        {
+            if( !aProc.ReadMFInt( ints ) )
+            {
+                aOk = false;
+                break;
+            }
+
+            nValues += ints.size();
+        }
+    }
+
+    return nValues;
+}
+
+
+int main( int argc, char** argv )
+{
+    // the plugin parses with LC_NUMERIC set to "C"
+    setlocale( LC_NUMERIC, "C" );
+
+    std::vector< std::string > files;
+    wxString synth;
+
+    for( int i = 1; i < argc; ++i )
+        files.push_back( argv[i] );
+
+    if( files.empty() )
+    {
+        synth = wxFileName::CreateTempFileName( "vrmlbench" );
+
+        if( synth.empty() || !writeSyntheticModel( synth.ToUTF8() ) )
+        {
+            fprintf( stderr, "cannot write the synthetic model\n" );
+            return 1;
+        }
+
+        files.push_back( std::string( synth.ToUTF8() ) );
+    }
+
+    printf( "%-40s %10s %12s %10s %12s\n", "file", "MB", "values", "ms", "Mvalues/s" );
+
+    for( unsigned int f = 0; f < files.size(); ++f )
+    {
+        wxFileName fn( wxString::FromUTF8( files[f].c_str() ) );
+        double fileMB = fn.GetSize().ToDouble() / ( 1024.0 * 1024.0 );
+        long nValues = 0;
+        bool ok = true;
+        prof_counter cnt;
+
+        prof_start( &cnt );
+
+        for( int i = 0; i < BENCH_ITERATIONS && ok; ++i )
+        {
+            try
+            {
+                FILE_LINE_READER reader( fn.GetFullPath(), 0, 8388608 );
+                WRLPROC proc( &reader );
+
+                if( proc.GetVRMLType() == VRML_INVALID )
+                {
+                    ok = false;
+                    break;
+                }
+
+                nValues = scanModel( proc, ok );
+
+                if( !ok )
+                    fprintf( stderr, "%s\n", proc.GetError().c_str() );
+            }
+            catch( const IO_ERROR& )
+            {
+                ok = false;
+            }
+        }
+
+        prof_end( &cnt );
+
+        if( !ok )
+        {
+            printf( "%-40s failed\n", fn.GetFullName().ToUTF8().data() );
+            continue;
+        }
+
+        const double ms = cnt.msecs() / BENCH_ITERATIONS;
+
+        printf( "%-40s %10.1f %12ld %10.1f %12.2f\n", fn.GetFullName().ToUTF8().data(),
+                fileMB, nValues, ms, nValues / ( ms * 1000.0 ) );
+    }
+
+    if( !synth.empty() )
+        wxRemoveFile( synth );
+
+    return 0;
+}